@@ -0,0 +1,246 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Microbenchmark for util/graph_dom on random control flow graphs.
+   Build with 'make bench_dom'.
+
+   Random edges make the graphs irreducible, loops get entered from more
+   than one block. Before timing, graph_dom_dominates() is checked against
+   a walk up the idom chain for every pair of nodes, and the
+   chain against reachability with the dominator removed. */
+
+#include "util/arena.h"
+#include "util/graph.h"
+#include "util/graph_dom.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct bench_node {
+	graph_node graph;
+	graph_dom_info dom;
+	int mark;
+} bench_node;
+
+static double
+elapsed_ms(clock_t start)
+{
+	return (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+static graph_dom_info *
+get_dom_info(graph_node *n)
+{
+	return &((bench_node *)n)->dom;
+}
+
+/* Node 0 is the start. Every node gets an edge from an earlier node, so
+   all are reachable, plus n_extra edges between random nodes. */
+static bench_node **
+build_cfg(graph_ctx *ctx, unsigned n, unsigned n_extra)
+{
+	bench_node **nodes = calloc(n, sizeof(*nodes));
+	unsigned i;
+
+	for (i = 0; i < n; i++)
+	{
+		nodes[i] = (bench_node *)graph_create_node(ctx, sizeof(bench_node));
+		if (i > 0)
+		{
+			graph_edge_create(ctx, (graph_node *)nodes[rand() % i], (graph_node *)nodes[i], sizeof(graph_edge), NULL);
+		}
+	}
+	for (i = 0; i < n_extra; i++)
+	{
+		graph_edge_create(ctx, (graph_node *)nodes[rand() % n], (graph_node *)nodes[rand() % n], sizeof(graph_edge), NULL);
+	}
+
+	return nodes;
+}
+
+static int
+dominates_by_walk(bench_node *a, bench_node *b)
+{
+	graph_node *n = (graph_node *)b;
+
+	while (n != NULL)
+	{
+		if (n == (graph_node *)a)
+		{
+			return 1;
+		}
+		n = get_dom_info(n)->idom;
+	}
+	return 0;
+}
+
+/* a dominates b iff b can not be reached from the start without passing
+   through a */
+static int
+dominates_by_removal(bench_node **nodes, unsigned n, bench_node *a, bench_node *b)
+{
+	graph_node **stack = malloc(n*sizeof(graph_node *));
+	unsigned i, sp = 0;
+	int reached = 0;
+
+	if (a == b)
+	{
+		free(stack);
+		return 1;
+	}
+	for (i = 0; i < n; i++)
+	{
+		nodes[i]->mark = 0;
+	}
+	if (nodes[0] != a)
+	{
+		nodes[0]->mark = 1;
+		stack[sp++] = (graph_node *)nodes[0];
+	}
+	while (sp > 0)
+	{
+		graph_node *v = stack[--sp];
+		graph_edge *edge;
+
+		reached |= v == (graph_node *)b;
+		for (edge = graph_succ_first(v); edge != NULL; edge = graph_succ_next(edge))
+		{
+			bench_node *w = (bench_node *)graph_edge_head(edge);
+
+			if (w != a && !w->mark)
+			{
+				w->mark = 1;
+				stack[sp++] = (graph_node *)w;
+			}
+		}
+	}
+	free(stack);
+	return !reached;
+}
+
+static void
+check_dominates(bench_node **nodes, unsigned n)
+{
+	unsigned i, j;
+
+	for (i = 0; i < n; i++)
+	{
+		for (j = 0; j < n; j++)
+		{
+			assert(graph_dom_dominates(&nodes[i]->dom, &nodes[j]->dom) == dominates_by_walk(nodes[i], nodes[j]));
+			assert(dominates_by_walk(nodes[i], nodes[j]) == dominates_by_removal(nodes, n, nodes[i], nodes[j]));
+		}
+	}
+}
+
+/* start -> a, start -> b, a <-> b: the textbook irreducible loop, where
+   neither a nor b dominates the other */
+static void
+check_irreducible_loop(void)
+{
+	graph_ctx ctx = {0};
+	bench_node *nodes[3];
+	unsigned i;
+
+	ctx.arena = arena_create();
+	for (i = 0; i < 3; i++)
+	{
+		nodes[i] = (bench_node *)graph_create_node(&ctx, sizeof(bench_node));
+	}
+	graph_edge_create(&ctx, (graph_node *)nodes[0], (graph_node *)nodes[1], sizeof(graph_edge), NULL);
+	graph_edge_create(&ctx, (graph_node *)nodes[0], (graph_node *)nodes[2], sizeof(graph_edge), NULL);
+	graph_edge_create(&ctx, (graph_node *)nodes[1], (graph_node *)nodes[2], sizeof(graph_edge), NULL);
+	graph_edge_create(&ctx, (graph_node *)nodes[2], (graph_node *)nodes[1], sizeof(graph_edge), NULL);
+
+	graph_dom_analyze(&ctx, (graph_node *)nodes[0], 3, get_dom_info);
+	assert(nodes[1]->dom.idom == (graph_node *)nodes[0]);
+	assert(nodes[2]->dom.idom == (graph_node *)nodes[0]);
+	assert(!graph_dom_dominates(&nodes[1]->dom, &nodes[2]->dom));
+	assert(!graph_dom_dominates(&nodes[2]->dom, &nodes[1]->dom));
+	check_dominates(nodes, 3);
+
+	arena_destroy(ctx.arena);
+}
+
+static void
+check_random(unsigned n, unsigned n_extra)
+{
+	graph_ctx ctx = {0};
+	bench_node **nodes;
+
+	ctx.arena = arena_create();
+	nodes = build_cfg(&ctx, n, n_extra);
+	graph_dom_analyze(&ctx, (graph_node *)nodes[0], n, get_dom_info);
+	check_dominates(nodes, n);
+	free(nodes);
+	arena_destroy(ctx.arena);
+}
+
+static void
+bench_cfg(unsigned n)
+{
+	graph_ctx ctx = {0};
+	bench_node **nodes;
+	clock_t start;
+	double t_analyze;
+	unsigned i, n_dominated = 0;
+
+	ctx.arena = arena_create();
+	nodes = build_cfg(&ctx, n, n);
+
+	start = clock();
+	graph_dom_analyze(&ctx, (graph_node *)nodes[0], n, get_dom_info);
+	t_analyze = elapsed_ms(start);
+
+	start = clock();
+	for (i = 0; i < 16 * n; i++)
+	{
+		n_dominated += graph_dom_dominates(&nodes[rand() % n]->dom, &nodes[rand() % n]->dom);
+	}
+
+	printf("n=%-9u analyze %8.2f ms  %u queries %8.2f ms (%u)\n", n, t_analyze, 16 * n, elapsed_ms(start), n_dominated);
+	free(nodes);
+	arena_destroy(ctx.arena);
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned max = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000;
+	unsigned n;
+
+	srand(1);
+	check_irreducible_loop();
+	for (n = 0; n < 100; n++)
+	{
+		check_random(2 + n % 40, n % 60);
+	}
+
+	for (n = 1000; n <= max; n *= 10)
+	{
+		bench_cfg(n);
+	}
+
+	return 0;
+}
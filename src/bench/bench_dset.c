@@ -0,0 +1,124 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Microbenchmark for util/dset. Build with 'make bench_dset'. */
+
+#include "util/dset.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static double
+elapsed_ms(clock_t start)
+{
+	return (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+/* Link x into x+1 for every x, the worst case for plain linking */
+static void
+bench_chain(unsigned n)
+{
+	dset_ctx *d = dset_create_universe(n);
+	clock_t start = clock();
+	unsigned i;
+	long sum = 0;
+
+	for (i = 0; i < n; i++)
+	{
+		dset_makeset(d, i);
+	}
+	for (i = 0; i + 1 < n; i++)
+	{
+		dset_union(d, i, i + 1);
+	}
+	for (i = 0; i < n; i++)
+	{
+		sum += dset_find(d, i);
+	}
+
+	printf("chain   n=%-9u %8.2f ms (%ld)\n", n, elapsed_ms(start), sum);
+	dset_destroy_universe(d);
+}
+
+static void
+bench_random(unsigned n, unsigned ops)
+{
+	dset_ctx *d = dset_create_universe(0);
+	clock_t start = clock();
+	unsigned i;
+	long sum = 0;
+
+	srand(1);
+	dset_grow_universe(d, n);
+	for (i = 0; i < ops; i++)
+	{
+		int x = rand() % n;
+		int y = rand() % n;
+		if (i & 1)
+		{
+			dset_union(d, x, y);
+		}
+		else
+		{
+			sum += dset_find(d, x);
+		}
+	}
+
+	printf("random  n=%-9u %8.2f ms (%ld)\n", n, elapsed_ms(start), sum);
+	dset_destroy_universe(d);
+}
+
+/* Elements added one at a time as the spill allocator does */
+static void
+bench_grow(unsigned n)
+{
+	dset_ctx *d = dset_create_universe(0);
+	clock_t start = clock();
+	unsigned i;
+	long sum = 0;
+
+	for (i = 1; i < n; i++)
+	{
+		dset_grow_universe(d, i + 1);
+		dset_union(d, i, i / 2);
+	}
+	for (i = 0; i < n; i++)
+	{
+		sum += dset_find(d, i);
+	}
+
+	printf("grow    n=%-9u %8.2f ms (%ld)\n", n, elapsed_ms(start), sum);
+	dset_destroy_universe(d);
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned n = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000;
+
+	bench_chain(n);
+	bench_random(n, 4*n);
+	bench_grow(n);
+
+	return 0;
+}
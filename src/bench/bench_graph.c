@@ -0,0 +1,151 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Microbenchmark for util/graph edge insertion on high fan-out nodes.
+   Build with 'make bench_graph'. */
+
+#include "util/arena.h"
+#include "util/graph.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct bench_node {
+	graph_node graph;
+	int key;
+} bench_node;
+
+static double
+elapsed_ms(clock_t start)
+{
+	return (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+static int
+key_cmp(void *a, void *b)
+{
+	return ((bench_node *)a)->key - ((bench_node *)b)->key;
+}
+
+/* Give one hub node n uses and n defs. Keys come in increasing order, as
+   they do when a constant is used by nodes built after it, in decreasing
+   order, or shuffled. The ordered walks at the end pay for any sorting. */
+static void
+bench_fanout(const char *name, unsigned n, int order)
+{
+	graph_ctx ctx = {0};
+	bench_node *hub, **nodes;
+	graph_edge *edge;
+	clock_t start;
+	unsigned i;
+	long sum = 0;
+
+	ctx.arena = arena_create();
+	nodes = calloc(n, sizeof(*nodes));
+	hub = (bench_node *)graph_create_node(&ctx, sizeof(bench_node));
+	hub->key = -1;
+	for (i = 0; i < n; i++)
+	{
+		nodes[i] = (bench_node *)graph_create_node(&ctx, sizeof(bench_node));
+		nodes[i]->key = order > 0 ? i : order < 0 ? n - i : rand() % n;
+	}
+
+	start = clock();
+	for (i = 0; i < n; i++)
+	{
+		graph_edge_create(&ctx, (graph_node *)hub, (graph_node *)nodes[i], sizeof(graph_edge), key_cmp);
+		graph_edge_create(&ctx, (graph_node *)nodes[i], (graph_node *)hub, sizeof(graph_edge), key_cmp);
+	}
+	for (edge = graph_succ_first((graph_node *)hub); edge != NULL; edge = graph_succ_next(edge))
+	{
+		sum += ((bench_node *)graph_edge_head(edge))->key;
+	}
+	for (edge = graph_pred_first((graph_node *)hub); edge != NULL; edge = graph_pred_next(edge))
+	{
+		sum -= ((bench_node *)graph_edge_tail(edge))->key;
+	}
+
+	printf("%-8s n=%-9u %8.2f ms (%ld)\n", name, n, elapsed_ms(start), sum);
+	free(nodes);
+	arena_destroy(ctx.arena);
+}
+
+static bench_node *
+create_node(graph_ctx *ctx, int key)
+{
+	bench_node *n = (bench_node *)graph_create_node(ctx, sizeof(bench_node));
+	n->key = key;
+	return n;
+}
+
+/* Sanity checks for the lazy ordering before timing it. A list that was
+   flagged unordered and then emptied must not be sorted, and parallel
+   edges must come newest first as they did with the eager insert, also
+   when added after the list has been sorted once. */
+static void
+check_lists(void)
+{
+	graph_ctx ctx = {0};
+	graph_node *a, *b, *c;
+	graph_edge *e1, *e2, *e3, *edge;
+
+	ctx.arena = arena_create();
+	a = (graph_node *)create_node(&ctx, 0);
+	b = (graph_node *)create_node(&ctx, 1);
+	c = (graph_node *)create_node(&ctx, 2);
+
+	graph_edge_create(&ctx, a, c, sizeof(graph_edge), key_cmp);
+	graph_edge_create(&ctx, a, b, sizeof(graph_edge), key_cmp);
+	graph_succs_delete(&ctx, a);
+	assert(graph_succ_first(a) == NULL);
+
+	e1 = graph_edge_create(&ctx, a, b, sizeof(graph_edge), key_cmp);
+	e2 = graph_edge_create(&ctx, a, b, sizeof(graph_edge), key_cmp);
+	edge = graph_succ_first(a);
+	assert(edge == e2 && graph_succ_next(edge) == e1);
+	e3 = graph_edge_create(&ctx, a, b, sizeof(graph_edge), key_cmp);
+	edge = graph_succ_first(a);
+	assert(edge == e3 && (edge = graph_succ_next(edge)) == e2 && graph_succ_next(edge) == e1);
+
+	arena_destroy(ctx.arena);
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned max = argc > 1 ? strtoul(argv[1], NULL, 0) : 100000;
+	unsigned n;
+
+	check_lists();
+
+	srand(1);
+	for (n = 10; n <= max; n *= 10)
+	{
+		bench_fanout("inorder", n, 1);
+		bench_fanout("reverse", n, -1);
+		bench_fanout("random", n, 0);
+	}
+
+	return 0;
+}
@@ -0,0 +1,218 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Throughput and memory benchmark for the IR and codegen data structures.
+   Build with 'make bench_ir'.
+
+   A synthetic function is built straight through the IR API. It is a
+   chain of n diamonds updating a local variable, which mem2reg turns into
+   a phi per join block. Liveness is computed on the result, which is then
+   taken through instruction selection, register allocation and emission. Bytes are those handed out
+   by the function arenas and the IR node and cg instruction stores, per IR
+   node and per cg instruction. The latter is given after isel and again
+   after register allocation, which adds its interval and liveness side
+   data. The dominator
+   walks recurse, so chains much past 10000 diamonds need a larger stack. */
+
+#include "ir/ir_tu.h"
+#include "ir/ir_analysis.h"
+#include "ir/ir_bb.h"
+#include "ir/ir_func.h"
+#include "ir/ir_live.h"
+#include "ir/ir_node.h"
+#include "ir/ir_pass_mgr.h"
+#include "ir_passes/mem2reg.h"
+#include "cg/cg_tu.h"
+#include "cg/cg_func.h"
+#include "cg/cg_bb.h"
+#include "cg/cg_instr.h"
+#include "cg/iselect.h"
+#include "cg/regalloc_ssa.h"
+#include "cg/emit.h"
+#include "util/arena.h"
+#include "util/bset.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* The ssa register allocator keeps its phi copies in a fixed table of 1024
+   entries, three per diamond here. Larger functions stop after isel. */
+#define RA_MAX_DIAMONDS 300
+
+static double
+elapsed_ms(clock_t start)
+{
+	return (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+static ir_func *
+build_func(ir_tu *tu, unsigned n_diamonds)
+{
+	ir_type param_types[2] = {i32, i32};
+	ir_func *f = ir_func_build(tu, "bench", i32, 2, param_types);
+	ir_bb *entry = ir_bb_build(f);
+	ir_bb *exit = ir_bb_build(f);
+	ir_bb *bb = entry;
+	ir_node *var, *b;
+	unsigned i;
+
+	var = ir_node_build_alloca(entry, 4, 4);
+	b = ir_node_build_getparam(entry, i32, 1);
+	ir_node_build2(entry, IR_OP_store, i32, var, ir_node_build_getparam(entry, i32, 0));
+
+	for (i = 0; i < n_diamonds; i++)
+	{
+		ir_bb *then_bb = ir_bb_build(f);
+		ir_bb *else_bb = ir_bb_build(f);
+		ir_bb *join_bb = ir_bb_build(f);
+		ir_node *x, *y, *cond;
+
+		x = ir_node_build1(bb, IR_OP_load, i32, var);
+		x = ir_node_build2(bb, IR_OP_add, i32, x, ir_node_build_const(bb, i32, i));
+		y = ir_node_build2(bb, IR_OP_mul, i32, x, b);
+		cond = ir_node_build2(bb, IR_OP_icmp_slt, i32, y, ir_node_build_const(bb, i32, 1000));
+		ir_bb_build_cond_br(bb, cond, then_bb, else_bb);
+
+		ir_node_build2(then_bb, IR_OP_store, i32, var,
+		               ir_node_build2(then_bb, IR_OP_add, i32, y, ir_node_build_const(then_bb, i32, 1)));
+		ir_bb_build_br(then_bb, join_bb);
+
+		ir_node_build2(else_bb, IR_OP_store, i32, var,
+		               ir_node_build2(else_bb, IR_OP_xor, i32, x, b));
+		ir_bb_build_br(else_bb, join_bb);
+
+		bb = join_bb;
+	}
+
+	ir_bb_build_br(bb, exit);
+	ir_bb_build_value_ret(exit, ir_node_build1(exit, IR_OP_load, i32, var));
+
+	return f;
+}
+
+/* Linked instructions, phis not included */
+static unsigned
+count_instrs(cg_func *cf)
+{
+	unsigned n_instrs = 0;
+	cg_bb *cb;
+
+	for (cb = cf->bb_first; cb != NULL; cb = cb->bb_next)
+	{
+		cg_instr *instr;
+		for (instr = cg_instr_first(cb); instr != NULL; instr = cg_instr_next(instr))
+		{
+			n_instrs++;
+		}
+	}
+
+	return n_instrs;
+}
+
+static void
+bench_func(unsigned n_diamonds, ir_pipeline *pl, FILE *out)
+{
+	ir_tu *tu = calloc(1, sizeof(ir_tu));
+	cg_tu *ctu = cg_tu_build();
+	arena_usage ir_usage, isel_usage = {0}, cg_usage = {0};
+	ir_func *f;
+	cg_func *cf;
+	clock_t start;
+	double t_build, t_pass, t_live, t_isel, t_ra = 0, t_emit = 0;
+	unsigned n_nodes, n_isel_instrs, n_instrs;
+
+	start = clock();
+	f = build_func(tu, n_diamonds);
+	t_build = elapsed_ms(start);
+
+	start = clock();
+	ir_pipeline_run_func(pl, f);
+	t_pass = elapsed_ms(start);
+	n_nodes = f->n_ir_nodes;
+	ir_func_get_usage(f, &ir_usage);
+
+	start = clock();
+	ir_analysis_require(f, IR_ANALYSIS(IR_ANALYSIS_LIVENESS));
+	t_live = elapsed_ms(start);
+	/* Only the phi of the last join reaches the return */
+	assert(bset_count(ir_live_in(f->entry)) == 0);
+	assert(bset_count(ir_live_in(f->exit)) == 1);
+
+	start = clock();
+	cf = cg_iselect_func(ctu, f);
+	t_isel = elapsed_ms(start);
+	ir_func_destroy(f);
+	n_isel_instrs = count_instrs(cf);
+	cg_func_get_usage(cf, &isel_usage);
+
+	if (n_diamonds <= RA_MAX_DIAMONDS)
+	{
+		start = clock();
+		cg_regalloc_ssa_func(cf, 8);
+		t_ra = elapsed_ms(start);
+
+		start = clock();
+		cg_emit_func(out, cf);
+		t_emit = elapsed_ms(start);
+	}
+
+	n_instrs = count_instrs(cf);
+	cg_func_get_usage(cf, &cg_usage);
+
+	printf("n=%-7u nodes=%-8u build %7.2f mem2reg %7.2f live %7.2f isel %7.2f ra %8.2f emit %7.2f ms"
+	       "  %5.1f B/node %5.1f B/instr isel %5.1f ra\n",
+	       n_diamonds, n_nodes, t_build, t_pass, t_live, t_isel, t_ra, t_emit,
+	       (double)ir_usage.n_bytes / n_nodes, (double)isel_usage.n_bytes / n_isel_instrs,
+	       (double)cg_usage.n_bytes / n_instrs);
+
+	cg_func_destroy(ctu, cf);
+	cg_tu_destroy(ctu);
+	ir_tu_destroy(tu);
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned max = argc > 1 ? strtoul(argv[1], NULL, 0) : 10000;
+	FILE *out = fopen("/dev/null", "w");
+	ir_pipeline *pl;
+	unsigned n;
+
+	ir_pass_register(&mem2reg);
+	pl = ir_pipeline_parse("mem2reg");
+
+	for (n = 10; n <= max; n *= 10)
+	{
+		bench_func(n, pl, out);
+		if (n * 3 <= max && n * 3 <= RA_MAX_DIAMONDS)
+		{
+			bench_func(n * 3, pl, out);
+		}
+	}
+
+	ir_pipeline_destroy(pl);
+	fclose(out);
+
+	return 0;
+}
@@ -0,0 +1,121 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Benchmark for the interval sets used as live ranges by the register
+   allocator. Build with 'make bench_lifetime'.
+
+   A synthetic function with n_blocks blocks is simulated where every
+   block defines a number of short lived values and a few values that
+   live across many blocks. Each value is then greedily assigned to one
+   of a fixed number of registers the same way assign_color() does it,
+   i.e. an intersection test followed by a union into the register. */
+
+#include "cg/lifetime.h"
+#include "util/arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define N_REGS 12
+
+static struct pos
+pos_make(int bpos, int ipos)
+{
+	struct pos p = {bpos, ipos};
+	return p;
+}
+
+static double
+elapsed_ms(clock_t start)
+{
+	return (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+static void
+bench_color(unsigned n_blocks, unsigned n_per_block)
+{
+	arena *ar = arena_create();
+	interval_alloc alloc;
+	interval_set regs[N_REGS];
+	interval_set value;
+	clock_t start;
+	unsigned b, v, n_colored = 0, n_ivals = 0;
+
+	interval_alloc_init(&alloc, ar);
+	memset(regs, 0, sizeof(regs));
+	memset(&value, 0, sizeof(value));
+	srand(1);
+
+	start = clock();
+	for (b = 0; b < n_blocks; b++)
+	{
+		for (v = 0; v < n_per_block; v++)
+		{
+			unsigned r;
+			int from = (rand() % 64) * 4;
+
+			if (v == 0 && b + 8 < n_blocks)
+			{
+				/* Long lived value spanning several blocks */
+				(void)interval_set_add(&alloc, &value, pos_make(b, from), pos_make(b, IPOS_POSINF));
+				(void)interval_set_add(&alloc, &value, pos_make(b + 1, IPOS_NEGINF), pos_make(b + 8, 0));
+			}
+			else
+			{
+				(void)interval_set_add(&alloc, &value, pos_make(b, from), pos_make(b, from + 4 + (rand() % 8) * 4));
+			}
+
+			for (r = 0; r < N_REGS; r++)
+			{
+				if (!interval_set_intersects(&regs[r], &value))
+				{
+					interval_set_union(&alloc, &regs[r], &value);
+					n_colored++;
+					break;
+				}
+			}
+			interval_set_clear(&alloc, &value);
+		}
+	}
+
+	for (v = 0; v < N_REGS; v++)
+	{
+		n_ivals += regs[v].n_ivals;
+	}
+
+	printf("color   blocks=%-7u values=%-9u %8.2f ms (colored %u, %u intervals)\n",
+	       n_blocks, n_blocks*n_per_block, elapsed_ms(start), n_colored, n_ivals);
+	arena_destroy(ar);
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned n_blocks = argc > 1 ? strtoul(argv[1], NULL, 0) : 20000;
+
+	bench_color(n_blocks / 10, 16);
+	bench_color(n_blocks, 16);
+
+	return 0;
+}
@@ -0,0 +1,151 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Parse throughput of the reentrant frontend across threads. Build with
+   'make bench_parse'.
+
+   A synthetic translation unit with n_funcs functions is generated in
+   memory and parsed n_files times, spread over 1, 2, 4, ... threads with
+   a parse context of its own for each file. */
+
+#include "frontend/parse_ctx.h"
+#include "util/thread_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct parse_job {
+	const char *text;
+	size_t size;
+	int failed;
+};
+
+static double
+elapsed_ms(struct timespec *start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1000.0 + (now.tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+static char *
+gen_source(unsigned n_funcs, size_t *size)
+{
+	char *text;
+	FILE *fp = open_memstream(&text, size);
+	unsigned i;
+
+	fprintf(fp, "typedef int word;\n");
+	fprintf(fp, "int table[64];\n");
+	for (i = 0; i < n_funcs; i++)
+	{
+		fprintf(fp, "word func%u(word a, word *p)\n", i);
+		fprintf(fp, "{\n");
+		fprintf(fp, "\tword i, sum = 0;\n");
+		fprintf(fp, "\tfor (i = 0; i < a; i++)\n");
+		fprintf(fp, "\t{\n");
+		fprintf(fp, "\t\tif (p[i] > %u && (i & 1) == 0)\n", i);
+		fprintf(fp, "\t\t\tsum = sum + p[i] * table[i & 63];\n");
+		fprintf(fp, "\t\telse\n");
+		fprintf(fp, "\t\t\tsum = sum - (p[i] << 2);\n");
+		fprintf(fp, "\t}\n");
+		fprintf(fp, "\twhile (sum > 1000)\n");
+		fprintf(fp, "\t\tsum = sum / 2;\n");
+		fprintf(fp, "\treturn sum + a * %u;\n", i);
+		fprintf(fp, "}\n");
+	}
+	fclose(fp);
+
+	return text;
+}
+
+static void
+parse_one(void *item, unsigned thread_idx, void *user)
+{
+	struct parse_job *job = item;
+	parse_ctx *ctx = parse_ctx_create();
+	FILE *in = fmemopen((void *)job->text, job->size, "r");
+
+	(void)thread_idx;
+	(void)user;
+	job->failed = parse_file(ctx, in) == NULL;
+	fclose(in);
+	parse_ctx_destroy(ctx);
+}
+
+static void
+bench_parse(const char *text, size_t size, unsigned n_files, unsigned n_threads, double *base_ms)
+{
+	struct parse_job *jobs = calloc(n_files, sizeof(*jobs));
+	void **items = calloc(n_files, sizeof(*items));
+	struct timespec start;
+	unsigned i, n_failed = 0;
+	double ms;
+
+	for (i = 0; i < n_files; i++)
+	{
+		jobs[i].text = text;
+		jobs[i].size = size;
+		items[i] = &jobs[i];
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	thread_pool_run(n_threads, items, n_files, parse_one, NULL);
+	ms = elapsed_ms(&start);
+
+	for (i = 0; i < n_files; i++)
+	{
+		n_failed += jobs[i].failed;
+	}
+	if (*base_ms == 0)
+	{
+		*base_ms = ms;
+	}
+
+	printf("parse   threads=%-3u files=%-5u %8.2f ms %8.2f MB/s  speedup %.2fx%s\n",
+	       n_threads, n_files, ms, (double)size * n_files / (ms * 1000.0),
+	       *base_ms / ms, n_failed ? "  (parse errors)" : "");
+	free(items);
+	free(jobs);
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned max_threads = argc > 1 ? strtoul(argv[1], NULL, 0) : 8;
+	unsigned n_files = argc > 2 ? strtoul(argv[2], NULL, 0) : 64;
+	unsigned n_funcs = argc > 3 ? strtoul(argv[3], NULL, 0) : 200;
+	double base_ms = 0;
+	size_t size;
+	char *text = gen_source(n_funcs, &size);
+	unsigned n;
+
+	for (n = 1; n <= max_threads; n *= 2)
+	{
+		bench_parse(text, size, n_files, n, &base_ms);
+	}
+
+	free(text);
+	return 0;
+}
@@ -28,6 +28,7 @@
 
 #include "cg_tu.h"
 #include "cg_func.h"
+#include "cg_analysis.h"
 #include "cg_bb.h"
 #include "cg_instr.h"
 #include "cg_reg.h"
@@ -97,7 +98,7 @@ can_predicate_block(cg_bb *b)
 {
 	cg_instr *instr;
 
-	for (instr = b->instr_first; instr != NULL; instr = instr->instr_next)
+	for (instr = cg_instr_first(b); instr != NULL; instr = cg_instr_next(instr))
 	{
 		switch (instr->op)
 		{
@@ -132,12 +133,12 @@ move_and_conditionalize(cg_bb *to, cg_bb *from, cg_cond cond)
 {
 	cg_instr *instr, *next_instr;
 
-	for (instr = from->instr_first; instr != NULL; instr = next_instr)
+	for (instr = cg_instr_first(from); instr != NULL; instr = next_instr)
 	{
-		next_instr = instr->instr_next;
+		next_instr = cg_instr_next(instr);
 		cg_instr_unlink(instr);
 
-		instr->bb = to;
+		cg_instr_set_bb(instr, to);
 		instr->cond = cond;
 		cg_instr_link_last(instr);
 	}
@@ -291,8 +292,8 @@ try_pattern_3(cg_bb *bb)
 	return 1;
 }
 
-static void
-branch_predication_func(cg_func *func)
+void
+cg_branch_predication_func(cg_func *func)
 {
 	cg_bb *bb;
 
@@ -311,6 +312,9 @@ branch_predication_func(cg_func *func)
 			continue;
 		}
 	}
+
+	/* Blocks have been merged away */
+	cg_analysis_preserve(func, CG_ANALYSES_NONE);
 }
 
 void
@@ -320,7 +324,7 @@ cg_branch_predication_tu(cg_tu *tu)
 
 	for (f = tu->func_first; f != NULL; f = f->func_next)
 	{
-		branch_predication_func(f);
+		cg_branch_predication_func(f);
 	}
 }
 
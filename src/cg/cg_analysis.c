@@ -0,0 +1,102 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "cg/cg_analysis.h"
+#include "cg/cg_bb.h"
+#include "cg/cg_dom.h"
+#include "cg/cg_func.h"
+#include "cg/cg_live.h"
+#include "util/graph_loop.h"
+#include <stddef.h>
+
+static void
+comp_domtree(void *unit)
+{
+	cg_dom_setup_dom_info(unit);
+}
+
+static void
+destroy_domtree(void *unit)
+{
+	cg_dom_destroy_dom_info(unit);
+}
+
+static graph_loop_bb_info *
+get_bb_loop_info(graph_node *b)
+{
+	return &((cg_bb *)b)->loop_info;
+}
+
+static void
+comp_loops(void *unit)
+{
+	cg_func *func = unit;
+
+	graph_loop_analyze(&func->cfg_graph_ctx,
+	                   (graph_node *)func->bb_first,
+	                   func->n_bbs,
+	                   get_bb_loop_info);
+}
+
+static void
+comp_liveness(void *unit)
+{
+	cg_live_setup(unit);
+}
+
+static void
+destroy_liveness(void *unit)
+{
+	cg_live_destroy(unit);
+}
+
+/* Graph 0 is the cfg and graph 1 the vreg graph */
+static const analysis_desc descs[CG_N_ANALYSES] = {
+	[CG_ANALYSIS_DOMTREE] = {"domtree", 1, 0, comp_domtree, destroy_domtree},
+	[CG_ANALYSIS_LOOPS] = {"loops", 1, 0, comp_loops, NULL},
+	[CG_ANALYSIS_LIVENESS] = {"liveness", 3, 0, comp_liveness, destroy_liveness},
+};
+
+void
+cg_analysis_init(cg_func *func)
+{
+	analysis_mgr_init(&func->analyses, descs, CG_N_ANALYSES, &func->cfg_graph_ctx, &func->vreg_graph_ctx);
+}
+
+void
+cg_analysis_require(cg_func *func, unsigned mask)
+{
+	analysis_require(&func->analyses, func, mask);
+}
+
+void
+cg_analysis_preserve(cg_func *func, unsigned mask)
+{
+	analysis_preserve(&func->analyses, func, mask);
+}
+
+void
+cg_analysis_invalidate(cg_func *func, unsigned mask)
+{
+	analysis_invalidate(&func->analyses, func, mask);
+}
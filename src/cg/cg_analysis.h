@@ -0,0 +1,55 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef CG_ANALYSIS_H
+#define CG_ANALYSIS_H
+
+#include "cg/cg.h"
+
+/* Analyses kept by the cg_func analysis manager, dependencies first */
+typedef enum cg_analysis {
+	CG_ANALYSIS_DOMTREE,
+	CG_ANALYSIS_LOOPS,
+	CG_ANALYSIS_LIVENESS,
+	CG_N_ANALYSES
+} cg_analysis;
+
+#define CG_ANALYSIS(x) (1U << (x))
+#define CG_ANALYSES_NONE 0
+#define CG_ANALYSES_ALL (CG_ANALYSIS(CG_N_ANALYSES) - 1)
+/* Computed from the cfg alone, kept when only instructions change */
+#define CG_ANALYSES_CFG (CG_ANALYSES_ALL & ~CG_ANALYSIS(CG_ANALYSIS_LIVENESS))
+
+void
+cg_analysis_init(cg_func *func);
+
+void
+cg_analysis_require(cg_func *func, unsigned mask);
+
+void
+cg_analysis_preserve(cg_func *func, unsigned mask);
+
+void
+cg_analysis_invalidate(cg_func *func, unsigned mask);
+
+#endif
@@ -26,13 +26,16 @@
 
 #include "cg_bb.h"
 #include "cg_func.h"
+#include "cg_analysis.h"
+#include "cg_instr.h"
 
 cg_bb *
 cg_bb_build(cg_func *func)
 {
-	cg_bb *bb = calloc(1, sizeof(cg_bb));
+	cg_bb *bb = (cg_bb *)graph_create_node(&func->cfg_graph_ctx, sizeof(cg_bb));
 	bb->func = func;
 	bb->id = func->n_bbs++;
+	cg_instr_store_add_bb(func->instr_store, bb);
 	return bb;
 }
 
@@ -142,7 +145,7 @@ cg_bb_loop_nest(cg_bb *bb)
 	unsigned nest = bb->loop_info.type == GRAPH_LOOP_HEADER ? 1 : 0;
 
 	/* Will only do work if needed */
-	cg_func_analyze_loops(f);
+	cg_analysis_require(f, CG_ANALYSIS(CG_ANALYSIS_LOOPS));
 
 	n = bb->loop_info.header;
 	while (n != NULL)
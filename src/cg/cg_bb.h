@@ -27,7 +27,6 @@
 /* contains an ordered list of cg_instr. Otherwise similar to ir_bb */
 #include "cg/cg.h"
 #include "cg/cg_cond.h"
-#include "util/bset.h"
 #include "util/graph.h"
 #include "util/graph_loop.h"
 #include "cg/lifetime.h"
@@ -42,11 +41,12 @@ struct cg_bb {
 	struct cg_bb *bb_prev;
 	struct cg_bb *bb_next;
 
-	struct cg_instr *instr_phi_first;
-	struct cg_instr *instr_phi_last;
+	/* slots, see cg_instr_first() */
+	unsigned instr_phi_first;
+	unsigned instr_phi_last;
 
-	struct cg_instr *instr_first;
-	struct cg_instr *instr_last;
+	unsigned instr_first;
+	unsigned instr_last;
 
 	struct cg_dom_info *dom_info;
 
@@ -58,14 +58,14 @@ struct cg_bb {
 	unsigned n_instrs;
 
 	struct {
-		bset_set *livein;
 		struct pos ival_from;
 		struct pos ival_to;
 		int po;
-		unsigned domtree_po;
 	} ra;
 
 	struct graph_loop_bb_info loop_info;
+	struct bset_set *live_in; /* by vreg, see cg_live.h */
+	struct bset_set *live_out;
 };
 
 cg_bb *
@@ -24,89 +24,35 @@
 #include "cg/cg_dom.h"
 #include "cg/cg_bb.h"
 #include "cg/cg_func.h"
+#include "util/arena.h"
+#include "util/graph_dom.h"
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
 
 #define D(x)
 
-static cg_dom_info * intersect(cg_bb *b1, cg_bb *b2)
+static graph_dom_info *get_dom_info(graph_node *n)
 {
-	cg_dom_info *finger1 = b1->dom_info;
-	cg_dom_info *finger2 = b2->dom_info;
-
-	while (finger1 != finger2)
-	{
-		while (finger1->po < finger2->po)
-		{
-			finger1 = finger1->idom;
-		}
-
-		while (finger2->po < finger1->po)
-		{
-			finger2 = finger2->idom;
-		}
-	}
-
-	return finger1;
+	return &((cg_bb *)n)->dom_info->dom;
 }
 
 static void cg_dom_comp_idom(cg_func *func)
 {
 	cg_bb *b;
-	unsigned po = func->n_bbs;
-	int changed;
 
 	for (b = func->bb_first; b != NULL; b = b->bb_next)
 	{
-		b->dom_info = calloc(1, sizeof(cg_dom_info));
+		b->dom_info = arena_alloc(func->arena, sizeof(cg_dom_info));
 		b->dom_info->bb = b;
-		b->dom_info->po = --po;
 	}
 
-	func->bb_first->dom_info->idom = func->bb_first->dom_info;
+	graph_dom_analyze(&func->cfg_graph_ctx, (graph_node *)func->bb_first, func->n_bbs, get_dom_info);
 
-	changed = 1;
-	while (changed)
+	for (b = func->bb_first; b != NULL; b = b->bb_next)
 	{
-		changed = 0;
-
-		for (b = func->bb_first->bb_next; b != NULL; b = b->bb_next) /* skip entry block */
-		{
-			graph_edge *edge;
-			cg_dom_info *new_idom;
-
-			for (edge = graph_pred_first((graph_node *)b);
-				 edge != NULL;
-				 edge = graph_pred_next(edge))
-			{
-				cg_bb *p = (cg_bb *)graph_edge_tail(edge);
-				if (p->dom_info->idom != NULL)
-				{
-					new_idom = p->dom_info;
-					break;
-				}
-			}
-
-			assert(new_idom->idom != NULL);
-
-			for (edge = graph_pred_first((graph_node *)b);
-				 edge != NULL;
-				 edge = graph_pred_next(edge))
-			{
-				cg_bb *p = (cg_bb *)graph_edge_tail(edge);
-				if (p->dom_info != new_idom && p->dom_info->idom != NULL)
-				{
-					new_idom = intersect(p, new_idom->bb);
-				}
-			}
-
-			if (b->dom_info->idom != new_idom)
-			{
-				b->dom_info->idom = new_idom;
-				changed = 1;
-			}
-		}
+		cg_bb *idom = (cg_bb *)b->dom_info->dom.idom;
+		b->dom_info->idom = idom != NULL ? idom->dom_info : b->dom_info;
 	}
 }
 
@@ -117,7 +63,7 @@ static void cg_dom_comp_domtree(cg_func *func)
 	for (b = func->bb_first->bb_next; b != NULL; b = b->bb_next) /* skip entry block */
 	{
 		cg_dom_info *idom = b->dom_info->idom;
-		cg_dom_info_lst *lst = calloc(1, sizeof(cg_dom_info_lst));
+		cg_dom_info_lst *lst = arena_alloc(func->arena, sizeof(cg_dom_info_lst));
 		lst->next = idom->domtree_children;
 		idom->domtree_children = lst;
 		lst->info = b->dom_info;
@@ -136,14 +82,19 @@ void cg_dom_setup_dom_info(cg_func *func)
 	cg_dom_print_domtree(stdout, func);
 }
 
+int cg_dom_dominates(cg_bb *a, cg_bb *b)
+{
+	return graph_dom_dominates(&a->dom_info->dom, &b->dom_info->dom);
+}
+
 void cg_dom_destroy_dom_info(cg_func *func)
 {
 	cg_bb *b;
 
 	for (b = func->bb_first; b != NULL; b = b->bb_next)
 	{
-		assert(b->dom_info != NULL);
-		free(b->dom_info);
+		/* Memory is owned by the function arena */
+		b->dom_info = NULL;
 	}
 }
 
@@ -25,6 +25,7 @@
 #define CG_DOM_H
 
 #include "cg/cg.h"
+#include "util/graph_dom.h"
 
 typedef struct cg_dom_info_lst
 {
@@ -37,11 +38,12 @@ typedef struct cg_dom_info
 	struct cg_bb *bb;
 	struct cg_dom_info *idom;
 	struct cg_dom_info_lst *domtree_children;
-	unsigned po;
+	graph_dom_info dom;
 
 } cg_dom_info;
 
 void cg_dom_setup_dom_info(cg_func *func);
 void cg_dom_destroy_dom_info(cg_func *func);
+int cg_dom_dominates(cg_bb *a, cg_bb *b);
 
 #endif
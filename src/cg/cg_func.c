@@ -27,17 +27,27 @@
 
 #include "cg_tu.h"
 #include "cg_func.h"
+#include "cg_analysis.h"
 #include "cg_bb.h"
+#include "cg_instr.h"
 #include "cg_reg.h"
 
-#include "util/graph_loop.h"
+#include "util/arena.h"
+#include "util/dset.h"
+#include "util/stats.h"
 
 cg_func *
 cg_func_build(cg_tu *tu, const char *name)
 {
 	cg_func *func = calloc(1, sizeof(cg_func));
-	func->name = strdup(name);
+	func->arena = arena_create();
+	func->vreg_graph_ctx.arena = func->arena;
+	func->cfg_graph_ctx.arena = func->arena;
+	func->instr_store = cg_instr_store_create(func);
+	func->name = arena_strdup(func->arena, name);
 	func->vreg_cntr = CG_REG_VREG0;
+	cg_analysis_init(func);
+	pthread_mutex_lock(&tu->lock);
 	if (tu->func_first == NULL)
 	{
 		assert(tu->func_last == NULL);
@@ -49,26 +59,69 @@ cg_func_build(cg_tu *tu, const char *name)
 		tu->func_last->func_next = func;
 	}
 	tu->func_last = func;
+	pthread_mutex_unlock(&tu->lock);
 	return func;
 }
 
-static graph_loop_bb_info *
-get_bb_loop_info(graph_node *b)
+void
+cg_func_get_usage(cg_func *func, arena_usage *usage)
 {
-	return &((cg_bb *)b)->loop_info;
+	arena_get_usage(func->arena, usage);
+	cg_instr_store_get_usage(func->instr_store, usage);
 }
 
 void
-cg_func_analyze_loops(cg_func *f)
+cg_func_destroy(cg_tu *tu, cg_func *f)
 {
-	if (f->loop_analysis_cfg_version < f->cfg_graph_ctx.version)
+	cg_func *prev = NULL;
+	cg_func *tmp;
+	arena_usage usage, store_usage = {0};
+
+	/* Unlink from tu, usually f is the first function */
+	pthread_mutex_lock(&tu->lock);
+	for (tmp = tu->func_first; tmp != f; tmp = tmp->func_next)
+	{
+		assert(tmp != NULL);
+		prev = tmp;
+	}
+
+	if (prev == NULL)
+	{
+		tu->func_first = f->func_next;
+	}
+	else
 	{
-		/* cfg modified since last time loop_analyze ran */
-		graph_loop_analyze(&f->cfg_graph_ctx,
-		                   (graph_node *)f->bb_first,
-		                   f->n_bbs,
-		                   get_bb_loop_info);
+		prev->func_next = f->func_next;
+	}
+
+	if (tu->func_last == f)
+	{
+		tu->func_last = prev;
+	}
+	pthread_mutex_unlock(&tu->lock);
 
-		f->loop_analysis_cfg_version = f->cfg_graph_ctx.version;
+	arena_get_usage(f->arena, &usage);
+	cg_instr_store_get_usage(f->instr_store, &store_usage);
+	stats_count("cg.vregs", f->name, f->vreg_cntr - CG_REG_VREG0);
+	stats_count("cg.vreg_edges", f->name, f->vreg_graph_ctx.n_edges);
+	stats_count("cg.arena.allocs", f->name, usage.n_allocs);
+	stats_count("cg.arena.bytes", f->name, usage.n_bytes);
+	stats_count("cg.arena.reserved", f->name, usage.n_reserved);
+	stats_count("cg.store.allocs", f->name, store_usage.n_allocs);
+	stats_count("cg.store.bytes", f->name, store_usage.n_bytes);
+	stats_count("cg.store.reserved", f->name, store_usage.n_reserved);
+
+	/* Everything but the few things that need to grow lives in the arena */
+	if (f->ra.equiv_vreg != NULL)
+	{
+		dset_destroy_universe(f->ra.equiv_vreg);
+	}
+	if (f->ra.equiv_spill_id != NULL)
+	{
+		dset_destroy_universe(f->ra.equiv_spill_id);
 	}
+	free(f->ra.rinfo);
+	cg_instr_store_destroy(f->instr_store);
+	arena_destroy(f->arena);
+	free(f);
 }
@@ -25,14 +25,20 @@
 #define CG_FUNC_H
 
 #include "cg/cg.h"
+#include "util/analysis.h"
 #include "util/graph.h"
+#include "cg/lifetime.h"
+
+struct arena_usage;
 
 #define N_ARRAY_SIZE(x) (sizeof(x)/sizeof((x)[0]))
 
 struct cg_func {
 	struct cg_func *func_next;
 	const char *name;
-	graph_ctx vreg_graph_ctx; /* vregs are in SSA form */
+	struct arena *arena; /* owns bbs, cfg edges and ra side data */
+	struct cg_instr_store *instr_store; /* owns instrs and their def-use edges */
+	graph_ctx vreg_graph_ctx; /* counts the def-use edges, vregs are in SSA form */
 	graph_ctx cfg_graph_ctx;
 
 	struct cg_bb *bb_first;
@@ -53,15 +59,20 @@ struct cg_func {
 		int *spill_slot_offsets;
 		int n_spill_slots;
 		int n_rinfo;
+		interval_alloc ival_alloc;
 	} ra;
 
-	unsigned loop_analysis_cfg_version;
+	analysis_mgr analyses;
 };
 
 cg_func *
 cg_func_build(cg_tu *tu, const char *name);
 
+/* Add the memory held by the arena and the instruction store to usage */
+void
+cg_func_get_usage(cg_func *func, struct arena_usage *usage);
+
 void
-cg_func_analyze_loops(cg_func *f);
+cg_func_destroy(cg_tu *tu, cg_func *f);
 
 #endif
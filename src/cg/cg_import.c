@@ -32,6 +32,7 @@
 #include "cg/cg_bb.h"
 #include "cg/cg_reg.h"
 #include "cg/cg_instr.h"
+#include "util/arena.h"
 
 extern FILE *cg_yyin;
 extern struct cg_yylval_type cg_yylval;
@@ -104,7 +105,7 @@ token_expect(cg_token tok, int consume)
 static void
 instr_set_reg(cg_instr *instr, int reg)
 {
-	cg_func *f = instr->bb->func;
+	cg_func *f = cg_instr_store_of(instr)->func;
 	instr->reg = reg;
 	if (reg >= 0)
 	{
@@ -254,7 +255,7 @@ handle_define(cg_tu *tu)
 						int areg = cg_yylval.ival;
 						if (areg < CG_REG_VREG0)
 						{
-							instr->args[aidx].kind = CG_INSTR_ARG_HREG;
+							instr->arg_kind[aidx] = CG_INSTR_ARG_HREG;
 							instr->args[aidx].u.hreg = areg;
 						}
 						else
@@ -267,13 +268,12 @@ handle_define(cg_tu *tu)
 					}
 					else if (token_peek() == CG_TOK_imm)
 					{
-						instr->args[aidx].kind = CG_INSTR_ARG_IMM;
+						instr->arg_kind[aidx] = CG_INSTR_ARG_IMM;
 						instr->args[aidx].u.imm = cg_yylval.ival;
 					}
 					else if (token_peek() == CG_TOK_sym)
 					{
-						instr->args[aidx].kind = CG_INSTR_ARG_SYM;
-						instr->args[aidx].u.sym = strdup(cg_yylval.strval);
+						cg_instr_arg_set_sym(instr, aidx, cg_yylval.strval);
 					}
 					else if (token_peek() == CG_TOK_lsquare)
 					{
@@ -283,7 +283,7 @@ handle_define(cg_tu *tu)
 						areg = cg_yylval.ival;
 						if (areg < CG_REG_VREG0)
 						{
-							instr->args[aidx].kind = CG_INSTR_ARG_HREG;
+							instr->arg_kind[aidx] = CG_INSTR_ARG_HREG;
 							instr->args[aidx].u.hreg = areg;
 						}
 						else
@@ -373,7 +373,7 @@ handle_define(cg_tu *tu)
 cg_tu *
 cg_import(const char *path)
 {
-	cg_tu *tu = calloc(1, sizeof(cg_tu));
+	cg_tu *tu = cg_tu_build();
 
 	cg_yyin = fopen(path, "r");
 	current_token = cg_yylex();
@@ -23,38 +23,463 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "cg_func.h"
 #include "cg_bb.h"
 #include "cg_instr.h"
 #include "cg_reg.h"
 
-struct instr_edge {
-	graph_edge edge;
-	cg_bb *phi_arg_bb;
-};
+#include "util/arena.h"
+#include "util/word_pool.h"
+
+/*
+ * Use lists and phi argument lists live in the word pool of the store.
+ * They keep the order the pred and succ lists of the vreg graph had: by the
+ * register of the instruction at the other end, evaluated when the list is
+ * walked. An edge with a larger key than the last one is appended. Anything
+ * else flags the list, and until the list is next walked from the start
+ * such edges logically go in front, newest first. They are stored after the
+ * ordered part in the order they arrived so that adding them stays O(1),
+ * and the length of the ordered part tells the two apart. Walking a flagged
+ * list stable sorts it.
+ *
+ * Both kinds of list start with a header in the pool. A single use is kept
+ * inline and needs none.
+ */
+#define USES_WORDS 0 /* size the list was allocated with */
+#define USES_N_ORDERED 1
+#define USES_EDGES 2
+
+#define PHI_N 0
+#define PHI_WORDS 1
+#define PHI_N_ORDERED 2
+#define PHI_EDGES 3
+
+typedef struct keyed_edge {
+	int key;
+	cg_instr_edge edge;
+} keyed_edge;
 
 static int
-edge_cmp(void *a, void *b)
+edge_key(cg_instr_store *store, const cg_instr_edge *e)
+{
+	return cg_instr_at(store, e->instr)->reg;
+}
+
+static void
+list_insert(cg_instr_store *store, cg_instr_edge *edges, unsigned n, unsigned *n_ordered,
+            unsigned char *unordered, unsigned char flag, cg_instr_edge e)
+{
+	if (!(*unordered & flag) && n > 0 &&
+	    edge_key(store, &e) <= edge_key(store, &edges[n - 1]))
+	{
+		*unordered |= flag;
+	}
+
+	edges[n] = e;
+	if (!(*unordered & flag))
+	{
+		*n_ordered = n + 1;
+	}
+}
+
+static void
+list_remove(cg_instr_edge *edges, unsigned n, unsigned i, unsigned *n_ordered,
+            unsigned char *unordered, unsigned char flag)
+{
+	assert(i < n);
+	memmove(&edges[i], &edges[i + 1], (n - i - 1) * sizeof(*edges));
+	if (i < *n_ordered)
+	{
+		(*n_ordered)--;
+	}
+
+	/* Nothing left to sort */
+	if (n - 1 <= 1)
+	{
+		*unordered &= ~flag;
+		*n_ordered = n - 1;
+	}
+}
+
+static void
+list_merge(keyed_edge *dst, const keyed_edge *a, unsigned n_a, const keyed_edge *b, unsigned n_b)
+{
+	while (n_a > 0 && n_b > 0)
+	{
+		if (a->key <= b->key)
+		{
+			*dst++ = *a++;
+			n_a--;
+		}
+		else
+		{
+			*dst++ = *b++;
+			n_b--;
+		}
+	}
+	memcpy(dst, a, n_a * sizeof(*a));
+	memcpy(dst + n_a, b, n_b * sizeof(*b));
+}
+
+/* Put the edges in logical order, the flagged part newest first ahead of
+   the ordered part, and stable sort them by key */
+static void
+list_order(cg_instr_store *store, cg_instr_edge *edges, unsigned n, unsigned n_ordered)
+{
+	keyed_edge *src = malloc(2 * n * sizeof(*src));
+	keyed_edge *dst = src + n;
+	unsigned i, j = 0;
+	unsigned width;
+
+	assert(src != NULL);
+	for (i = n; i > n_ordered; i--)
+	{
+		src[j].key = edge_key(store, &edges[i - 1]);
+		src[j++].edge = edges[i - 1];
+	}
+	for (i = 0; i < n_ordered; i++)
+	{
+		src[j].key = edge_key(store, &edges[i]);
+		src[j++].edge = edges[i];
+	}
+
+	for (width = 1; width < n; width *= 2)
+	{
+		keyed_edge *tmp;
+
+		for (i = 0; i < n; i += 2 * width)
+		{
+			unsigned n_a = n - i < width ? n - i : width;
+			unsigned n_b = n - i - n_a < width ? n - i - n_a : width;
+			list_merge(dst + i, src + i, n_a, src + i + n_a, n_b);
+		}
+		tmp = src;
+		src = dst;
+		dst = tmp;
+	}
+
+	for (i = 0; i < n; i++)
+	{
+		edges[i] = src[i].edge;
+	}
+	free(src < dst ? src : dst);
+}
+
+/* Header of the use list of instr, NULL while the use is inline */
+static unsigned *
+uses_header(cg_instr *instr)
+{
+	if (!(instr->flags & CG_INSTR_USES_OUT_OF_LINE))
+	{
+		return NULL;
+	}
+	return cg_instr_store_of(instr)->pool.words + instr->uses.words;
+}
+
+static cg_instr_edge *
+uses_of(cg_instr *instr)
+{
+	unsigned *header = uses_header(instr);
+	return header != NULL ? (cg_instr_edge *)(header + USES_EDGES) : &instr->uses.inline_use;
+}
+
+static void
+use_add(cg_instr *arg, cg_instr *user, unsigned idx)
+{
+	cg_instr_store *store = cg_instr_store_of(arg);
+	cg_func *func = store->func;
+	unsigned *header = uses_header(arg);
+	cg_instr_edge use;
+
+	use.instr = cg_instr_slot(user);
+	use.idx = idx;
+
+	if (header == NULL && arg->n_uses == 0)
+	{
+		arg->uses.inline_use = use;
+	}
+	else
+	{
+		if (header == NULL || USES_EDGES + 2 * (arg->n_uses + 1) > header[USES_WORDS])
+		{
+			unsigned n_words = word_pool_room(USES_EDGES + 2 * (arg->n_uses + 1));
+			unsigned words;
+
+			if (header != NULL)
+			{
+				words = word_pool_realloc(&store->pool, arg->uses.words, header[USES_WORDS], n_words);
+			}
+			else
+			{
+				/* A single use is in order */
+				words = word_pool_alloc(&store->pool, n_words);
+				memcpy(store->pool.words + words + USES_EDGES, &arg->uses.inline_use, sizeof(use));
+				store->pool.words[words + USES_N_ORDERED] = 1;
+				arg->flags |= CG_INSTR_USES_OUT_OF_LINE;
+			}
+			store->pool.words[words + USES_WORDS] = n_words;
+			arg->uses.words = words;
+			header = store->pool.words + words;
+		}
+
+		list_insert(store, (cg_instr_edge *)(header + USES_EDGES), arg->n_uses, &header[USES_N_ORDERED],
+		            &arg->flags, CG_INSTR_USES_UNORDERED, use);
+	}
+	arg->n_uses++;
+
+	func->vreg_graph_ctx.version++;
+	func->vreg_graph_ctx.n_edges++;
+}
+
+static void
+use_remove(cg_instr *arg, cg_instr *user, unsigned idx)
+{
+	cg_func *func = cg_instr_store_of(arg)->func;
+	unsigned *header = uses_header(arg);
+	cg_instr_edge *uses = uses_of(arg);
+	unsigned slot = cg_instr_slot(user);
+	unsigned i;
+
+	for (i = 0; i < arg->n_uses; i++)
+	{
+		if (uses[i].instr == slot && uses[i].idx == idx)
+		{
+			break;
+		}
+	}
+
+	assert(i < arg->n_uses && "Use not found!");
+	if (header != NULL)
+	{
+		list_remove(uses, arg->n_uses, i, &header[USES_N_ORDERED],
+		            &arg->flags, CG_INSTR_USES_UNORDERED);
+	}
+	arg->n_uses--;
+
+	func->vreg_graph_ctx.version++;
+	func->vreg_graph_ctx.n_edges--;
+}
+
+cg_instr_edge *
+cg_instr_uses(cg_instr *instr)
+{
+	if (instr->flags & CG_INSTR_USES_UNORDERED)
+	{
+		unsigned *header = uses_header(instr);
+
+		list_order(cg_instr_store_of(instr), (cg_instr_edge *)(header + USES_EDGES),
+		           instr->n_uses, header[USES_N_ORDERED]);
+		header[USES_N_ORDERED] = instr->n_uses;
+		instr->flags &= ~CG_INSTR_USES_UNORDERED;
+	}
+	return uses_of(instr);
+}
+
+/* Header of the argument list of a phi, NULL if no argument was added yet */
+static unsigned *
+phi_header(cg_instr *phi)
+{
+	assert(phi->op == CG_INSTR_OP_phi);
+	if (phi->args[0].u.phi_args == 0)
+	{
+		return NULL;
+	}
+	return cg_instr_store_of(phi)->pool.words + phi->args[0].u.phi_args;
+}
+
+static cg_instr_edge *
+phi_args_of(cg_instr *phi)
+{
+	unsigned *header = phi_header(phi);
+
+	if (header != NULL &&
+	    (phi->flags & CG_INSTR_PHI_ARGS_UNORDERED))
+	{
+		list_order(cg_instr_store_of(phi), (cg_instr_edge *)(header + PHI_EDGES),
+		           header[PHI_N], header[PHI_N_ORDERED]);
+		header[PHI_N_ORDERED] = header[PHI_N];
+		phi->flags &= ~CG_INSTR_PHI_ARGS_UNORDERED;
+	}
+	return header != NULL ? (cg_instr_edge *)(header + PHI_EDGES) : NULL;
+}
+
+static unsigned
+phi_n_args(cg_instr *phi)
+{
+	unsigned *header = phi_header(phi);
+	return header != NULL ? header[PHI_N] : 0;
+}
+
+static void
+phi_arg_insert(cg_instr *phi, cg_instr_edge e)
+{
+	cg_instr_store *store = cg_instr_store_of(phi);
+	unsigned *header = phi_header(phi);
+	unsigned n = header != NULL ? header[PHI_N] : 0;
+
+	if (header == NULL || PHI_EDGES + 2 * (n + 1) > header[PHI_WORDS])
+	{
+		unsigned n_words = word_pool_room(PHI_EDGES + 2 * (n + 1));
+		unsigned words;
+
+		if (header != NULL)
+		{
+			words = word_pool_realloc(&store->pool, phi->args[0].u.phi_args, header[PHI_WORDS], n_words);
+		}
+		else
+		{
+			words = word_pool_alloc(&store->pool, n_words);
+			store->pool.words[words + PHI_N] = 0;
+			store->pool.words[words + PHI_N_ORDERED] = 0;
+		}
+		store->pool.words[words + PHI_WORDS] = n_words;
+		phi->args[0].u.phi_args = words;
+		header = store->pool.words + words;
+	}
+
+	list_insert(store, (cg_instr_edge *)(header + PHI_EDGES), n, &header[PHI_N_ORDERED],
+	            &phi->flags, CG_INSTR_PHI_ARGS_UNORDERED, e);
+	header[PHI_N]++;
+}
+
+static void
+phi_arg_remove(cg_instr *phi, unsigned arg_slot, unsigned bb_id)
+{
+	unsigned *header = phi_header(phi);
+	cg_instr_edge *args = (cg_instr_edge *)(header + PHI_EDGES);
+	unsigned i;
+
+	for (i = 0; i < header[PHI_N]; i++)
+	{
+		if (args[i].instr == arg_slot && args[i].idx == bb_id)
+		{
+			break;
+		}
+	}
+
+	assert(i < header[PHI_N] && "Phi argument not found!");
+	list_remove(args, header[PHI_N], i, &header[PHI_N_ORDERED],
+	            &phi->flags, CG_INSTR_PHI_ARGS_UNORDERED);
+	header[PHI_N]--;
+}
+
+static cg_instr *
+store_alloc_instr(cg_instr_store *store)
 {
-	cg_instr *instr_a = a;
-	cg_instr *instr_b = b;
-	return instr_a->reg - instr_b->reg;
+	unsigned slot = store->n_slots++;
+	cg_instr_block *b;
+	cg_instr *instr;
+
+	if (slot / CG_INSTR_BLOCK_INSTRS == store->n_blocks)
+	{
+		if (store->n_blocks == store->blocks_room)
+		{
+			store->blocks_room *= 2;
+			store->blocks = realloc(store->blocks, store->blocks_room * sizeof(*store->blocks));
+		}
+		b = aligned_alloc(CG_INSTR_BLOCK_SIZE, CG_INSTR_BLOCK_SIZE);
+		assert(b != NULL);
+		b->store = store;
+		b->first_slot = store->n_blocks * CG_INSTR_BLOCK_INSTRS;
+		store->blocks[store->n_blocks++] = b;
+	}
+
+	instr = cg_instr_at(store, slot);
+	memset(instr, 0, sizeof(*instr));
+	memset(cg_instr_ra(instr), 0, sizeof(struct cg_instr_ra));
+
+	return instr;
+}
+
+cg_instr_store *
+cg_instr_store_create(cg_func *func)
+{
+	cg_instr_store *store = calloc(1, sizeof(*store));
+
+	store->func = func;
+	store->blocks_room = 4;
+	store->blocks = malloc(store->blocks_room * sizeof(*store->blocks));
+	store->n_slots = 1;
+	store->bbs_room = 16;
+	store->bbs = calloc(store->bbs_room, sizeof(*store->bbs));
+	store->syms_room = 4;
+	store->syms = malloc(store->syms_room * sizeof(*store->syms));
+	word_pool_init(&store->pool);
+
+	return store;
+}
+
+void
+cg_instr_store_destroy(cg_instr_store *store)
+{
+	unsigned i;
+
+	for (i = 0; i < store->n_blocks; i++)
+	{
+		free(store->blocks[i]);
+	}
+	free(store->blocks);
+	free(store->bbs);
+	free(store->syms);
+	word_pool_destroy(&store->pool);
+	free(store);
+}
+
+void
+cg_instr_store_add_bb(cg_instr_store *store, cg_bb *bb)
+{
+	unsigned old_room = store->bbs_room;
+
+	if (bb->graph.id >= store->bbs_room)
+	{
+		while (bb->graph.id >= store->bbs_room)
+		{
+			store->bbs_room *= 2;
+		}
+		store->bbs = realloc(store->bbs, store->bbs_room * sizeof(*store->bbs));
+		memset(store->bbs + old_room, 0, (store->bbs_room - old_room) * sizeof(*store->bbs));
+	}
+
+	store->bbs[bb->graph.id] = bb;
+}
+
+/* Instruction blocks and the tables count as handed out in full, the word
+   pool up to what is in use. Symbol names are in the function arena. */
+void
+cg_instr_store_get_usage(cg_instr_store *store, arena_usage *usage)
+{
+	unsigned long tables = (unsigned long)store->blocks_room * sizeof(*store->blocks) +
+	                       (unsigned long)store->bbs_room * sizeof(*store->bbs) +
+	                       (unsigned long)store->syms_room * sizeof(*store->syms);
+
+	usage->n_allocs += store->n_blocks + 4;
+	usage->n_bytes += (unsigned long)store->n_blocks * CG_INSTR_BLOCK_SIZE +
+	                  (unsigned long)store->pool.n_words * sizeof(*store->pool.words) +
+	                  tables;
+	usage->n_reserved += (unsigned long)store->n_blocks * CG_INSTR_BLOCK_SIZE +
+	                     (unsigned long)store->pool.words_room * sizeof(*store->pool.words) +
+	                     tables;
 }
 
 cg_instr *
 cg_instr_build(cg_bb *bb, cg_instr_op op)
 {
-	cg_instr *instr = (cg_instr *)graph_create_node(sizeof(cg_instr));
-	instr->bb = bb;
+	cg_instr *instr = store_alloc_instr(bb->func->instr_store);
+	struct cg_instr_ra *ra = cg_instr_ra(instr);
+
+	instr->bb = bb->graph.id;
 	instr->op = op;
 	instr->cond = CG_COND_al;
 	instr->reg = bb->func->vreg_cntr++;
 
-	instr->ra.vreg = instr->reg;
-	instr->ra.curr_reg = -1;
-	instr->ra.spill_id = -1;
-	instr->ra.dbg_spill_id = -1;
+	ra->vreg = instr->reg;
+	ra->curr_reg = -1;
+	ra->spill_id = -1;
+	ra->dbg_spill_id = -1;
+
+	bb->func->vreg_graph_ctx.n_nodes++;
 
 	return instr;
 }
@@ -64,18 +489,18 @@ cg_instr_build_phi(cg_bb *bb, ir_type type)
 {
 	cg_instr *instr = cg_instr_build(bb, CG_INSTR_OP_phi);
 
-	if (bb->instr_phi_last != NULL)
+	if (bb->instr_phi_last != 0)
 	{
-		assert(bb->instr_phi_first != NULL);
+		assert(bb->instr_phi_first != 0);
 		instr->instr_prev = bb->instr_phi_last;
-		bb->instr_phi_last->instr_next = instr;
+		cg_instr_at(bb->func->instr_store, bb->instr_phi_last)->instr_next = cg_instr_slot(instr);
 	}
 	else
 	{
-		assert(bb->instr_phi_first == NULL);
-		bb->instr_phi_first = instr;
+		assert(bb->instr_phi_first == 0);
+		bb->instr_phi_first = cg_instr_slot(instr);
 	}
-	bb->instr_phi_last = instr;
+	bb->instr_phi_last = cg_instr_slot(instr);
 	bb->n_phis++;
 
 	return instr;
@@ -84,45 +509,49 @@ cg_instr_build_phi(cg_bb *bb, ir_type type)
 void
 cg_instr_add_phi_arg(cg_instr *phi, cg_bb *arg_bb, cg_instr *arg)
 {
-	struct instr_edge *edge;
-	graph_ctx *gctx = &phi->bb->func->vreg_graph_ctx;
+	cg_instr_edge e;
+
 	assert(phi->op == CG_INSTR_OP_phi);
-	edge = (struct instr_edge *)graph_edge_create(gctx, (graph_node*)arg, (graph_node*)phi, sizeof(struct instr_edge), edge_cmp);
-	edge->phi_arg_bb = arg_bb;
+	e.instr = cg_instr_slot(arg);
+	e.idx = arg_bb->graph.id;
+	phi_arg_insert(phi, e);
+	use_add(arg, phi, arg_bb->graph.id);
 }
 
 void
 cg_instr_change_phi_arg(cg_instr *phi, cg_bb *arg_bb, cg_instr *arg)
 {
-	graph_edge *edge;
-	graph_ctx *gctx = &phi->bb->func->vreg_graph_ctx;
-	assert(phi->op == CG_INSTR_OP_phi);
-	for (edge = graph_pred_first((graph_node *)phi);
-	     edge != NULL;
-	     edge = graph_pred_next((graph_edge *)edge))
+	cg_instr_edge *args = phi_args_of(phi);
+	unsigned n = phi_n_args(phi);
+	unsigned i;
+
+	for (i = 0; i < n; i++)
 	{
-		if (((struct instr_edge *)edge)->phi_arg_bb == arg_bb)
+		if (args[i].idx == arg_bb->graph.id)
 		{
-			graph_edge_delete(gctx, edge);
+			cg_instr *old = cg_instr_edge_instr(phi, &args[i]);
+
+			phi_arg_remove(phi, args[i].instr, arg_bb->graph.id);
+			use_remove(old, phi, arg_bb->graph.id);
 			break;
 		}
 	}
-	assert(edge);
-	edge = graph_edge_create(gctx, (graph_node*)arg, (graph_node*)phi, sizeof(struct instr_edge), edge_cmp);
-	((struct instr_edge *)edge)->phi_arg_bb = arg_bb;
+	assert(i < n);
+	cg_instr_add_phi_arg(phi, arg_bb, arg);
 }
 
 cg_instr *
 cg_instr_phi_input_of(cg_instr *phi, cg_bb *b)
 {
-	graph_edge *edge;
-	assert(phi->op == CG_INSTR_OP_phi);
-	for (edge = graph_pred_first((graph_node *)phi); edge != NULL; edge = graph_pred_next(edge))
+	cg_instr_edge *args = phi_args_of(phi);
+	unsigned n = phi_n_args(phi);
+	unsigned i;
+
+	for (i = 0; i < n; i++)
 	{
-		if (((struct instr_edge *)edge)->phi_arg_bb == b)
+		if (args[i].idx == b->graph.id)
 		{
-			cg_instr *pred = (cg_instr *)graph_edge_tail(edge);
-			return pred;
+			return cg_instr_edge_instr(phi, &args[i]);
 		}
 	}
 
@@ -133,14 +562,16 @@ cg_instr_phi_input_of(cg_instr *phi, cg_bb *b)
 cg_bb *
 cg_instr_phi_input_from(cg_instr *phi, cg_instr *arg)
 {
-	graph_edge *edge;
-	assert(phi->op == CG_INSTR_OP_phi);
-	for (edge = graph_pred_first((graph_node *)phi); edge != NULL; edge = graph_pred_next(edge))
+	cg_instr_edge *args = phi_args_of(phi);
+	unsigned n = phi_n_args(phi);
+	unsigned slot = cg_instr_slot(arg);
+	unsigned i;
+
+	for (i = 0; i < n; i++)
 	{
-		cg_instr *pred = (cg_instr *)graph_edge_tail(edge);
-		if (pred == arg)
+		if (args[i].instr == slot)
 		{
-			return ((struct instr_edge *)edge)->phi_arg_bb;
+			return cg_instr_edge_bb(phi, &args[i]);
 		}
 	}
 
@@ -151,195 +582,263 @@ cg_instr_phi_input_from(cg_instr *phi, cg_instr *arg)
 void
 cg_instr_arg_set_vreg(cg_instr *instr, unsigned arg_idx, cg_instr *arg)
 {
-	graph_ctx *gctx = &instr->bb->func->vreg_graph_ctx;
 	assert(instr->op != CG_INSTR_OP_phi);
 	assert(arg->reg >= 0);
-	if (instr->args[arg_idx].kind == CG_INSTR_ARG_VREG)
+	if (instr->arg_kind[arg_idx] == CG_INSTR_ARG_VREG)
 	{
-		graph_edge_delete(gctx, (graph_edge *)instr->args[arg_idx].u.vreg);
-		instr->args[arg_idx].kind = CG_INSTR_ARG_INVALID;
+		use_remove(cg_instr_arg(instr, arg_idx), instr, arg_idx);
+		instr->arg_kind[arg_idx] = CG_INSTR_ARG_INVALID;
 	}
-	assert(instr->args[arg_idx].kind == CG_INSTR_ARG_INVALID);
-	instr->args[arg_idx].u.vreg = graph_edge_create(gctx, (graph_node*)arg, (graph_node*)instr, sizeof(struct instr_edge), edge_cmp);
-	instr->args[arg_idx].kind = CG_INSTR_ARG_VREG;
+	assert(instr->arg_kind[arg_idx] == CG_INSTR_ARG_INVALID);
+	use_add(arg, instr, arg_idx);
+	instr->args[arg_idx].u.vreg = cg_instr_slot(arg);
+	instr->arg_kind[arg_idx] = CG_INSTR_ARG_VREG;
 }
 
 void
-cg_instr_replace_uses(cg_instr *old, cg_instr *new)
+cg_instr_drop_args(cg_instr *instr)
 {
-	graph_ctx *gctx = &old->bb->func->vreg_graph_ctx;
-	graph_edge *edge, *next_edge;
+	cg_func *func = cg_instr_store_of(instr)->func;
+	unsigned i;
 
-	for (edge = graph_succ_first((graph_node *)old); edge != NULL; edge = next_edge)
+	func->vreg_graph_ctx.version++;
+	if (instr->op == CG_INSTR_OP_phi)
 	{
-		int i;
-		cg_instr *succ = (cg_instr *)graph_edge_head(edge);
-		struct instr_edge *new_edge = (struct instr_edge *)graph_edge_create(gctx, (graph_node*)new, (graph_node*)succ, sizeof(struct instr_edge), edge_cmp);
-		new_edge->phi_arg_bb = ((struct instr_edge *)edge)->phi_arg_bb;
-		for (i = 0; i < CG_INSTR_N_ARGS; i++)
+		unsigned *header = phi_header(instr);
+
+		while (header != NULL && header[PHI_N] > 0)
 		{
-			if (succ->args[i].kind == CG_INSTR_ARG_VREG &&
-			    succ->args[i].u.vreg == edge)
-			{
-				succ->args[i].u.vreg = (graph_edge *)new_edge;
-			}
+			cg_instr_edge e = ((cg_instr_edge *)(header + PHI_EDGES))[header[PHI_N] - 1];
+
+			phi_arg_remove(instr, e.instr, e.idx);
+			use_remove(cg_instr_edge_instr(instr, &e), instr, e.idx);
+			header = phi_header(instr);
+		}
+		return;
+	}
+
+	for (i = 0; i < CG_INSTR_N_ARGS; i++)
+	{
+		if (instr->arg_kind[i] == CG_INSTR_ARG_VREG)
+		{
+			use_remove(cg_instr_arg(instr, i), instr, i);
+			instr->arg_kind[i] = CG_INSTR_ARG_INVALID;
+		}
+	}
+}
+
+void
+cg_instr_arg_set_sym(cg_instr *instr, unsigned arg_idx, const char *sym)
+{
+	cg_instr_store *store = cg_instr_store_of(instr);
+
+	if (store->n_syms == store->syms_room)
+	{
+		store->syms_room *= 2;
+		store->syms = realloc(store->syms, store->syms_room * sizeof(*store->syms));
+	}
+	store->syms[store->n_syms] = arena_strdup(store->func->arena, sym);
+	instr->args[arg_idx].u.sym = store->n_syms++;
+	instr->arg_kind[arg_idx] = CG_INSTR_ARG_SYM;
+}
+
+/* Each use moves over in the order the graph walked them, with the new
+   edge added before the old one is dropped */
+void
+cg_instr_replace_uses(cg_instr *old, cg_instr *new)
+{
+	assert(old != new);
+	(void)cg_instr_uses(old);
+	while (old->n_uses > 0)
+	{
+		cg_instr_edge use = uses_of(old)[0];
+		cg_instr *user = cg_instr_edge_instr(old, &use);
+
+		if (user->op == CG_INSTR_OP_phi)
+		{
+			cg_instr_edge e;
+
+			e.instr = cg_instr_slot(new);
+			e.idx = use.idx;
+			phi_arg_insert(user, e);
+			use_add(new, user, use.idx);
+			phi_arg_remove(user, cg_instr_slot(old), use.idx);
+		}
+		else
+		{
+			use_add(new, user, use.idx);
+			assert(user->arg_kind[use.idx] == CG_INSTR_ARG_VREG);
+			user->args[use.idx].u.vreg = cg_instr_slot(new);
 		}
-		next_edge = graph_succ_next(edge);
-		graph_edge_delete(gctx, edge);
+		use_remove(old, user, use.idx);
 	}
 }
 
 void
 cg_instr_link_first(cg_instr *instr)
 {
-	cg_bb *bb = instr->bb;
+	cg_bb *bb = cg_instr_bb(instr);
+	unsigned slot = cg_instr_slot(instr);
 
 	assert(instr->op != CG_INSTR_OP_phi);
-	assert(instr->instr_prev == NULL);
-	assert(instr->instr_next == NULL);
+	assert(instr->instr_prev == 0);
+	assert(instr->instr_next == 0);
 
-	if (bb->instr_first != NULL)
+	if (bb->instr_first != 0)
 	{
-		assert(bb->instr_last != NULL);
+		assert(bb->instr_last != 0);
 		instr->instr_next = bb->instr_first;
-		bb->instr_first->instr_prev = instr;
+		cg_instr_first(bb)->instr_prev = slot;
 	}
 	else
 	{
-		assert(bb->instr_last == NULL);
-		bb->instr_last = instr;
+		assert(bb->instr_last == 0);
+		bb->instr_last = slot;
 	}
-	bb->instr_first = instr;
+	bb->instr_first = slot;
 	bb->n_instrs++;
 }
 
 void
 cg_instr_link_before(cg_instr *ref, cg_instr *instr)
 {
-	cg_bb *bb = instr->bb;
+	cg_bb *bb = cg_instr_bb(instr);
+	unsigned slot = cg_instr_slot(instr);
 
 	assert(instr->op != CG_INSTR_OP_phi);
-	assert(instr->instr_prev == NULL);
-	assert(instr->instr_next == NULL);
+	assert(instr->instr_prev == 0);
+	assert(instr->instr_next == 0);
 
-	instr->instr_next = ref;
+	instr->instr_next = cg_instr_slot(ref);
 	instr->instr_prev = ref->instr_prev;
 
-	if (ref->instr_prev != NULL)
+	if (ref->instr_prev != 0)
 	{
-		ref->instr_prev->instr_next = instr;
+		cg_instr_prev(ref)->instr_next = slot;
 	}
 	else
 	{
-		bb->instr_first = instr;
+		bb->instr_first = slot;
 	}
-	ref->instr_prev = instr;
+	ref->instr_prev = slot;
 	bb->n_instrs++;
 }
 
 void
 cg_instr_link_after(cg_instr *ref, cg_instr *instr)
 {
-	cg_bb *bb = instr->bb;
+	cg_bb *bb = cg_instr_bb(instr);
+	unsigned slot = cg_instr_slot(instr);
 
 	assert(instr->op != CG_INSTR_OP_phi);
-	assert(instr->instr_prev == NULL);
-	assert(instr->instr_next == NULL);
+	assert(instr->instr_prev == 0);
+	assert(instr->instr_next == 0);
 
-	instr->instr_prev = ref;
+	instr->instr_prev = cg_instr_slot(ref);
 	instr->instr_next = ref->instr_next;
 
-	if (ref->instr_next != NULL)
+	if (ref->instr_next != 0)
 	{
-		ref->instr_next->instr_prev = instr;
+		cg_instr_next(ref)->instr_prev = slot;
 	}
 	else
 	{
-		bb->instr_last = instr;
+		bb->instr_last = slot;
 	}
-	ref->instr_next = instr;
+	ref->instr_next = slot;
 	bb->n_instrs++;
 }
 
 void
 cg_instr_link_last(cg_instr *instr)
 {
-	cg_bb *bb = instr->bb;
+	cg_bb *bb = cg_instr_bb(instr);
+	unsigned slot = cg_instr_slot(instr);
 
 	assert(instr->op != CG_INSTR_OP_phi);
-	assert(instr->instr_prev == NULL);
-	assert(instr->instr_next == NULL);
+	assert(instr->instr_prev == 0);
+	assert(instr->instr_next == 0);
 
-	if (bb->instr_last != NULL)
+	if (bb->instr_last != 0)
 	{
-		assert(bb->instr_first != NULL);
+		assert(bb->instr_first != 0);
 		instr->instr_prev = bb->instr_last;
-		bb->instr_last->instr_next = instr;
+		cg_instr_last(bb)->instr_next = slot;
 	}
 	else
 	{
-		assert(bb->instr_first == NULL);
-		bb->instr_first = instr;
+		assert(bb->instr_first == 0);
+		bb->instr_first = slot;
 	}
-	bb->instr_last = instr;
+	bb->instr_last = slot;
 	bb->n_instrs++;
 }
 
 void
 cg_instr_unlink(cg_instr *instr)
 {
-	cg_bb *bb = instr->bb;
+	cg_bb *bb = cg_instr_bb(instr);
+	unsigned slot = cg_instr_slot(instr);
 
 	assert(instr->op != CG_INSTR_OP_phi);
 
-	if (instr->instr_prev == NULL)
+	if (instr->instr_prev == 0)
 	{
-		assert(bb->instr_first == instr);
+		assert(bb->instr_first == slot);
 		bb->instr_first = instr->instr_next;
 	}
 	else
 	{
-		instr->instr_prev->instr_next = instr->instr_next;
+		cg_instr_prev(instr)->instr_next = instr->instr_next;
 	}
 
-	if (instr->instr_next == NULL)
+	if (instr->instr_next == 0)
 	{
-		assert(bb->instr_last == instr);
+		assert(bb->instr_last == slot);
 		bb->instr_last = instr->instr_prev;
 	}
 	else
 	{
-		instr->instr_next->instr_prev = instr->instr_prev;
+		cg_instr_next(instr)->instr_prev = instr->instr_prev;
 	}
 
-	instr->instr_prev = NULL;
-	instr->instr_next = NULL;
+	instr->instr_prev = 0;
+	instr->instr_next = 0;
 	bb->n_instrs--;
 }
 
+void
+cg_instr_set_bb(cg_instr *instr, cg_bb *bb)
+{
+	assert(instr->instr_prev == 0);
+	assert(instr->instr_next == 0);
+	instr->bb = bb->graph.id;
+}
+
 void
 cg_instr_phi_arg_iter_init(cg_instr_phi_arg_iter *it, cg_instr *phi)
 {
 	assert(phi->op == CG_INSTR_OP_phi);
-	it->next_edge = graph_pred_first((graph_node*)phi);
+	(void)phi_args_of(phi);
+	it->phi = phi;
+	it->idx = 0;
 }
 
 cg_instr *
 cg_instr_phi_arg_iter_next(cg_instr_phi_arg_iter *it, cg_bb **arg_bb)
 {
-	if (it->next_edge == NULL)
+	cg_instr_edge *args;
+
+	if (it->idx >= phi_n_args(it->phi))
 	{
 		return NULL;
 	}
-	else
+
+	/* Refetched as the pool may have moved since the last call */
+	args = (cg_instr_edge *)(phi_header(it->phi) + PHI_EDGES);
+	if (arg_bb != NULL)
 	{
-		cg_instr *arg = (cg_instr *)graph_edge_tail(it->next_edge);
-		if (arg_bb != NULL)
-		{
-			*arg_bb = ((struct instr_edge *)it->next_edge)->phi_arg_bb;
-		}
-		it->next_edge = graph_pred_next(it->next_edge);
-		return arg;
+		*arg_bb = cg_instr_edge_bb(it->phi, &args[it->idx]);
 	}
+	return cg_instr_edge_instr(it->phi, &args[it->idx++]);
 }
-
@@ -25,10 +25,17 @@
 #define CR_INSTR_H
 
 #include "cg/cg.h"
+#include "cg/cg_bb.h"
 #include "cg/cg_cond.h"
+#include "cg/cg_func.h"
 #include "ir/ir.h"
-#include "util/graph.h"
 #include "cg/lifetime.h"
+#include "util/word_pool.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct arena_usage;
 
 #define CG_INSTR_N_ARGS 5
 
@@ -38,47 +45,221 @@ typedef enum cg_instr_op {
 #undef DEF_CG_INSTR
 } cg_instr_op;
 
-struct cg_instr {
-	graph_node graph;
+typedef enum cg_instr_arg_kind {
+	CG_INSTR_ARG_INVALID,
+	CG_INSTR_ARG_VREG,
+	CG_INSTR_ARG_HREG,
+	CG_INSTR_ARG_IMM,
+	CG_INSTR_ARG_SYM
+} cg_instr_arg_kind;
 
-	struct cg_bb *bb;
+/*
+ * Instructions refer to each other by slot, the index of an instruction in
+ * the instruction store of its function, and to their block by the graph id
+ * of the block. Slot 0 is never handed out and stands for no instruction.
+ *
+ * Def-use edges are kept at both ends. An operand of kind VREG holds the
+ * slot of its definition and the definition has a matching entry in its
+ * use list. Phis keep their arguments in a list of their own instead of in
+ * args.
+ */
+typedef struct cg_instr_edge {
+	unsigned instr; /* slot of the other end */
+	unsigned idx; /* operand index, or block graph id if a phi is involved */
+} cg_instr_edge;
 
-	struct cg_instr *instr_prev;
-	struct cg_instr *instr_next;
+/* cg_instr.flags */
+#define CG_INSTR_USES_UNORDERED 1 /* sorted when next walked */
+#define CG_INSTR_PHI_ARGS_UNORDERED 2
+#define CG_INSTR_USES_OUT_OF_LINE 4
 
-	cg_instr_op op;
-	cg_cond cond;
+/* An instruction is 76 bytes and holds no pointers. Most definitions have
+   a single use, which is kept inline until a second one is added. */
+struct cg_instr {
+	unsigned bb; /* graph id of the block, see cg_instr_bb() */
+	unsigned instr_prev; /* slots */
+	unsigned instr_next;
 	int reg;
 
+	unsigned char op; /* cg_instr_op */
+	unsigned char cond; /* cg_cond */
+	unsigned char flags;
+	unsigned char arg_kind[CG_INSTR_N_ARGS]; /* cg_instr_arg_kind */
+
+	unsigned n_uses;
 	union {
-		struct {
-			unsigned arg_reg_mask;
-			unsigned ret_reg_mask;
-		} call;
-	} u;
+		cg_instr_edge inline_use;
+		unsigned words; /* if CG_INSTR_USES_OUT_OF_LINE */
+	} uses;
 
 	struct {
-		enum {CG_INSTR_ARG_INVALID, CG_INSTR_ARG_VREG, CG_INSTR_ARG_HREG, CG_INSTR_ARG_IMM, CG_INSTR_ARG_SYM} kind;
 		union {
-			graph_edge *vreg;
+			unsigned vreg; /* slot of the definition */
 			unsigned imm;
 			unsigned hreg;
-			char *sym;
+			unsigned sym; /* see cg_instr_arg_sym() */
+			unsigned phi_args; /* words, in args[0] of phis */
 		} u;
 		int offset;
 	} args[CG_INSTR_N_ARGS];
+};
 
-	struct {
-		struct pos pos;
-		int spill_id;
-		int dbg_spill_id; /* For debug use only. */
-		int curr_reg;
-		int vreg;
-	} ra;
+/* Register allocator state. Nothing before register allocation touches it,
+   so it is kept in a side array parallel to the instructions. */
+struct cg_instr_ra {
+	struct pos pos;
+	int spill_id;
+	int dbg_spill_id; /* For debug use only. */
+	int curr_reg;
+	int vreg;
 };
 
+/* Instructions are allocated in blocks that are aligned to their size.
+   The block of an instruction, and through it the store, the slot and the
+   register allocator state of the instruction, is found by masking its
+   address. */
+#define CG_INSTR_BLOCK_SIZE 8192
+#define CG_INSTR_BLOCK_INSTRS \
+	((CG_INSTR_BLOCK_SIZE - 16) / (sizeof(struct cg_instr) + sizeof(struct cg_instr_ra)))
+
+typedef struct cg_instr_block {
+	struct cg_instr_store *store;
+	unsigned first_slot;
+	struct cg_instr instrs[CG_INSTR_BLOCK_INSTRS];
+	struct cg_instr_ra ra[CG_INSTR_BLOCK_INSTRS];
+} cg_instr_block;
+
+typedef struct cg_instr_store {
+	cg_func *func;
+	cg_instr_block **blocks;
+	unsigned n_blocks;
+	unsigned blocks_room;
+	unsigned n_slots; /* handed out, slot 0 included */
+	cg_bb **bbs; /* by graph id */
+	unsigned bbs_room;
+	char **syms; /* symbol operands */
+	unsigned n_syms;
+	unsigned syms_room;
+	word_pool pool; /* use and phi argument lists */
+} cg_instr_store;
+
+cg_instr_store *
+cg_instr_store_create(cg_func *func);
+
+void
+cg_instr_store_destroy(cg_instr_store *store);
+
+/* Make bb reachable through its graph id from the instructions */
+void
+cg_instr_store_add_bb(cg_instr_store *store, cg_bb *bb);
+
+/* Add the blocks, tables and words held by the store to usage */
+void
+cg_instr_store_get_usage(cg_instr_store *store, struct arena_usage *usage);
+
+static inline cg_instr_block *
+cg_instr_block_of(cg_instr *instr)
+{
+	return (cg_instr_block *)((uintptr_t)instr & ~(uintptr_t)(CG_INSTR_BLOCK_SIZE - 1));
+}
+
+static inline cg_instr_store *
+cg_instr_store_of(cg_instr *instr)
+{
+	return cg_instr_block_of(instr)->store;
+}
+
+static inline unsigned
+cg_instr_slot(cg_instr *instr)
+{
+	cg_instr_block *b = cg_instr_block_of(instr);
+	return b->first_slot + (instr - b->instrs);
+}
+
+static inline struct cg_instr_ra *
+cg_instr_ra(cg_instr *instr)
+{
+	cg_instr_block *b = cg_instr_block_of(instr);
+	return &b->ra[instr - b->instrs];
+}
+
+/* NULL for slot 0 */
+static inline cg_instr *
+cg_instr_at(cg_instr_store *store, unsigned slot)
+{
+	if (slot == 0)
+	{
+		return NULL;
+	}
+	return &store->blocks[slot / CG_INSTR_BLOCK_INSTRS]->instrs[slot % CG_INSTR_BLOCK_INSTRS];
+}
+
+static inline cg_bb *
+cg_instr_bb(cg_instr *instr)
+{
+	return cg_instr_store_of(instr)->bbs[instr->bb];
+}
+
+static inline cg_instr *
+cg_instr_next(cg_instr *instr)
+{
+	return cg_instr_at(cg_instr_store_of(instr), instr->instr_next);
+}
+
+static inline cg_instr *
+cg_instr_prev(cg_instr *instr)
+{
+	return cg_instr_at(cg_instr_store_of(instr), instr->instr_prev);
+}
+
+/* First and last non-phi instruction of bb */
+static inline cg_instr *
+cg_instr_first(cg_bb *bb)
+{
+	return cg_instr_at(bb->func->instr_store, bb->instr_first);
+}
+
+static inline cg_instr *
+cg_instr_last(cg_bb *bb)
+{
+	return cg_instr_at(bb->func->instr_store, bb->instr_last);
+}
+
+static inline cg_instr *
+cg_instr_phi_first(cg_bb *bb)
+{
+	return cg_instr_at(bb->func->instr_store, bb->instr_phi_first);
+}
+
+/* Definition of an operand of kind VREG */
+static inline cg_instr *
+cg_instr_arg(cg_instr *instr, unsigned arg_idx)
+{
+	return cg_instr_at(cg_instr_store_of(instr), instr->args[arg_idx].u.vreg);
+}
+
+/* The other end of an edge in a use or phi argument list of instr */
+static inline cg_instr *
+cg_instr_edge_instr(cg_instr *instr, const cg_instr_edge *edge)
+{
+	return cg_instr_at(cg_instr_store_of(instr), edge->instr);
+}
+
+/* Block an edge into a phi flows in from */
+static inline cg_bb *
+cg_instr_edge_bb(cg_instr *instr, const cg_instr_edge *edge)
+{
+	return cg_instr_store_of(instr)->bbs[edge->idx];
+}
+
+/* Uses of instr, ordered by the register of the user, see cg_instr.c. The
+   array is only valid until the next edge of the function is added. */
+cg_instr_edge *
+cg_instr_uses(cg_instr *instr);
+
 typedef struct cg_instr_phi_arg_iter {
-	graph_edge *next_edge;
+	cg_instr *phi;
+	unsigned idx;
 } cg_instr_phi_arg_iter;
 
 void
@@ -108,6 +289,20 @@ cg_instr_build(cg_bb *bb, cg_instr_op op);
 void
 cg_instr_arg_set_vreg(cg_instr *instr, unsigned arg_idx, cg_instr *arg);
 
+/* Drop the uses instr makes, phi arguments included. VREG operands are
+   left invalid. */
+void
+cg_instr_drop_args(cg_instr *instr);
+
+void
+cg_instr_arg_set_sym(cg_instr *instr, unsigned arg_idx, const char *sym);
+
+static inline const char *
+cg_instr_arg_sym(cg_instr *instr, unsigned arg_idx)
+{
+	return cg_instr_store_of(instr)->syms[instr->args[arg_idx].u.sym];
+}
+
 void
 cg_instr_replace_uses(cg_instr *old, cg_instr *new);
 
@@ -126,4 +321,8 @@ cg_instr_link_last(cg_instr *instr);
 void
 cg_instr_unlink(cg_instr *instr);
 
+/* Move an unlinked instruction to bb */
+void
+cg_instr_set_bb(cg_instr *instr, cg_bb *bb);
+
 #endif
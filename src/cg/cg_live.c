@@ -0,0 +1,172 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "cg/cg_live.h"
+#include "cg/cg_analysis.h"
+#include "cg/cg_bb.h"
+#include "cg/cg_func.h"
+#include "cg/cg_instr.h"
+#include "cg/cg_reg.h"
+#include "util/bset.h"
+#include <stdlib.h>
+
+/*
+ * Same walk from the uses back to the definition as ir_live.c, on the vreg
+ * graph. Physical registers are left out.
+ */
+typedef struct live_ctx {
+	cg_instr *def;
+	cg_bb **stack; /* blocks with def newly live-in */
+	unsigned sp;
+} live_ctx;
+
+static void
+live_in(live_ctx *ctx, cg_bb *b)
+{
+	if (b == cg_instr_bb(ctx->def) || bset_has(b->live_in, ctx->def->reg))
+	{
+		return;
+	}
+
+	bset_add(b->live_in, ctx->def->reg);
+	ctx->stack[ctx->sp++] = b;
+}
+
+static void
+live_out(live_ctx *ctx, cg_bb *b)
+{
+	if (bset_has(b->live_out, ctx->def->reg))
+	{
+		return;
+	}
+
+	bset_add(b->live_out, ctx->def->reg);
+	live_in(ctx, b);
+}
+
+static void
+explore_def(live_ctx *ctx, cg_instr *def)
+{
+	cg_instr_edge *uses;
+	unsigned i;
+
+	if (def->reg < CG_REG_VREG0)
+	{
+		return;
+	}
+
+	ctx->def = def;
+	uses = cg_instr_uses(def);
+	for (i = 0; i < def->n_uses; i++)
+	{
+		cg_instr *user = cg_instr_edge_instr(def, &uses[i]);
+
+		if (user->op == CG_INSTR_OP_phi)
+		{
+			live_out(ctx, cg_instr_edge_bb(def, &uses[i]));
+		}
+		else
+		{
+			live_in(ctx, cg_instr_bb(user));
+		}
+
+		while (ctx->sp > 0)
+		{
+			cg_bb *b = ctx->stack[--ctx->sp];
+			graph_edge *edge;
+
+			for (edge = graph_pred_first((graph_node *)b); edge != NULL; edge = graph_pred_next(edge))
+			{
+				live_out(ctx, (cg_bb *)graph_edge_tail(edge));
+			}
+		}
+	}
+}
+
+void
+cg_live_setup(cg_func *func)
+{
+	live_ctx ctx;
+	cg_bb *b;
+	unsigned i;
+
+	for (b = func->bb_first; b != NULL; b = b->bb_next)
+	{
+		b->live_in = bset_create_sparse_set(func->arena, func->vreg_cntr + 1);
+		b->live_out = bset_create_sparse_set(func->arena, func->vreg_cntr + 1);
+	}
+
+	/* A block is pushed at most once per definition */
+	ctx.stack = malloc(func->n_bbs*sizeof(cg_bb *));
+	ctx.sp = 0;
+
+	for (i = 0; i < N_ARRAY_SIZE(func->args) && func->args[i]; i++)
+	{
+		explore_def(&ctx, func->args[i]);
+	}
+
+	for (b = func->bb_first; b != NULL; b = b->bb_next)
+	{
+		cg_instr *instr;
+
+		for (instr = cg_instr_phi_first(b); instr != NULL; instr = cg_instr_next(instr))
+		{
+			explore_def(&ctx, instr);
+		}
+
+		for (instr = cg_instr_first(b); instr != NULL; instr = cg_instr_next(instr))
+		{
+			explore_def(&ctx, instr);
+		}
+	}
+
+	free(ctx.stack);
+}
+
+void
+cg_live_destroy(cg_func *func)
+{
+	cg_bb *b;
+
+	/* Memory is owned by the function arena */
+	for (b = func->bb_first; b != NULL; b = b->bb_next)
+	{
+		b->live_in = NULL;
+		b->live_out = NULL;
+	}
+}
+
+bset_set *
+cg_live_in(cg_bb *bb)
+{
+	/* Will only do work if needed */
+	cg_analysis_require(bb->func, CG_ANALYSIS(CG_ANALYSIS_LIVENESS));
+	return bb->live_in;
+}
+
+bset_set *
+cg_live_out(cg_bb *bb)
+{
+	cg_analysis_require(bb->func, CG_ANALYSIS(CG_ANALYSIS_LIVENESS));
+	return bb->live_out;
+}
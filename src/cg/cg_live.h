@@ -0,0 +1,45 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef CG_LIVE_H
+#define CG_LIVE_H
+
+#include "cg/cg.h"
+#include "util/bset.h"
+
+/* Vregs live on entry to and exit from bb. The sets are computed on first
+   use and are only valid until the function is modified. */
+bset_set *
+cg_live_in(cg_bb *bb);
+
+bset_set *
+cg_live_out(cg_bb *bb);
+
+/* Use CG_ANALYSIS_LIVENESS rather than calling these directly */
+void
+cg_live_setup(cg_func *func);
+
+void
+cg_live_destroy(cg_func *func);
+
+#endif
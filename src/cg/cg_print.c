@@ -133,16 +133,16 @@ cg_print_instr(FILE *fp, cg_instr *instr)
 
 		for (i = 0; i < CG_INSTR_N_ARGS; i++)
 		{
-			if (instr->args[i].kind == CG_INSTR_ARG_HREG || instr->args[i].kind == CG_INSTR_ARG_VREG)
+			if (instr->arg_kind[i] == CG_INSTR_ARG_HREG || instr->arg_kind[i] == CG_INSTR_ARG_VREG)
 			{
 				int reg;
-				if (instr->args[i].kind == CG_INSTR_ARG_HREG)
+				if (instr->arg_kind[i] == CG_INSTR_ARG_HREG)
 				{
 					reg = instr->args[i].u.hreg;
 				}
 				else
 				{
-	 				cg_instr *arg = (cg_instr *)graph_edge_tail(instr->args[i].u.vreg);
+	 				cg_instr *arg = cg_instr_arg(instr, i);
 					reg = arg->reg;
 				}
 
@@ -164,16 +164,16 @@ cg_print_instr(FILE *fp, cg_instr *instr)
 					fprintf(fp, " %s", get_regstr(reg));
 				}
 			}
-			else if (instr->args[i].kind == CG_INSTR_ARG_IMM)
+			else if (instr->arg_kind[i] == CG_INSTR_ARG_IMM)
 			{
 				fprintf(fp, " #0x%x", instr->args[i].u.imm);
 			}
-			else if (instr->args[i].kind == CG_INSTR_ARG_SYM)
+			else if (instr->arg_kind[i] == CG_INSTR_ARG_SYM)
 			{
-				fprintf(fp, " @%s", instr->args[i].u.sym);
+				fprintf(fp, " @%s", cg_instr_arg_sym(instr, i));
 			}
 
-			if (i == 0 && instr->args[1].kind != CG_INSTR_ARG_INVALID)
+			if (i == 0 && instr->arg_kind[1] != CG_INSTR_ARG_INVALID)
 			{
 				fprintf(fp, ",");
 			}
@@ -199,13 +199,13 @@ cg_print_func(FILE *fp, cg_func *func)
 		graph_edge *edge;
 		cg_instr *instr;
 		fprintf(fp, "bb%d: ;; loop{nest=%d, type=%d, pre=%d, rpost=%d}\n", bb->id, cg_bb_loop_nest(bb), bb->loop_info.type, bb->loop_info.pre, bb->loop_info.rpost);
-		for (instr = bb->instr_phi_first; instr != NULL; instr = instr->instr_next)
+		for (instr = cg_instr_phi_first(bb); instr != NULL; instr = cg_instr_next(instr))
 		{
 			fprintf(fp, "  ");
 			cg_print_instr(fp, instr);
 			fprintf(fp, "\n");
 		}
-		for (instr = bb->instr_first; instr != NULL; instr = instr->instr_next)
+		for (instr = cg_instr_first(bb); instr != NULL; instr = cg_instr_next(instr))
 		{
 			fprintf(fp, "  ");
 			cg_print_instr(fp, instr);
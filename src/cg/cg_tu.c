@@ -0,0 +1,58 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "cg_tu.h"
+#include "cg_data.h"
+#include "cg_func.h"
+
+#include <stdlib.h>
+
+cg_tu *
+cg_tu_build(void)
+{
+	cg_tu *tu = calloc(1, sizeof(cg_tu));
+	pthread_mutex_init(&tu->lock, NULL);
+	return tu;
+}
+
+void
+cg_tu_destroy(cg_tu *tu)
+{
+	cg_data *d, *d_next;
+
+	while (tu->func_first != NULL)
+	{
+		cg_func_destroy(tu, tu->func_first);
+	}
+
+	for (d = tu->data_first; d != NULL; d = d_next)
+	{
+		d_next = d->data_next;
+		free((char *)d->name);
+		free(d->init);
+		free(d);
+	}
+
+	pthread_mutex_destroy(&tu->lock);
+	free(tu);
+}
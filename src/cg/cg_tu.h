@@ -25,12 +25,20 @@
 #define CG_TU_H
 
 #include "cg/cg.h"
+#include <pthread.h>
 
 struct cg_tu {
+	pthread_mutex_t lock; /* functions may be built and destroyed concurrently */
 	cg_func *func_first;
 	cg_func *func_last;
 	cg_data *data_first;
 	cg_data *data_last;
 };
 
+cg_tu *
+cg_tu_build(void);
+
+void
+cg_tu_destroy(cg_tu *tu);
+
 #endif
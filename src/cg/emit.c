@@ -86,7 +86,7 @@ cg_emit_instr(FILE *fp, cg_instr *instr)
 
 	assert(instr->reg < CG_REG_VREG0);
 
-	if (instr->op == CG_INSTR_OP_mov && (instr->args[0].kind == CG_INSTR_ARG_SYM || (instr->args[0].kind == CG_INSTR_ARG_IMM && instr->args[0].u.imm > 0xff)))
+	if (instr->op == CG_INSTR_OP_mov && (instr->arg_kind[0] == CG_INSTR_ARG_SYM || (instr->arg_kind[0] == CG_INSTR_ARG_IMM && instr->args[0].u.imm > 0xff)))
 	{
 		mnemonic = "ldr";
 	}
@@ -112,13 +112,13 @@ cg_emit_instr(FILE *fp, cg_instr *instr)
 
 	for (i = 0; i < CG_INSTR_N_ARGS; i++)
 	{
-		if (instr->args[i].kind != CG_INSTR_ARG_INVALID && need_comma)
+		if (instr->arg_kind[i] != CG_INSTR_ARG_INVALID && need_comma)
 		{
 			fprintf(fp, ",");
 		}
 
-		assert(instr->args[i].kind != CG_INSTR_ARG_VREG && "Should be all HREG when we get here!");
-		if (instr->args[i].kind == CG_INSTR_ARG_HREG)
+		assert(instr->arg_kind[i] != CG_INSTR_ARG_VREG && "Should be all HREG when we get here!");
+		if (instr->arg_kind[i] == CG_INSTR_ARG_HREG)
 		{
 			if ((is_load(instr) && i == 0) || (is_store(instr) && i == 1))
 			{
@@ -136,7 +136,7 @@ cg_emit_instr(FILE *fp, cg_instr *instr)
 				fprintf(fp, " %s", reg2str[instr->args[i].u.hreg]);
 			}
 		}
-		else if (instr->args[i].kind == CG_INSTR_ARG_IMM)
+		else if (instr->arg_kind[i] == CG_INSTR_ARG_IMM)
 		{
 			if (instr->op == CG_INSTR_OP_mov && instr->args[i].u.imm > 0xff)
 			{
@@ -147,15 +147,15 @@ cg_emit_instr(FILE *fp, cg_instr *instr)
 				fprintf(fp, " #0x%x", instr->args[i].u.imm);
 			}
 		}
-		else if (instr->args[i].kind == CG_INSTR_ARG_SYM)
+		else if (instr->arg_kind[i] == CG_INSTR_ARG_SYM)
 		{
 			if (instr->op == CG_INSTR_OP_mov)
 			{
-				fprintf(fp, " =%s", instr->args[i].u.sym);
+				fprintf(fp, " =%s", cg_instr_arg_sym(instr, i));
 			}
 			else
 			{
-				fprintf(fp, " %s", instr->args[i].u.sym);
+				fprintf(fp, " %s", cg_instr_arg_sym(instr, i));
 			}
 		}
 		need_comma = 1;
@@ -203,7 +203,7 @@ cg_emit_func(FILE *fp, cg_func *f)
 	{
 		cg_instr *instr;
 		fprintf(fp, ".%s_%03d:\n", f->name, bb->id);
-		for (instr = bb->instr_first; instr != NULL; instr = instr->instr_next)
+		for (instr = cg_instr_first(bb); instr != NULL; instr = cg_instr_next(instr))
 		{
 			cg_emit_instr(fp, instr);
 		}
@@ -244,10 +244,9 @@ cg_emit_func(FILE *fp, cg_func *f)
 }
 
 void
-cg_emit_tu(FILE *fp, cg_tu *tu)
+cg_emit_tu_header(FILE *fp, cg_tu *tu)
 {
 	cg_data *d;
-	cg_func *f;
 
 	fprintf(fp, "\t.syntax unified\n");
 	fprintf(fp, "\t.arch armv7-a\n");
@@ -268,6 +267,14 @@ cg_emit_tu(FILE *fp, cg_tu *tu)
 		}
 		fprintf(fp, "\n");
 	}
+}
+
+void
+cg_emit_tu(FILE *fp, cg_tu *tu)
+{
+	cg_func *f;
+
+	cg_emit_tu_header(fp, tu);
 
 	for (f = tu->func_first; f != NULL; f = f->func_next)
 	{
@@ -30,6 +30,9 @@
 void
 cg_emit_func(FILE *fp, cg_func *f);
 
+void
+cg_emit_tu_header(FILE *fp, cg_tu *tu);
+
 void 
 cg_emit_tu(FILE *fp, cg_tu *tu);
 
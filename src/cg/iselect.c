@@ -38,6 +38,8 @@
 #include "ir/ir_func.h"
 #include "ir/ir_bb.h"
 #include "ir/ir_node.h"
+#include "ir/ir_map.h"
+#include "util/arena.h"
 
 struct use {
 	cg_instr *instr;
@@ -59,28 +61,34 @@ struct info {
 	} u;
 };
 
-static graph_marker scratch_marker;
+/* Thread local as functions may be compiled concurrently */
+static __thread ir_node_map info_map;
+static __thread ir_bb_map cg_bb_map;
+static __thread arena *scratch_arena;
 
 static struct info * get_info(ir_node *n)
 {
-	if (!graph_marker_is_set((graph_node *)n, &scratch_marker))
+	struct info *info = ir_node_map_lookup(&info_map, n);
+
+	if (info == NULL)
 	{
-		struct info *tmp;
 		ir_node_use_iter uit;
 		unsigned n_uses = 0;
 
 		ir_node_use_iter_init(&uit, n);
 		while (ir_node_use_iter_next(&uit, NULL)) n_uses++;
 
-		tmp = calloc(1, sizeof(struct info));
-		tmp->n_uses_left = n_uses;
-		tmp->uses = calloc(n_uses, sizeof(struct use));
-
-		graph_marker_set((graph_node *)n, &scratch_marker);
-		ir_node_scratch_set(n, tmp);
+		info = ir_node_map_get(&info_map, n);
+		info->n_uses_left = n_uses;
+		info->uses = arena_alloc(scratch_arena, n_uses*sizeof(struct use));
 	}
 
-	return (struct info *)ir_node_scratch(n);
+	return info;
+}
+
+static cg_bb * get_cg_bb(ir_bb *irb)
+{
+	return *(cg_bb **)ir_bb_map_get(&cg_bb_map, irb);
 }
 
 static void
@@ -129,7 +137,7 @@ iselect_cmp(cg_bb *cgb, ir_node *irn)
 	add_delayed_arg(cgi, 0, args[0]);
 	if (ir_node_op(args[1]) == IR_OP_const && ir_node_const_as_u64(args[1]) <= 0xff)
 	{
-		cgi->args[1].kind = CG_INSTR_ARG_IMM;
+		cgi->arg_kind[1] = CG_INSTR_ARG_IMM;
 		cgi->args[1].u.imm = ir_node_const_as_u64(args[1]);
 		get_info(args[1])->n_uses_left--;
 	}
@@ -171,7 +179,7 @@ iselect_binop(cg_bb *cgb, ir_node *irn)
 	add_delayed_arg(cgi, 0, args[0]);
 	if (is_op2 && ir_node_op(args[1]) == IR_OP_const && ir_node_const_as_u64(args[1]) <= 0xff)
 	{
-		cgi->args[1].kind = CG_INSTR_ARG_IMM;
+		cgi->arg_kind[1] = CG_INSTR_ARG_IMM;
 		cgi->args[1].u.imm = ir_node_const_as_u64(args[1]);
 		get_info(args[1])->n_uses_left--;
 	}
@@ -247,7 +255,7 @@ iselect_const(cg_bb *cgb, ir_node *irn)
 
 	cgi = cg_instr_build(cgb, CG_INSTR_OP_mov);
 
-	cgi->args[0].kind = CG_INSTR_ARG_IMM;
+	cgi->arg_kind[0] = CG_INSTR_ARG_IMM;
 	cgi->args[0].u.imm = ir_node_const_as_u64(irn);
 
 	return cgi;
@@ -259,8 +267,7 @@ iselect_addr_of(cg_bb *cgb, ir_node *irn)
 	cg_instr *cgi;
 
 	cgi = cg_instr_build(cgb, CG_INSTR_OP_mov);
-	cgi->args[0].kind = CG_INSTR_ARG_SYM;
-	cgi->args[0].u.sym = strdup(ir_node_addr_of_data(irn)->name);
+	cg_instr_arg_set_sym(cgi, 0, ir_node_addr_of_data(irn)->name);
 
 	return cgi;
 }
@@ -274,7 +281,7 @@ iselect_alloca(cg_bb *cgb, ir_node *irn)
 	if (sp_offset > 0)
 	{
 		cgi = cg_instr_build(cgb, CG_INSTR_OP_add);
-		cgi->args[1].kind = CG_INSTR_ARG_IMM;
+		cgi->arg_kind[1] = CG_INSTR_ARG_IMM;
 		cgi->args[1].u.imm = sp_offset;
 	}
 	else
@@ -282,7 +289,7 @@ iselect_alloca(cg_bb *cgb, ir_node *irn)
 		cgi = cg_instr_build(cgb, CG_INSTR_OP_mov);
 	}
 
-	cgi->args[0].kind = CG_INSTR_ARG_HREG;
+	cgi->arg_kind[0] = CG_INSTR_ARG_HREG;
 	cgi->args[0].u.hreg = CG_REG_sp;
 
 	return cgi;
@@ -328,7 +335,7 @@ iselect_load_store(cg_bb *cgb, ir_node *irn)
 	return cgi;
 }
 
-static cg_func *
+cg_func *
 cg_iselect_func(cg_tu *ctu, ir_func *irf)
 {
 	cg_func *cgf;
@@ -340,7 +347,12 @@ cg_iselect_func(cg_tu *ctu, ir_func *irf)
 
 	cgf = cg_func_build(ctu, irf->name);
 
-	graph_marker_alloc(&irf->ssa_graph_ctx, &scratch_marker);
+	/* The ir is not changed from here on, compact the ids to keep the
+	   side tables small */
+	ir_func_renumber_nodes(irf);
+	ir_node_map_init(&info_map, irf, sizeof(struct info));
+	ir_bb_map_init(&cg_bb_map, irf, sizeof(cg_bb *));
+	scratch_arena = irf->arena;
 
 	cgf->clobber_mask |= (1 << CG_REG_lr);
 
@@ -351,7 +363,7 @@ cg_iselect_func(cg_tu *ctu, ir_func *irf)
 		cg_bb *cgb;
 		cgb = cg_bb_build(cgf);
 		cg_bb_link_last(cgb);
-		ir_bb_scratch_set(irb, cgb);
+		*(cg_bb **)ir_bb_map_get(&cg_bb_map, irb) = cgb;
 	}
 
 	/* Allocate allocas */
@@ -373,7 +385,7 @@ cg_iselect_func(cg_tu *ctu, ir_func *irf)
 	{
 		ir_node_iter irnit;
 		ir_node *irn;
-		cg_bb *cgb = ir_bb_scratch(irb);
+		cg_bb *cgb = get_cg_bb(irb);
 
 		ir_node_iter_init(&irnit, irb);
 		while ((irn = ir_node_iter_next(&irnit)))
@@ -395,7 +407,7 @@ cg_iselect_func(cg_tu *ctu, ir_func *irf)
 			{
 				struct info *ai = get_info(parg);
 				ai->uses[ai->uses_idx].instr = cgi;
-				ai->uses[ai->uses_idx].u.phi_arg_bb = ir_bb_scratch(pargbb);
+				ai->uses[ai->uses_idx].u.phi_arg_bb = get_cg_bb(pargbb);
 				ai->uses_idx++;
 			}
 		}
@@ -409,11 +421,11 @@ cg_iselect_func(cg_tu *ctu, ir_func *irf)
 				ir_bb *irb_true = ir_bb_get_true_target(irb);
 				ir_bb *irb_false = ir_bb_get_false_target(irb);
 
-				cg_bb_link_cfg(cgb, ir_bb_scratch(irb_true));
-				cg_bb_link_cfg(cgb, ir_bb_scratch(irb_false));
+				cg_bb_link_cfg(cgb, get_cg_bb(irb_true));
+				cg_bb_link_cfg(cgb, get_cg_bb(irb_false));
 
-				cgb->true_target = ir_bb_scratch(irb_true);
-				cgb->false_target = ir_bb_scratch(irb_false);
+				cgb->true_target = get_cg_bb(irb_true);
+				cgb->false_target = get_cg_bb(irb_false);
 				switch (ir_node_op(ircmp)) {
 					case IR_OP_icmp_eq:  cgb->true_cond = CG_COND_eq; break;
 					case IR_OP_icmp_ne:  cgb->true_cond = CG_COND_ne; break;
@@ -428,8 +440,8 @@ cg_iselect_func(cg_tu *ctu, ir_func *irf)
 				{
 					/* True target should never be fall-through. */
 					cgb->true_cond = cg_cond_inv(cgb->true_cond);
-					cgb->true_target = ir_bb_scratch(irb_false);
-					cgb->false_target = ir_bb_scratch(irb_true);
+					cgb->true_target = get_cg_bb(irb_false);
+					cgb->false_target = get_cg_bb(irb_true);
 				}
 
 				cgcmp = iselect_cmp(cgb, ircmp);
@@ -441,7 +453,7 @@ cg_iselect_func(cg_tu *ctu, ir_func *irf)
 			{
 				ir_bb *irb_default = ir_bb_get_default_target(irb);
 
-				cg_bb_link_cfg(cgb, ir_bb_scratch(irb_default));
+				cg_bb_link_cfg(cgb, get_cg_bb(irb_default));
 				cgb->true_cond = CG_COND_al;
 			}
 		}
@@ -450,7 +462,7 @@ cg_iselect_func(cg_tu *ctu, ir_func *irf)
 	/* Setup return value MOV */
 	if (irf->ret_type != vooid)
 	{
-		cg_bb *cgb = ir_bb_scratch(irf->exit);
+		cg_bb *cgb = get_cg_bb(irf->exit);
 		cg_instr *ret;
 		ret = cg_instr_build(cgb, CG_INSTR_OP_ret);
 		ret->reg = -1;
@@ -464,7 +476,7 @@ cg_iselect_func(cg_tu *ctu, ir_func *irf)
 	{
 		ir_node_iter irnit;
 		ir_node *irn;
-		cg_bb *cgb = ir_bb_scratch(irb);
+		cg_bb *cgb = get_cg_bb(irb);
 
 		ir_node_iter_rev_init(&irnit, irb);
 		while ((irn = ir_node_iter_next(&irnit)))
@@ -494,8 +506,7 @@ cg_iselect_func(cg_tu *ctu, ir_func *irf)
 				}
 
 				/* Build call for actual call */
-				call->args[0].kind = CG_INSTR_ARG_SYM;
-				call->args[0].u.sym = strdup(ir_node_call_target(irn)->name);
+				cg_instr_arg_set_sym(call, 0, ir_node_call_target(irn)->name);
 				cg_instr_link_first(call);
 
 				/* Setup parameters */
@@ -589,23 +600,32 @@ cg_iselect_func(cg_tu *ctu, ir_func *irf)
 		}
 	}
 
-	graph_marker_free(&irf->ssa_graph_ctx, &scratch_marker);
+	ir_node_map_destroy(&info_map);
+	ir_bb_map_destroy(&cg_bb_map);
 
 	return cgf;
 }
 
 cg_tu *
-cg_iselect_tu(ir_tu *irt)
+cg_iselect_data(ir_tu *irt)
 {
-	cg_tu *ctu = calloc(1, sizeof(cg_tu));
+	cg_tu *ctu = cg_tu_build();
 	ir_data *d;
-	ir_func *f;
 
 	for (d = irt->first_ir_data; d != NULL; d = d->tu_next)
 	{
 		(void)cg_data_build(ctu, d->name, d->size, d->align, d->init);
 	}
 
+	return ctu;
+}
+
+cg_tu *
+cg_iselect_tu(ir_tu *irt)
+{
+	cg_tu *ctu = cg_iselect_data(irt);
+	ir_func *f;
+
 	for (f = irt->first_ir_func; f != NULL; f = f->tu_list_next)
 	{
 		if (!ir_func_is_definition(f))
@@ -614,6 +634,9 @@ cg_iselect_tu(ir_tu *irt)
 		}
 
 		(void)cg_iselect_func(ctu, f);
+
+		/* The IR body is not needed once it has been translated */
+		ir_func_destroy(f);
 	}
 
 	return ctu;
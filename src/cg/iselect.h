@@ -27,6 +27,12 @@
 #include "cg/cg.h"
 #include "ir/ir.h"
 
+cg_tu *
+cg_iselect_data(ir_tu *irt);
+
+cg_func *
+cg_iselect_func(cg_tu *ctu, ir_func *irf);
+
 cg_tu *
 cg_iselect_tu(ir_tu *irt);
 
@@ -0,0 +1,286 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "cg/lifetime.h"
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#define CLASS_N_IVALS(k) (4u << (k))
+
+/* Order preserving packing of a position into a single integer key */
+static inline uint32_t
+pos_key(struct pos p)
+{
+	return ((uint32_t)(uint16_t)(p.b ^ 0x8000) << 16) | (uint16_t)(p.i ^ 0x8000);
+}
+
+/* Non-zero if an interval ending at to and one starting at from should
+   be merged, i.e. they overlap, touch or are [b,+) [b+1,-) */
+static inline int
+touches(struct pos to, struct pos from)
+{
+	return pos_key(to) >= pos_key(from) ||
+	       (to.b + 1 == from.b && to.i == IPOS_POSINF && from.i == IPOS_NEGINF);
+}
+
+void
+interval_alloc_init(interval_alloc *a, struct arena *arena)
+{
+	unsigned k;
+
+	for (k = 0; k < INTERVAL_SET_N_CLASSES; k++)
+	{
+		pool_init(&a->pools[k], arena, CLASS_N_IVALS(k)*sizeof(interval));
+	}
+}
+
+static void
+reserve(interval_alloc *a, interval_set *set, unsigned n_ivals)
+{
+	unsigned k = set->size_class;
+	interval *ivals;
+
+	if (set->ivals != NULL && n_ivals <= CLASS_N_IVALS(k))
+	{
+		return;
+	}
+
+	while (CLASS_N_IVALS(k) < n_ivals)
+	{
+		k++;
+	}
+	assert(k < INTERVAL_SET_N_CLASSES);
+
+	ivals = pool_alloc(&a->pools[k]);
+	if (set->ivals != NULL)
+	{
+		memcpy(ivals, set->ivals, set->n_ivals*sizeof(interval));
+		pool_free(&a->pools[set->size_class], set->ivals);
+	}
+	set->ivals = ivals;
+	set->size_class = k;
+}
+
+/* First index >= start whose interval ends after key. Gallops forward
+   from start so that a sequence of increasing lookups stays cheap. */
+static unsigned
+search_to(interval_set *set, unsigned start, uint32_t key)
+{
+	unsigned lo = start, hi, step = 1;
+
+	while (lo + step <= set->n_ivals && pos_key(set->ivals[lo + step - 1].to) <= key)
+	{
+		lo += step;
+		step *= 2;
+	}
+	hi = lo + step <= set->n_ivals ? lo + step : set->n_ivals;
+
+	while (lo < hi)
+	{
+		unsigned mid = lo + (hi - lo)/2;
+		if (pos_key(set->ivals[mid].to) <= key)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+interval *
+interval_set_add(interval_alloc *a, interval_set *set, struct pos from, struct pos to)
+{
+	unsigned lo, hi;
+	interval *p;
+
+	assert(pos_key(from) <= pos_key(to));
+
+	/* First interval that could merge with [from,to) */
+	lo = pos_key(from) > 0 ? search_to(set, 0, pos_key(from) - 1) : 0;
+	if (lo > 0 && touches(set->ivals[lo - 1].to, from))
+	{
+		lo--;
+	}
+
+	hi = lo;
+	while (hi < set->n_ivals && touches(to, set->ivals[hi].from))
+	{
+		hi++;
+	}
+
+	if (lo == hi)
+	{
+		reserve(a, set, set->n_ivals + 1);
+		p = &set->ivals[lo];
+		memmove(p + 1, p, (set->n_ivals - lo)*sizeof(interval));
+		p->from = from;
+		p->to = to;
+		set->n_ivals++;
+		return p;
+	}
+
+	p = &set->ivals[lo];
+	if (pos_key(from) < pos_key(p->from))
+	{
+		p->from = from;
+	}
+	p->to = pos_key(to) > pos_key(set->ivals[hi - 1].to) ? to : set->ivals[hi - 1].to;
+	memmove(p + 1, &set->ivals[hi], (set->n_ivals - hi)*sizeof(interval));
+	set->n_ivals -= hi - lo - 1;
+
+	return p;
+}
+
+void
+interval_set_union(interval_alloc *a, interval_set *dst, interval_set *src)
+{
+	unsigned n = dst->n_ivals, m = src->n_ivals;
+	unsigned i, j, log2n;
+	interval_set res;
+
+	assert(dst != src);
+
+	if (m == 0)
+	{
+		return;
+	}
+
+	for (log2n = 1; (1u << log2n) < n; log2n++);
+
+	if (m*log2n < n)
+	{
+		/* Few intervals into a large set, insert one at a time */
+		for (i = 0; i < m; i++)
+		{
+			(void)interval_set_add(a, dst, src->ivals[i].from, src->ivals[i].to);
+		}
+		return;
+	}
+
+	/* Linear merge on from into a fresh array */
+	memset(&res, 0, sizeof(res));
+	reserve(a, &res, n + m);
+	for (i = 0, j = 0; i < n || j < m;)
+	{
+		interval *p;
+		interval *out = res.n_ivals > 0 ? &res.ivals[res.n_ivals - 1] : NULL;
+
+		if (j == m || (i < n && pos_key(dst->ivals[i].from) < pos_key(src->ivals[j].from)))
+		{
+			p = &dst->ivals[i++];
+		}
+		else
+		{
+			p = &src->ivals[j++];
+		}
+
+		if (out != NULL && touches(out->to, p->from))
+		{
+			if (pos_key(p->to) > pos_key(out->to))
+			{
+				out->to = p->to;
+			}
+		}
+		else
+		{
+			res.ivals[res.n_ivals++] = *p;
+		}
+	}
+
+	interval_set_clear(a, dst);
+	*dst = res;
+}
+
+int
+interval_set_intersects(interval_set *set0, interval_set *set1)
+{
+	unsigned i, j = 0;
+
+	if (set0->n_ivals > set1->n_ivals)
+	{
+		interval_set *tmp = set0;
+		set0 = set1;
+		set1 = tmp;
+	}
+
+	/* Two intervals intersect if either one starts inside the other */
+	for (i = 0; i < set0->n_ivals; i++)
+	{
+		uint32_t pf = pos_key(set0->ivals[i].from);
+		uint32_t pt = pos_key(set0->ivals[i].to);
+		unsigned k;
+
+		j = pf > 0 ? search_to(set1, j, pf - 1) : 0;
+		for (k = j; k < set1->n_ivals; k++)
+		{
+			uint32_t qf = pos_key(set1->ivals[k].from);
+			uint32_t qt = pos_key(set1->ivals[k].to);
+
+			if ((qf <= pf && pf < qt) || (pf <= qf && qf < pt))
+			{
+				return 1;
+			}
+			if (qf > pf && qf >= pt)
+			{
+				break;
+			}
+		}
+	}
+
+	return 0;
+}
+
+int
+interval_set_find(interval_set *set, struct pos p)
+{
+	unsigned i = search_to(set, 0, pos_key(p));
+
+	if (i < set->n_ivals && pos_key(set->ivals[i].from) <= pos_key(p))
+	{
+		return i;
+	}
+
+	return -1;
+}
+
+void
+interval_set_truncate(interval_set *set, unsigned n_ivals)
+{
+	assert(n_ivals <= set->n_ivals);
+	set->n_ivals = n_ivals;
+}
+
+void
+interval_set_clear(interval_alloc *a, interval_set *set)
+{
+	if (set->ivals != NULL)
+	{
+		pool_free(&a->pools[set->size_class], set->ivals);
+	}
+	memset(set, 0, sizeof(*set));
+}
@@ -24,8 +24,62 @@
 #ifndef LIFETIME_H
 #define LIFETIME_H
 
+#include "util/pool.h"
+#include <limits.h>
+
+struct arena;
+
 struct pos {
 	short b,i;
 };
 
+#define IPOS_NEGINF SHRT_MIN
+#define IPOS_POSINF SHRT_MAX
+
+typedef struct interval {
+	struct pos from;
+	struct pos to;
+} interval;
+
+/* Set of intervals kept as an array sorted on position. Overlapping,
+   touching and [b,+) [b+1,-) intervals are always merged so that both
+   from and to are strictly increasing and lookups can binary search. */
+typedef struct interval_set {
+	interval *ivals;
+	unsigned n_ivals;
+	unsigned size_class;
+} interval_set;
+
+#define INTERVAL_SET_N_CLASSES 24
+
+/* Interval arrays are handed out in power of two size classes, each one
+   recycled through its own pool */
+typedef struct interval_alloc {
+	pool pools[INTERVAL_SET_N_CLASSES];
+} interval_alloc;
+
+void
+interval_alloc_init(interval_alloc *a, struct arena *arena);
+
+/* Returns the interval that [from,to) ended up in, only valid until set
+   is modified again */
+interval *
+interval_set_add(interval_alloc *a, interval_set *set, struct pos from, struct pos to);
+
+void
+interval_set_union(interval_alloc *a, interval_set *dst, interval_set *src);
+
+int
+interval_set_intersects(interval_set *set0, interval_set *set1);
+
+/* Index of interval containing p or -1 */
+int
+interval_set_find(interval_set *set, struct pos p);
+
+void
+interval_set_truncate(interval_set *set, unsigned n_ivals);
+
+void
+interval_set_clear(interval_alloc *a, interval_set *set);
+
 #endif
@@ -27,19 +27,23 @@
 #include <string.h>
 
 #include "regalloc_ssa.h"
+#include "cg_analysis.h"
 #include "cg_dom.h"
 #include "cg_tu.h"
 #include "cg_func.h"
 #include "cg_bb.h"
 #include "cg_instr.h"
+#include "cg_live.h"
 #include "cg_reg.h"
 #include "cg_print.h"
 #include "ir/ir_tu.h"
 #include "ir/ir_func.h"
 #include "ir/ir_bb.h"
 #include "ir/ir_node.h"
+#include "util/arena.h"
 #include "util/bset.h"
 #include "util/dset.h"
+#include "util/stats.h"
 
 #define DEBUG_SSA_RA 0
 
@@ -52,27 +56,31 @@
 #define MAX(a,b) ((a)<(b)?(b):(a))
 #define MIN(a,b) ((a)<(b)?(a):(b))
 
-#define IPOS_NEGINF SHRT_MIN
-#define IPOS_POSINF SHRT_MAX
 #define IPOS_SPACING 4
 
 
-typedef struct interval {
-	struct interval *next;
-	struct pos from;
-	struct pos to;
-} interval;
-
 typedef struct reg_info {
 	cg_instr *instr;
-	struct interval *liverange; /* liverange for register */
-	struct interval *equiv_liverange; /* liverange for leader of equivalence class */
+	interval_set liverange; /* liverange for register */
+	interval_set equiv_liverange; /* liverange for leader of equivalence class */
 	int *live;
 } reg_info;
 
 static int
 pos_cmp(struct pos a, struct pos b);
 
+static interval *
+range_first(interval_set *range)
+{
+	return range->n_ivals > 0 ? &range->ivals[0] : NULL;
+}
+
+static interval *
+range_next(interval_set *range, interval *p)
+{
+	return p + 1 < &range->ivals[range->n_ivals] ? p + 1 : NULL;
+}
+
 typedef struct lifetime_tracker_ctx {
 	cg_func *func;
 	bset_set *live;
@@ -93,8 +101,8 @@ lifetime_tracker_init(lifetime_tracker_ctx *ctx, cg_func *f)
 	memset(ctx, 0, sizeof(*ctx));
 	ctx->func = f;
 	ctx->n_room_for = f->vreg_cntr + 128;
-	ctx->live = bset_create_set(ctx->n_room_for);
-	ctx->liverange = calloc(sizeof(ctx->liverange[0]), ctx->n_room_for);
+	ctx->live = bset_create_sparse_set(f->arena, ctx->n_room_for);
+	ctx->liverange = arena_alloc(f->arena, ctx->n_room_for*sizeof(ctx->liverange[0]));
 	ctx->skip_vreg = -1;
 }
 
@@ -104,19 +112,14 @@ lifetime_tracker_start(lifetime_tracker_ctx *ctx, cg_bb *b)
 	const cg_func *f = ctx->func;
 	int i;
 
-	ctx->next_instr = b->instr_first;
+	ctx->next_instr = cg_instr_first(b);
 	ctx->n_live = 0;
 
 	for (i = CG_REG_VREG0; i < ctx->func->vreg_cntr; i++)
 	{
-		struct interval *p;
-		for (p = f->ra.rinfo[i].liverange; p; p = p->next)
-		{
-			if (pos_cmp(p->from, b->ra.ival_from) <= 0 && pos_cmp(b->ra.ival_from, p->to) < 0)
-			{
-				break;
-			}
-		}
+		interval_set *range = &f->ra.rinfo[i].liverange;
+		int idx = interval_set_find(range, b->ra.ival_from);
+		struct interval *p = idx != -1 ? &range->ivals[idx] : NULL;
 
 		ctx->liverange[i] = p;
 
@@ -146,10 +149,10 @@ lifetime_tracker_next(lifetime_tracker_ctx *ctx, unsigned *n_live)
 
 		for (i = 0; i < CG_INSTR_N_ARGS; i++)
 		{
-			if (instr->args[i].kind == CG_INSTR_ARG_VREG)
+			if (instr->arg_kind[i] == CG_INSTR_ARG_VREG)
 			{
-				cg_instr *arg = (cg_instr *)graph_edge_tail(instr->args[i].u.vreg);
-				int arg_reg = arg->ra.vreg;
+				cg_instr *arg = cg_instr_arg(instr, i);
+				int arg_reg = cg_instr_ra(arg)->vreg;
 #if 0
 				/* TODO:FIXME: Does not work if there are two or more uses in same instruction */
 				assert(ctx->liverange[arg_reg] && "must be live before use");
@@ -161,12 +164,12 @@ lifetime_tracker_next(lifetime_tracker_ctx *ctx, unsigned *n_live)
 #endif
 
 				/* use */
-				if (pos_cmp(instr->ra.pos, ctx->liverange[arg_reg]->to) == 0)
+				if (pos_cmp(cg_instr_ra(instr)->pos, ctx->liverange[arg_reg]->to) == 0)
 				{
 					/* terminating use */
 					bset_remove(ctx->live, arg_reg);
 					ctx->n_live--;
-					ctx->liverange[arg_reg] = ctx->liverange[arg_reg]->next;
+					ctx->liverange[arg_reg] = range_next(&ctx->func->ra.rinfo[arg_reg].liverange, ctx->liverange[arg_reg]);
 				}
 			}
 		}
@@ -174,16 +177,16 @@ lifetime_tracker_next(lifetime_tracker_ctx *ctx, unsigned *n_live)
 		if (instr->reg != -1)
 		{
 			/* def */
-			assert(!ctx->liverange[instr->ra.vreg] && "must not be live before def");
-			ctx->liverange[instr->ra.vreg] = ctx->func->ra.rinfo[instr->ra.vreg].liverange;
-			assert(ctx->liverange[instr->ra.vreg] && "must be live after def");
-			assert((instr->ra.vreg == 0 || pos_cmp(instr->ra.pos, ctx->liverange[instr->ra.vreg]->from) == 0) && "def must be start of liverange");
-			bset_add(ctx->live, instr->ra.vreg);
+			assert(!ctx->liverange[cg_instr_ra(instr)->vreg] && "must not be live before def");
+			ctx->liverange[cg_instr_ra(instr)->vreg] = range_first(&ctx->func->ra.rinfo[cg_instr_ra(instr)->vreg].liverange);
+			assert(ctx->liverange[cg_instr_ra(instr)->vreg] && "must be live after def");
+			assert((cg_instr_ra(instr)->vreg == 0 || pos_cmp(cg_instr_ra(instr)->pos, ctx->liverange[cg_instr_ra(instr)->vreg]->from) == 0) && "def must be start of liverange");
+			bset_add(ctx->live, cg_instr_ra(instr)->vreg);
 			ctx->n_live++;
 		}
 
 		*n_live = ctx->n_live + ((ctx->skip_vreg != -1 && instr->reg == ctx->skip_vreg) ? -1 : 0);
-		ctx->next_instr = instr->instr_next;
+		ctx->next_instr = cg_instr_next(instr);
 	}
 
 	assert(bset_count(ctx->live) == ctx->n_live);
@@ -196,9 +199,9 @@ lifetime_tracker_get_live(lifetime_tracker_ctx *ctx, int *live)
 {
 	int i, idx = 0;
 
-	for (i = CG_REG_VREG0; i < ctx->func->vreg_cntr; i++)
+	for (i = bset_next_set(ctx->live, CG_REG_VREG0); i != -1; i = bset_next_set(ctx->live, i + 1))
 	{
-		if (i != ctx->skip_vreg && bset_has(ctx->live, i))
+		if (i != ctx->skip_vreg)
 		{
 			live[idx++] = i;
 		}
@@ -226,14 +229,14 @@ lifetime_tracker_add_local(lifetime_tracker_ctx *ctx, cg_instr *instr)
 	assert(var < ctx->n_room_for);
 
 	/* scan up to ctx->instr for variable and adjust n_live and live as appropriate */
-	struct interval *p = ctx->func->ra.rinfo[var].liverange;
+	struct interval *p = range_first(&ctx->func->ra.rinfo[var].liverange);
 
-	if (instr->instr_next == ctx->next_instr)
+	if (cg_instr_next(instr) == ctx->next_instr)
 	{
 		ctx->next_instr = instr;
 	}
 
-	if (ctx->next_instr && pos_cmp(p->from, ctx->next_instr->ra.pos) < 0 && pos_cmp(ctx->next_instr->ra.pos, p->to) <= 0)
+	if (ctx->next_instr && pos_cmp(p->from, cg_instr_ra(ctx->next_instr)->pos) < 0 && pos_cmp(cg_instr_ra(ctx->next_instr)->pos, p->to) <= 0)
 	{
 		ctx->liverange[var] = p;
 		bset_add(ctx->live, var);
@@ -288,13 +291,19 @@ grow_rinfo_as_needed(cg_func *f)
 		memset(&f->ra.rinfo[f->ra.n_rinfo], 0, (newsize - f->ra.n_rinfo)*sizeof(f->ra.rinfo[0]));
 		f->ra.n_rinfo = newsize;
 	}
+
+	if (f->ra.equiv_vreg != NULL)
+	{
+		dset_grow_universe(f->ra.equiv_vreg, f->vreg_cntr);
+	}
 }
 
 #if DEBUG_SSA_RA
 static void
 range_print(FILE *fp, cg_func *func, unsigned v)
 {
-	interval *r = func->ra.rinfo[v].liverange;
+	interval_set *range = &func->ra.rinfo[v].liverange;
+	interval *r = range_first(range);
 	if (r != NULL)
 	{
 		fprintf(fp, "%%v%d: ", v);
@@ -305,216 +314,35 @@ range_print(FILE *fp, cg_func *func, unsigned v)
 			fprintf(fp, ",");
 			pos_print(fp, r->to);
 			fprintf(fp, ") ");
-			r = r->next;
+			r = range_next(range, r);
 		}
 		fprintf(fp, "\n");
 	}
 }
 #endif
 
-static interval *
-range_add_interval(interval **range, struct pos from, struct pos to)
-{
-	interval *r, *prev;
-	interval *p = *range;
-	interval **pp = range;
-
-	assert(pos_cmp(from, to) <= 0);
-
-	/* Keep sorted by from */
-	prev = NULL;
-	while (p != NULL && pos_cmp(p->from, from) < 0)
-	{
-		pp = &p->next;
-		prev = p;
-		p = p->next;
-	}
-
-	assert(prev == NULL || pos_cmp(prev->from, from) <= 0);
-
-	/* Insert new element */
-	r = calloc(1, sizeof(interval));
-	r->from = from;
-	r->to = to;
-	r->next = p;
-	*pp = r;
-
-	/* Want to merge overlaps and [a,+) [a+1,-) */
-#define inf_adjacent(x,y) (((x).b+1 == (y).b) && x.i == IPOS_POSINF && y.i == IPOS_NEGINF)
-
-	/* Try merging before */
-	if (prev && (pos_cmp(prev->to, from) >= 0 || inf_adjacent(prev->to, from)))
-	{
-		if (pos_cmp(to, prev->to) > 0)
-		{
-			prev->to = to;
-		}
-		prev->next = r->next;
-		r = prev;
-	}
-
-	/* Try merging after */
-	p = r;
-	while (p->next && (pos_cmp(p->to, p->next->from) >= 0 || inf_adjacent(p->to, p->next->from)))
-	{
-		if (pos_cmp(p->next->to, p->to) > 0)
-		{
-			p->to = p->next->to;
-		}
-		p->next = p->next->next;
-	}
-
-	return r;
-}
-
 static void
-range_sub_interval(interval **dst, struct pos from, struct pos to)
+range_clear(cg_func *func, interval_set *range)
 {
-	interval *p = *dst;
-	interval **pp = dst;
-
-	while (p && pos_cmp(p->to, from) <= 0)
-	{
-		pp = &p->next;
-		p = p->next;
-	}
-
-	if (p)
-	{
-		assert(pos_cmp(p->to, from) > 0);
-
-		if (pos_cmp(p->from, from) < 0 && pos_cmp(to, p->to) < 0)
-		{
-			/* Need to split interval {p} into {p,q} */
-			struct interval *q = calloc(1, sizeof(*q));
-			q->next = p->next;
-			p->next = q;
-			q->from = to;
-			q->to = p->to;
-			p->to = from;
-		}
-		else
-		{
-			/* Adjust start */
-			if (pos_cmp(p->from, from) < 0)
-			{
-				p->to = from;
-			}
-
-			/* Eat entire intervals */
-			while (p && pos_cmp(p->to, to) <= 0)
-			{
-				pp = &p->next;
-				*pp = p = p->next;
-			}
-
-			/* Adjust end */
-			if (pos_cmp(p->to, to) > 0)
-			{
-				p->from = to;
-			}
-		}
-	}
-}
-
-static struct pos
-pos_min(struct pos a, struct pos b)
-{
-	return pos_cmp(a, b) < 0 ? a : b;
+	interval_set_clear(&func->ra.ival_alloc, range);
 }
 
-static struct pos
-pos_max(struct pos a, struct pos b)
-{
-	return pos_cmp(a, b) > 0 ? a : b;
-}
-
-#if 1
-/* Perform union starting at offset and below (domtree po wise) */
-void
-range_add_sub_offset(cg_func *func, interval **dst, interval *src, struct pos offset, int add_not_sub)
+static interval *
+range_add_interval(cg_func *func, interval_set *range, struct pos from, struct pos to)
 {
-	const unsigned offset_domtree_po = func->ra.rpo[offset.b]->ra.domtree_po;
-
-	/* Advance to offset */
-	while (src != NULL && pos_cmp(src->to, offset) < 0)
-	{
-		src = src->next;
-	}
-
-	while (src != NULL)
-	{
-		unsigned bidx;
-		struct pos src_from = pos_max(src->from, offset);
-
-		/* inside each interval go through the blocks that are contained
-		   in that interval and union them if the domtree_po is less than
-		   that of the original offset's */
-
-		for (bidx = src_from.b; bidx < func->n_bbs; bidx++)
-		{
-			cg_bb *b = func->ra.rpo[bidx];
-
-			if (pos_cmp(b->ra.ival_from, src->to) > 0)
-			{
-				break;
-			}
-
-			if (b->ra.domtree_po <= offset_domtree_po)
-			{
-				struct pos from = pos_max(src_from, b->ra.ival_from);
-				struct pos to = pos_min(src->to, b->ra.ival_to);
-
-				if (add_not_sub)
-				{
-					(void)range_add_interval(dst, from, to);
-				}
-				else
-				{
-					range_sub_interval(dst, from, to);
-				}
-			}
-		}
-
-		src = src->next;
-	}
+	return interval_set_add(&func->ra.ival_alloc, range, from, to);
 }
-#endif
 
 static void
-range_union(interval **dst, interval *src)
+range_union(cg_func *func, interval_set *dst, interval_set *src)
 {
-	while (src != NULL)
-	{
-		(void)range_add_interval(dst, src->from, src->to);
-		src = src->next;
-	}
+	interval_set_union(&func->ra.ival_alloc, dst, src);
 }
 
 static int
-range_test_intersect(interval *src0, interval *src1)
+range_test_intersect(interval_set *src0, interval_set *src1)
 {
-	while (src0 && src1)
-	{
-		while (src0 && src1 && pos_cmp(src0->from, src1->from) <= 0)
-		{
-			if (pos_cmp(src0->to, src1->from) > 0)
-			{
-				return 1;
-			}
-			src0 = src0->next;
-		}
-		while (src1 && src0 && pos_cmp(src1->from, src0->from) <= 0)
-		{
-			if (pos_cmp(src1->to, src0->from) > 0)
-			{
-				return 1;
-			}
-			src1 = src1->next;
-		}
-	}
-
-	return 0;
+	return interval_set_intersects(src0, src1);
 }
 
 static void
@@ -544,30 +372,17 @@ fill_rpo_rec(cg_func *func, cg_bb *b, unsigned *idx, graph_marker *marker)
 	(*idx)++;
 }
 
-static void
-annotate_w_dtpo(cg_func *func, cg_bb *b, unsigned *cntr)
-{
-	struct cg_dom_info_lst *lst;
-
-	for (lst = b->dom_info->domtree_children; lst; lst = lst->next)
-	{
-		annotate_w_dtpo(func, lst->info->bb, cntr);
-	}
-
-	b->ra.domtree_po = (*cntr)++;
-}
-
 static int
 get_reg_for_arg(cg_instr *instr, unsigned arg_idx)
 {
 	int reg = -1;
 
-	if (instr->args[arg_idx].kind == CG_INSTR_ARG_VREG)
+	if (instr->arg_kind[arg_idx] == CG_INSTR_ARG_VREG)
 	{
-		cg_instr *arg = (cg_instr *)graph_edge_tail(instr->args[arg_idx].u.vreg);
+		cg_instr *arg = cg_instr_arg(instr, arg_idx);
 		reg = arg->reg;
 	}
-	else if (instr->args[arg_idx].kind == CG_INSTR_ARG_HREG)
+	else if (instr->arg_kind[arg_idx] == CG_INSTR_ARG_HREG)
 	{
 		reg = instr->args[arg_idx].u.hreg;
 	}
@@ -582,7 +397,7 @@ do_phi_lifting(cg_func *func, cg_instr **phi_lift_movs, unsigned *n_phi_lift_mov
 	for (b = func->bb_first; b != NULL; b = b->bb_next)
 	{
 		cg_instr *phi;
-		for (phi = b->instr_phi_first; phi != NULL; phi = phi->instr_next)
+		for (phi = cg_instr_phi_first(b); phi != NULL; phi = cg_instr_next(phi))
 		{
 			cg_instr *mov;
 			cg_instr_phi_arg_iter it;
@@ -605,7 +420,7 @@ do_phi_lifting(cg_func *func, cg_instr **phi_lift_movs, unsigned *n_phi_lift_mov
 				phi_lift_movs[(*n_phi_lift_movs)++] = mov;
 				assert(*n_phi_lift_movs < 1024);
 			}
-			graph_preds_delete(&func->vreg_graph_ctx, (graph_node *)phi);
+			cg_instr_drop_args(phi);
 			for (i = 0; i < idx; i++)
 			{
 				cg_instr_add_phi_arg(phi, arg_bbs[i], args[i]);
@@ -636,180 +451,220 @@ do_phi_mem_coalesce(cg_func *func, cg_instr **phi_lift_movs, unsigned n_phi_lift
 		/* x = mov y */
 		eq_x = dset_find(func->ra.equiv_vreg, mov->reg);
 
-		assert(mov->args[0].kind == CG_INSTR_ARG_VREG);
- 		arg = (cg_instr *)graph_edge_tail(mov->args[0].u.vreg);
+		assert(mov->arg_kind[0] == CG_INSTR_ARG_VREG);
+ 		arg = cg_instr_arg(mov, 0);
 		eq_y = dset_find(func->ra.equiv_vreg, arg->reg);
 
-		if (!range_test_intersect(func->ra.rinfo[eq_x].equiv_liverange, func->ra.rinfo[eq_y].equiv_liverange))
+		if (!range_test_intersect(&func->ra.rinfo[eq_x].equiv_liverange, &func->ra.rinfo[eq_y].equiv_liverange))
 		{
 			dset_union(func->ra.equiv_vreg, eq_x, eq_y);
 			if (dset_find(func->ra.equiv_vreg, eq_x) == eq_x)
 			{
-				range_union(&func->ra.rinfo[eq_x].equiv_liverange, func->ra.rinfo[eq_y].liverange);
+				range_union(func, &func->ra.rinfo[eq_x].equiv_liverange, &func->ra.rinfo[eq_y].liverange);
 			}
 			else
 			{
 				assert(dset_find(func->ra.equiv_vreg, eq_x) == eq_y);
-				range_union(&func->ra.rinfo[eq_y].equiv_liverange, func->ra.rinfo[eq_x].liverange);
+				range_union(func, &func->ra.rinfo[eq_y].equiv_liverange, &func->ra.rinfo[eq_x].liverange);
 			}
-			range_union(&func->ra.rinfo[arg->reg].liverange, func->ra.rinfo[mov->reg].liverange);
+			range_union(func, &func->ra.rinfo[arg->reg].liverange, &func->ra.rinfo[mov->reg].liverange);
 			cg_instr_replace_uses(mov, arg);
-			func->ra.rinfo[mov->reg].liverange = NULL;
-			graph_preds_delete(&func->vreg_graph_ctx, (graph_node *)mov);
+			range_clear(func, &func->ra.rinfo[mov->reg].liverange);
+			cg_instr_drop_args(mov);
 			cg_instr_unlink(mov);
 		}
 	}
 }
 
-/* Given a natural loop defined by its header and back-edge tail, propagate liveness to all blocks */
-static void
-propagate_live_in_loop_body(cg_bb *header, cg_bb *tail, bset_set *live)
+/*
+ * Liveness is computed by exploring paths backwards from each use towards the
+ * definition (Brandner et al.) rather than by a dataflow walk over all blocks.
+ * Strict SSA guarantees that every path from a use reaches the definition, so
+ * only blocks where a value is actually live are ever visited. A phi use
+ * counts as a use at the end of the corresponding predecessor. Physical
+ * registers referenced directly (e.g. sp) have no definition and are treated
+ * as live from function entry up to each use.
+ */
+typedef struct
 {
-	cg_func *func = header->func;
-	cg_bb *stack[header->func->n_bbs];
-	unsigned si = 0;
-	graph_marker marker;
+	cg_func *func;
+	int reg;
+	cg_bb *def_bb;
+	struct pos def_pos;
+	int *livein_vreg; /* per block position, last vreg found live-in */
+	int *liveout_vreg;
+	unsigned *livein_hreg; /* per block position, mask of live-in physical registers */
+	unsigned *liveout_hreg;
+	cg_bb **stack;
+} liveness_ctx;
 
-	graph_marker_alloc(&func->cfg_graph_ctx, &marker);
+static int
+liveness_test_and_set(liveness_ctx *ctx, int *vreg_mark, unsigned *hreg_mark, cg_bb *b)
+{
+	int bpos = b->ra.ival_from.b;
+
+	if (ctx->reg < CG_REG_VREG0)
+	{
+		unsigned bit = 1U << ctx->reg;
+		if (hreg_mark[bpos] & bit)
+		{
+			return 1;
+		}
+		hreg_mark[bpos] |= bit;
+		return 0;
+	}
+
+	if (vreg_mark[bpos] == ctx->reg)
+	{
+		return 1;
+	}
+	vreg_mark[bpos] = ctx->reg;
+	return 0;
+}
+
+/* Register is live-out at b, returns the new stack depth */
+static unsigned
+liveness_live_out(liveness_ctx *ctx, cg_bb *b, unsigned si)
+{
+	interval_set *range = &ctx->func->ra.rinfo[ctx->reg].liverange;
+
+	if (liveness_test_and_set(ctx, ctx->liveout_vreg, ctx->liveout_hreg, b))
+	{
+		return si;
+	}
 
-	stack[si++] = tail;
+	if (b == ctx->def_bb)
+	{
+		range_add_interval(ctx->func, range, ctx->def_pos, b->ra.ival_to);
+		return si;
+	}
 
+	range_add_interval(ctx->func, range, b->ra.ival_from, b->ra.ival_to);
+	if (!liveness_test_and_set(ctx, ctx->livein_vreg, ctx->livein_hreg, b))
+	{
+		assert((ctx->reg < CG_REG_VREG0 || bset_has(b->live_in, ctx->reg)) && "must agree with liveness analysis");
+		ctx->stack[si++] = b;
+	}
+	return si;
+}
+
+/* Blocks on the stack have the register live-in, make it live-out at their predecessors */
+static void
+liveness_walk_preds(liveness_ctx *ctx, unsigned si)
+{
 	while (si > 0)
 	{
-		cg_bb *b = stack[--si];
+		cg_bb *b = ctx->stack[--si];
 		graph_edge *edge;
-		unsigned i;
 
-		graph_marker_set((graph_node *)b, &marker);
-
-		for (i = 0; i < func->vreg_cntr; i++)
+		for (edge = graph_pred_first((graph_node *)b); edge != NULL; edge = graph_pred_next(edge))
 		{
-			if (bset_has(live, i))
-			{
-				range_add_interval(&func->ra.rinfo[i].liverange, b->ra.ival_from, b->ra.ival_to);
-				if (header != b)
-				{
-					bset_add(b->ra.livein, i);
-				}
-			}
+			si = liveness_live_out(ctx, (cg_bb *)graph_edge_tail(edge), si);
 		}
+	}
+}
 
-		if (b != header)
-		{
-			for (edge = graph_pred_first((graph_node *)b); edge != NULL; edge = graph_pred_next(edge))
-			{
-				cg_bb *pred = (cg_bb *)graph_edge_tail(edge);
-				if (!graph_marker_is_set((graph_node *)pred, &marker))
-				{
-					stack[si++] = pred;
-				}
-			}
-		}
+/* Register is used by a non-phi instruction at pos in b */
+static void
+liveness_use(liveness_ctx *ctx, cg_bb *b, struct pos pos)
+{
+	interval_set *range = &ctx->func->ra.rinfo[ctx->reg].liverange;
+
+	if (b == ctx->def_bb)
+	{
+		range_add_interval(ctx->func, range, ctx->def_pos, pos);
+		return;
 	}
 
-	graph_marker_free(&func->cfg_graph_ctx, &marker);
+	range_add_interval(ctx->func, range, b->ra.ival_from, pos);
+	if (!liveness_test_and_set(ctx, ctx->livein_vreg, ctx->livein_hreg, b))
+	{
+		assert((ctx->reg < CG_REG_VREG0 || bset_has(b->live_in, ctx->reg)) && "must agree with liveness analysis");
+		ctx->stack[0] = b;
+		liveness_walk_preds(ctx, 1);
+	}
 }
 
 static void
-do_lifetime_intervals(cg_func *func)
+liveness_def(liveness_ctx *ctx, cg_instr *def, struct pos def_pos)
 {
+	cg_instr_edge *uses = cg_instr_uses(def);
 	unsigned i;
-	int bpos = func->n_bbs - 1;
-	bset_set *live = bset_create_set(func->vreg_cntr);
-	struct interval *curr_ivals[func->vreg_cntr];
-
-	memset(curr_ivals, 0, sizeof(curr_ivals));
 
+	ctx->reg = def->reg;
+	ctx->def_bb = cg_instr_bb(def);
+	ctx->def_pos = def_pos;
 
-	for (i = 0; i < func->n_bbs; i++)
+	for (i = 0; i < def->n_uses; i++)
 	{
-		int j, l, bidx = func->n_bbs - i - 1;
-		cg_bb *b = func->ra.rpo[bidx];
-		cg_instr *instr;
-		graph_edge *edge;
-		int ipos = b->n_instrs*IPOS_SPACING;
-
-		bset_clear(live);
+		cg_instr *use = cg_instr_edge_instr(def, &uses[i]);
 
-		for (edge = graph_succ_first((graph_node *)b); edge != NULL; edge = graph_succ_next(edge))
+		if (use->op == CG_INSTR_OP_phi)
 		{
-			cg_bb *succ = (cg_bb *)graph_edge_head(edge);
-			cg_instr *phi;
-
-			if (succ->ra.livein)
-			{
-				bset_union(live, succ->ra.livein);
-			}
-
-			for (phi = succ->instr_phi_first; phi != NULL; phi = phi->instr_next)
-			{
-				bset_add(live, cg_instr_phi_input_of(phi, b)->reg);
-			}
+			liveness_walk_preds(ctx, liveness_live_out(ctx, cg_instr_edge_bb(def, &uses[i]), 0));
 		}
-
-		for (j = 0; j < func->vreg_cntr; j++) /* TODO:FIXME: Make quicker */
+		else
 		{
-			if (bset_has(live, j))
-			{
-				/* variable in liveout[b] */
-				curr_ivals[j] = range_add_interval(&func->ra.rinfo[j].liverange, pos_make(bpos, IPOS_NEGINF), pos_make(bpos, IPOS_POSINF));
-			}
+			liveness_use(ctx, cg_instr_bb(use), cg_instr_ra(use)->pos);
 		}
+	}
+}
 
-		b->ra.ival_to = pos_make(bpos, IPOS_POSINF);
-		for (instr = b->instr_last; instr != NULL; instr = instr->instr_prev)
-		{
-			assert(instr->op != CG_INSTR_OP_phi);
+/* Everything the liveness analysis has live-in must be covered by the
+   intervals, the walk above asserts the converse */
+static void
+check_lifetime_intervals(cg_func *func)
+{
+	int bpos;
 
-			ipos -= IPOS_SPACING;
+	for (bpos = 0; bpos < func->n_bbs; bpos++)
+	{
+		cg_bb *b = func->ra.rpo[bpos];
+		int v;
 
-			instr->ra.pos = pos_make(bpos, ipos);
+		for (v = bset_next_set(b->live_in, 0); v != -1; v = bset_next_set(b->live_in, v + 1))
+		{
+			assert(interval_set_find(&func->ra.rinfo[v].liverange, b->ra.ival_from) != -1 && "must agree with liveness analysis");
+		}
+	}
+}
 
-			if (instr->reg != -1)
-			{
-				curr_ivals[instr->reg]->from = pos_make(bpos, ipos);
-				bset_remove(live, instr->reg);
-				func->ra.rinfo[instr->reg].instr = instr;
-			}
+static void
+do_lifetime_intervals(cg_func *func)
+{
+	liveness_ctx ctx;
+	unsigned i;
+	int bpos;
 
-			for (l = 0; l < CG_INSTR_N_ARGS; l++)
-			{
-				int reg = get_reg_for_arg(instr, l);
-				if (reg != -1 && !bset_has(live, reg))
-				{
-					curr_ivals[reg] = range_add_interval(&func->ra.rinfo[reg].liverange, pos_make(bpos, IPOS_NEGINF), pos_make(bpos, ipos));
-					bset_add(live, reg);
-				}
-			}
-		}
+	assert(CG_REG_VREG0 <= sizeof(unsigned)*CHAR_BIT);
+
+	/* Number all instructions, positions must be known before exploring */
+	for (bpos = 0; bpos < func->n_bbs; bpos++)
+	{
+		cg_bb *b = func->ra.rpo[bpos];
+		cg_instr *instr;
+		int ipos = b->n_instrs*IPOS_SPACING;
 
 		b->ra.ival_from = pos_make(bpos, IPOS_NEGINF);
+		b->ra.ival_to = pos_make(bpos, IPOS_POSINF);
 
-		for (instr = b->instr_phi_last; instr != NULL; instr = instr->instr_prev)
+		for (instr = cg_instr_phi_first(b); instr != NULL; instr = cg_instr_next(instr))
 		{
 			assert(instr->op == CG_INSTR_OP_phi);
-			bset_remove(live, instr->reg);
 			func->ra.rinfo[instr->reg].instr = instr;
 		}
 
-		/* If b is a loop header propagate live to all blocks */
-		for (edge = graph_pred_first((graph_node *)b); edge != NULL; edge = graph_pred_next(edge))
+		for (instr = cg_instr_last(b); instr != NULL; instr = cg_instr_prev(instr))
 		{
-			cg_bb *pred = (cg_bb *)graph_edge_tail(edge);
-			if (pred->ra.po < b->ra.po)
+			assert(instr->op != CG_INSTR_OP_phi);
+			ipos -= IPOS_SPACING;
+			cg_instr_ra(instr)->pos = pos_make(bpos, ipos);
+			if (instr->reg != -1)
 			{
-				propagate_live_in_loop_body(b, pred, live);
+				assert(instr->reg >= CG_REG_VREG0);
+				func->ra.rinfo[instr->reg].instr = instr;
 			}
 		}
-
-		b->ra.livein = bset_create_set(func->vreg_cntr);
-		bset_copy(b->ra.livein, live);
-#if 0
-		printf("bb%d: ", b->id);
-		bset_print(stdout, b->ra.livein);
-		printf("\n");
-#endif
-		bpos--;
 	}
 
 	for (i = 0; i < N_ARRAY_SIZE(func->args) && func->args[i]; i++)
@@ -817,6 +672,56 @@ do_lifetime_intervals(cg_func *func)
 		cg_instr *arg = func->args[i];
 		func->ra.rinfo[arg->reg].instr = arg;
 	}
+
+	ctx.func = func;
+	ctx.livein_vreg = arena_alloc(func->arena, func->n_bbs*sizeof(ctx.livein_vreg[0]));
+	ctx.liveout_vreg = arena_alloc(func->arena, func->n_bbs*sizeof(ctx.liveout_vreg[0]));
+	ctx.livein_hreg = arena_alloc(func->arena, func->n_bbs*sizeof(ctx.livein_hreg[0]));
+	ctx.liveout_hreg = arena_alloc(func->arena, func->n_bbs*sizeof(ctx.liveout_hreg[0]));
+	ctx.stack = arena_alloc(func->arena, func->n_bbs*sizeof(ctx.stack[0]));
+	for (bpos = 0; bpos < func->n_bbs; bpos++)
+	{
+		ctx.livein_vreg[bpos] = ctx.liveout_vreg[bpos] = -1;
+		ctx.livein_hreg[bpos] = ctx.liveout_hreg[bpos] = 0;
+	}
+
+	/* Explore from the uses of every definition */
+	for (i = 0; i < N_ARRAY_SIZE(func->args) && func->args[i]; i++)
+	{
+		cg_instr *arg = func->args[i];
+		liveness_def(&ctx, arg, cg_instr_bb(arg)->ra.ival_from);
+	}
+
+	for (bpos = 0; bpos < func->n_bbs; bpos++)
+	{
+		cg_bb *b = func->ra.rpo[bpos];
+		cg_instr *instr;
+
+		for (instr = cg_instr_phi_first(b); instr != NULL; instr = cg_instr_next(instr))
+		{
+			liveness_def(&ctx, instr, b->ra.ival_from);
+		}
+
+		for (instr = cg_instr_first(b); instr != NULL; instr = cg_instr_next(instr))
+		{
+			unsigned l;
+
+			if (instr->reg != -1)
+			{
+				liveness_def(&ctx, instr, cg_instr_ra(instr)->pos);
+			}
+
+			for (l = 0; l < CG_INSTR_N_ARGS; l++)
+			{
+				if (instr->arg_kind[l] == CG_INSTR_ARG_HREG)
+				{
+					ctx.reg = instr->args[l].u.hreg;
+					ctx.def_bb = NULL;
+					liveness_use(&ctx, b, cg_instr_ra(instr)->pos);
+				}
+			}
+		}
+	}
 }
 
 #if DEBUG_SSA_RA
@@ -841,31 +746,31 @@ debug_print_ra_fp(FILE *fp, cg_func *func, int print_intervals)
 
 		fprintf(fp, "    bb%d:\n", b->id);
 
-		for (instr = b->instr_phi_first; instr != NULL; instr = instr->instr_next)
+		for (instr = cg_instr_phi_first(b); instr != NULL; instr = cg_instr_next(instr))
 		{
 			fprintf(fp, "      ");
 			cg_print_instr(fp, instr);
-			if (instr->ra.dbg_spill_id != -1)
+			if (cg_instr_ra(instr)->dbg_spill_id != -1)
 			{
-				int equiv = dset_find(func->ra.equiv_spill_id, instr->ra.dbg_spill_id);
+				int equiv = dset_find(func->ra.equiv_spill_id, cg_instr_ra(instr)->dbg_spill_id);
 				fprintf(fp, " [spill_id: %d]", equiv);
 			}
 			fprintf(fp, "\n");
 		}
-		for (instr = b->instr_first; instr != NULL; instr = instr->instr_next)
+		for (instr = cg_instr_first(b); instr != NULL; instr = cg_instr_next(instr))
 		{
 			if (print_intervals)
 			{
-				fprintf(fp, "%d.%d:  ", instr->ra.pos.b, instr->ra.pos.i);
+				fprintf(fp, "%d.%d:  ", cg_instr_ra(instr)->pos.b, cg_instr_ra(instr)->pos.i);
 			}
 			else
 			{
 				fprintf(fp, "           ");
 			}
 			cg_print_instr(fp, instr);
-			if (instr->ra.dbg_spill_id != -1)
+			if (cg_instr_ra(instr)->dbg_spill_id != -1)
 			{
-				int equiv = dset_find(func->ra.equiv_spill_id, instr->ra.dbg_spill_id);
+				int equiv = dset_find(func->ra.equiv_spill_id, cg_instr_ra(instr)->dbg_spill_id);
 				fprintf(fp, " [spill_id: %d]", equiv);
 			}
 			if (print_intervals)
@@ -934,7 +839,7 @@ do_phi_analysis(cg_func *func)
 	for (bb = func->bb_first; bb != NULL; bb = bb->bb_next)
 	{
 		cg_instr *phi;
-		for (phi = bb->instr_phi_first; phi != NULL; phi = phi->instr_next)
+		for (phi = cg_instr_phi_first(bb); phi != NULL; phi = cg_instr_next(phi))
 		{
 			cg_instr_phi_arg_iter pit;
 			cg_instr *parg;
@@ -950,7 +855,7 @@ do_phi_analysis(cg_func *func)
 	for (i = 0; i < func->vreg_cntr; i++)
 	{
 		int eq = dset_find(func->ra.equiv_vreg, i);
-		range_union(&func->ra.rinfo[eq].equiv_liverange, func->ra.rinfo[i].liverange);
+		range_union(func, &func->ra.rinfo[eq].equiv_liverange, &func->ra.rinfo[i].liverange);
 	}
 }
 
@@ -981,7 +886,7 @@ pref_cmp(const void *a, const void *b)
 static void
 compute_preference(cg_instr *instr, int *preforder)
 {
-	graph_edge *edge;
+	cg_instr_edge *uses;
 	struct pref_pair score[CG_REG_VREG0];
 	int i;
 
@@ -992,7 +897,7 @@ compute_preference(cg_instr *instr, int *preforder)
 	}
 
 	if (instr->op == CG_INSTR_OP_mov &&
-	    instr->args[0].kind == CG_INSTR_ARG_HREG)
+	    instr->arg_kind[0] == CG_INSTR_ARG_HREG)
 	{
 		/* Pre-colored def */
 		score[instr->args[0].u.hreg].points++;
@@ -1018,20 +923,16 @@ compute_preference(cg_instr *instr, int *preforder)
 		}
 	}
 
-	for (edge = graph_succ_first((graph_node *)instr); edge != NULL; edge = graph_succ_next(edge))
+	uses = cg_instr_uses(instr);
+	for (i = 0; i < instr->n_uses; i++)
 	{
-		cg_instr *use = (cg_instr *)graph_edge_head(edge);
+		cg_instr *use = cg_instr_edge_instr(instr, &uses[i]);
 		if (use->op == CG_INSTR_OP_call)
 		{
 			/* Pre-colored use */
-			unsigned i;
-			for (i = 0; i < CG_INSTR_N_ARGS; i++)
+			if (use->arg_kind[uses[i].idx] == CG_INSTR_ARG_VREG)
 			{
-				if (use->args[i].kind == CG_INSTR_ARG_VREG &&
-				    use->args[i].u.vreg == edge)
-				{
-					score[i-1].points++;
-				}
+				score[uses[i].idx - 1].points++;
 			}
 		}
 		else if (use->op == CG_INSTR_OP_mov &&
@@ -1059,14 +960,15 @@ compute_preference(cg_instr *instr, int *preforder)
 static unsigned
 compute_spill_cost(cg_instr *instr)
 {
-	graph_edge *edge;
+	cg_instr_edge *uses = cg_instr_uses(instr);
 	unsigned cost;
+	unsigned i;
 
-	cost = 1 + cg_bb_loop_nest(instr->bb)*10;
-	for (edge = graph_succ_first((graph_node *)instr); edge != NULL; edge = graph_succ_next(edge))
+	cost = 1 + cg_bb_loop_nest(cg_instr_bb(instr))*10;
+	for (i = 0; i < instr->n_uses; i++)
 	{
-		cg_instr *use = (cg_instr *)graph_edge_head(edge);
-		cost += 1 + cg_bb_loop_nest(use->bb)*10;
+		cg_instr *use = cg_instr_edge_instr(instr, &uses[i]);
+		cost += 1 + cg_bb_loop_nest(cg_instr_bb(use))*10;
 	}
 
 	return cost;
@@ -1081,7 +983,7 @@ select_virtual_to_spill(cg_func *f, int *live_virtuals, unsigned n_live, struct
 	for (i = 0; i < n_live; i++)
 	{
 		int v = live_virtuals[i];
-		if (v >= CG_REG_VREG0 && pos_cmp(f->ra.rinfo[v].liverange->from, pos) < 0)
+		if (v >= CG_REG_VREG0 && pos_cmp(range_first(&f->ra.rinfo[v].liverange)->from, pos) < 0)
 		{
 			unsigned cost = compute_spill_cost(f->ra.rinfo[v].instr);
 			if (cost < min_cost)
@@ -1111,6 +1013,9 @@ do_select_spill(cg_func *func, unsigned max_regs)
 
 	lifetime_tracker_init(&lctx, func);
 
+	/* Grown as spill ids are handed out */
+	func->ra.equiv_spill_id = dset_create_universe(0);
+
 	curr_spill_id = 0;
 	for (bix = 0; bix < func->n_bbs; bix++)
 	{
@@ -1118,7 +1023,7 @@ do_select_spill(cg_func *func, unsigned max_regs)
 		cg_instr *instr;
 
 		lifetime_tracker_start(&lctx, b);
-		for (instr = b->instr_first; instr != NULL; instr = instr->instr_next)
+		for (instr = cg_instr_first(b); instr != NULL; instr = cg_instr_next(instr))
 		{
 			unsigned n_live;
 			cg_instr *tmp;
@@ -1133,7 +1038,7 @@ do_select_spill(cg_func *func, unsigned max_regs)
 			{
 				/* Choose virtual to spill. */
 				lifetime_tracker_get_live(&lctx, live);
-				int spillv = select_virtual_to_spill(func, live, n_live--, instr->ra.pos);
+				int spillv = select_virtual_to_spill(func, live, n_live--, cg_instr_ra(instr)->pos);
 				cg_instr *spilli = func->ra.rinfo[spillv].instr;
 				assert(spilli != instr);
 				assert(spilli->op != CG_INSTR_OP_reload);
@@ -1141,8 +1046,8 @@ do_select_spill(cg_func *func, unsigned max_regs)
 				if (spilli->op == CG_INSTR_OP_phi)
 				{
 					/* Remove entire range. */
-					func->ra.rinfo[spillv].liverange = NULL;
-					spilli->ra.dbg_spill_id = spilli->ra.spill_id = curr_spill_id;
+					range_clear(func, &func->ra.rinfo[spillv].liverange);
+					cg_instr_ra(spilli)->dbg_spill_id = cg_instr_ra(spilli)->spill_id = curr_spill_id;
 				}
 				else
 				{
@@ -1153,61 +1058,63 @@ do_select_spill(cg_func *func, unsigned max_regs)
 						/* Shrink range for arg to end at start of entry block */
 						spill = cg_instr_build(func->ra.rpo[0], CG_INSTR_OP_spill);
 						grow_rinfo_as_needed(func);
-						spill->ra.pos = pos_make(0, 0);
-						func->ra.rinfo[spillv].liverange->to = spill->ra.pos;
-						func->ra.rinfo[spillv].liverange->next = NULL;
+						cg_instr_ra(spill)->pos = pos_make(0, 0);
+						range_first(&func->ra.rinfo[spillv].liverange)->to = cg_instr_ra(spill)->pos;
+						interval_set_truncate(&func->ra.rinfo[spillv].liverange, 1);
 						cg_instr_link_first(spill);
 					}
 					else
 					{
 						/* Shrink range to single minimal interval that only contains definition. */
-						spill = cg_instr_build(spilli->bb, CG_INSTR_OP_spill);
+						spill = cg_instr_build(cg_instr_bb(spilli), CG_INSTR_OP_spill);
 						grow_rinfo_as_needed(func);
-						spill->ra.pos = pos_make(spilli->ra.pos.b, spilli->ra.pos.i + 1);
-						func->ra.rinfo[spillv].liverange->to = spill->ra.pos;
-						func->ra.rinfo[spillv].liverange->next = NULL;
+						cg_instr_ra(spill)->pos = pos_make(cg_instr_ra(spilli)->pos.b, cg_instr_ra(spilli)->pos.i + 1);
+						range_first(&func->ra.rinfo[spillv].liverange)->to = cg_instr_ra(spill)->pos;
+						interval_set_truncate(&func->ra.rinfo[spillv].liverange, 1);
 						cg_instr_link_after(spilli, spill);
 					}
 
-					spill->reg = spill->ra.curr_reg = -1;
+					spill->reg = cg_instr_ra(spill)->curr_reg = -1;
 					cg_instr_arg_set_vreg(spill, 0, spilli);
-					spill->ra.dbg_spill_id = spill->ra.spill_id = curr_spill_id;
-					spilli->ra.dbg_spill_id = spilli->ra.spill_id = curr_spill_id;
+					cg_instr_ra(spill)->dbg_spill_id = cg_instr_ra(spill)->spill_id = curr_spill_id;
+					cg_instr_ra(spilli)->dbg_spill_id = cg_instr_ra(spilli)->spill_id = curr_spill_id;
 				}
 
 				lifetime_tracker_remove(&lctx, spillv);
 
 				/* Insert short virtuals for reloads immediately before all uses */
-				graph_edge *edge, *next_edge;
+				cg_instr_edge *uses = cg_instr_uses(spilli);
+				unsigned u;
 				delayed_args_idx = 0;
-				graph_marker reload_marker; /* set if use instruction already has a reload for this spill */
-				graph_marker_alloc(&func->vreg_graph_ctx, &reload_marker);
-				for (edge = graph_succ_first((graph_node *)spilli); edge != NULL; edge = next_edge)
+				for (u = 0; u < spilli->n_uses; u++)
 				{
-					next_edge = graph_succ_next(edge);
-					cg_instr *use = (cg_instr *)graph_edge_head(edge);
+					cg_instr *use = cg_instr_edge_instr(spilli, &uses[u]);
+					cg_instr *prev = cg_instr_prev(use);
 
 					/* We should not insert reloads for phi-uses since they
-					   will be handled in the ssa_deconstruciton phase. */
+					   will be handled in the ssa_deconstruciton phase. A
+					   use with more than one edge already has its reload
+					   for this spill linked right before it. */
 					if (use->op != CG_INSTR_OP_phi && use->op != CG_INSTR_OP_spill &&
-					    !graph_marker_set((graph_node *)use, &reload_marker))
+					    !(prev != NULL && prev->op == CG_INSTR_OP_reload &&
+					      cg_instr_ra(prev)->spill_id == curr_spill_id))
 					{
-						cg_instr *reload = cg_instr_build(use->bb, CG_INSTR_OP_reload);
+						cg_instr *reload = cg_instr_build(cg_instr_bb(use), CG_INSTR_OP_reload);
 						grow_rinfo_as_needed(func);
 						cg_instr_link_before(use, reload);
 						func->ra.rinfo[reload->reg].instr = reload;
-						reload->ra.dbg_spill_id = reload->ra.spill_id = curr_spill_id;
+						cg_instr_ra(reload)->dbg_spill_id = cg_instr_ra(reload)->spill_id = curr_spill_id;
 
-						struct pos from = pos_make(use->ra.pos.b, use->ra.pos.i - 1);
+						struct pos from = pos_make(cg_instr_ra(use)->pos.b, cg_instr_ra(use)->pos.i - 1);
 
-						range_add_interval(&func->ra.rinfo[reload->reg].liverange, from, use->ra.pos);
-						reload->ra.pos = from;
+						range_add_interval(func, &func->ra.rinfo[reload->reg].liverange, from, cg_instr_ra(use)->pos);
+						cg_instr_ra(reload)->pos = from;
 						lifetime_tracker_add_local(&lctx, reload);
 
 						for (i = 0; i < CG_INSTR_N_ARGS; i++)
 						{
-							if (use->args[i].kind == CG_INSTR_ARG_VREG &&
-							    spilli == (cg_instr *)graph_edge_tail(use->args[i].u.vreg))
+							if (use->arg_kind[i] == CG_INSTR_ARG_VREG &&
+							    spilli == cg_instr_arg(use, i))
 							{
 								/* Delay update of use arguments since we are currently iterating over uses */
 								delayed_args[delayed_args_idx].use = use;
@@ -1218,7 +1125,6 @@ do_select_spill(cg_func *func, unsigned max_regs)
 						}
 					}
 				}
-				graph_marker_free(&func->vreg_graph_ctx, &reload_marker);
 
 				for (i = 0; i < delayed_args_idx; i++)
 				{
@@ -1226,6 +1132,7 @@ do_select_spill(cg_func *func, unsigned max_regs)
 				}
 
 				curr_spill_id++;
+				dset_grow_universe(func->ra.equiv_spill_id, curr_spill_id);
 			}
 		}
 	}
@@ -1234,28 +1141,22 @@ do_select_spill(cg_func *func, unsigned max_regs)
 	cg_instr *phi;
 	cg_bb *b;
 
-	func->ra.equiv_spill_id = dset_create_universe(curr_spill_id);
-	for (i = 0; i < curr_spill_id; i++)
-	{
-		dset_makeset(func->ra.equiv_spill_id, i);
-	}
-
 	for (b = func->bb_first; b != NULL; b = b->bb_next)
 	{
-		for (phi = b->instr_phi_first; phi != NULL; phi = phi->instr_next)
+		for (phi = cg_instr_phi_first(b); phi != NULL; phi = cg_instr_next(phi))
 		{
-			if (phi->ra.spill_id != -1)
+			if (cg_instr_ra(phi)->spill_id != -1)
 			{
-				int phi_equiv = dset_find(func->ra.equiv_spill_id, phi->ra.spill_id);
+				int phi_equiv = dset_find(func->ra.equiv_spill_id, cg_instr_ra(phi)->spill_id);
 				cg_instr_phi_arg_iter it;
 				cg_instr *arg;
 
 				cg_instr_phi_arg_iter_init(&it, phi);
 				while ((arg = cg_instr_phi_arg_iter_next(&it, NULL)))
 				{
-					if (arg->ra.spill_id != -1)
+					if (cg_instr_ra(arg)->spill_id != -1)
 					{
-						int arg_equiv = dset_find(func->ra.equiv_spill_id, arg->ra.spill_id);
+						int arg_equiv = dset_find(func->ra.equiv_spill_id, cg_instr_ra(arg)->spill_id);
 						dset_union(func->ra.equiv_spill_id, phi_equiv, arg_equiv);
 					}
 				}
@@ -1265,7 +1166,7 @@ do_select_spill(cg_func *func, unsigned max_regs)
 
 	/* Allocate stack offsets for spill_ids */
 	int size = curr_spill_id * sizeof(func->ra.spill_slot_offsets[0]);
-	func->ra.spill_slot_offsets = malloc(size);
+	func->ra.spill_slot_offsets = arena_alloc(func->arena, size);
 	memset(func->ra.spill_slot_offsets, -1, size);
 	func->ra.n_spill_slots = 0;
 	for (i = 0; i < curr_spill_id; i++)
@@ -1290,12 +1191,12 @@ assign_color(cg_func *func, cg_instr *instr, unsigned max_regs)
 	{
 		unsigned r = preforder[i];
 
-		if (!range_test_intersect(func->ra.rinfo[r].liverange, func->ra.rinfo[instr->reg].liverange))
+		if (!range_test_intersect(&func->ra.rinfo[r].liverange, &func->ra.rinfo[instr->reg].liverange))
 		{
 			/* Reserve physical register for lifetime of virtual */
-			range_union(&func->ra.rinfo[r].liverange, func->ra.rinfo[instr->reg].liverange);
+			range_union(func, &func->ra.rinfo[r].liverange, &func->ra.rinfo[instr->reg].liverange);
 			/* Update instruction to use physical register */
-			instr->reg = instr->ra.curr_reg = r;
+			instr->reg = cg_instr_ra(instr)->curr_reg = r;
 			return;
 		}
 	}
@@ -1327,27 +1228,27 @@ gather_pre_call_post_regs(cg_func *func,
 		/* skip output of constrained instruction */
 		if (liveinstr != instr)
 		{
-			pre_regs[liveinstr->ra.curr_reg] = liveinstr;
-			post_regs[liveinstr->ra.curr_reg] = liveinstr;
+			pre_regs[cg_instr_ra(liveinstr)->curr_reg] = liveinstr;
+			post_regs[cg_instr_ra(liveinstr)->curr_reg] = liveinstr;
 
-			if (liveinstr->ra.curr_reg < 4)
+			if (cg_instr_ra(liveinstr)->curr_reg < 4)
 			{
 				live2[n_live2++] = liveinstr;
 			}
 			else
 			{
 				/* already in preserved register */
-				call_regs[liveinstr->ra.curr_reg] = liveinstr;
+				call_regs[cg_instr_ra(liveinstr)->curr_reg] = liveinstr;
 			}
 		}
 	}
 	for (i = 0; i < CG_INSTR_N_ARGS; i++)
 	{
-		if (instr->args[i].kind == CG_INSTR_ARG_VREG)
+		if (instr->arg_kind[i] == CG_INSTR_ARG_VREG)
 		{
-			cg_instr *arg = (cg_instr *)graph_edge_tail(instr->args[i].u.vreg);
-			assert(arg->ra.curr_reg >= 0 && arg->ra.curr_reg < CG_REG_VREG0);
-			pre_regs[arg->ra.curr_reg] = arg;
+			cg_instr *arg = cg_instr_arg(instr, i);
+			assert(cg_instr_ra(arg)->curr_reg >= 0 && cg_instr_ra(arg)->curr_reg < CG_REG_VREG0);
+			pre_regs[cg_instr_ra(arg)->curr_reg] = arg;
 			call_regs[i-1] = arg;
 		}
 	}
@@ -1372,7 +1273,7 @@ debug_regs(FILE *fp, char *str, cg_instr **regs, unsigned max_regs)
 		cg_instr *tmp = regs[i];
 		if (tmp)
 		{
-			fprintf(fp, "%%v%d ", tmp->ra.vreg);
+			fprintf(fp, "%%v%d ", cg_instr_ra(tmp)->vreg);
 		}
 		else
 		{
@@ -1392,7 +1293,7 @@ move_swap_current2target(cg_bb *b, cg_instr *instr, cg_instr **current_regs, cg_
 
 	for (i = 0; i < CG_REG_VREG0; i++)
 	{
-		assert(!current_regs[i] || current_regs[i]->ra.curr_reg == i);
+		assert(!current_regs[i] || cg_instr_ra(current_regs[i])->curr_reg == i);
 	}
 
 	/* Insert moves */
@@ -1406,13 +1307,13 @@ move_swap_current2target(cg_bb *b, cg_instr *instr, cg_instr **current_regs, cg_
 			if (current_regs[i] != target_regs[i] && !current_regs[i])
 			{
 				/* src -> dst */
-				const int src_reg = target_regs[i]->ra.curr_reg;
+				const int src_reg = cg_instr_ra(target_regs[i])->curr_reg;
 				const int dst_reg = i;
 				cg_instr *mov = cg_instr_build(b, CG_INSTR_OP_mov);
 				grow_rinfo_as_needed(func);
-				mov->args[0].kind = CG_INSTR_ARG_HREG;
+				mov->arg_kind[0] = CG_INSTR_ARG_HREG;
 				mov->args[0].u.hreg = src_reg;
-				mov->reg = mov->ra.curr_reg = dst_reg;
+				mov->reg = cg_instr_ra(mov)->curr_reg = dst_reg;
 				if (instr)
 				{
 					cg_instr_link_before(instr, mov);
@@ -1423,7 +1324,7 @@ move_swap_current2target(cg_bb *b, cg_instr *instr, cg_instr **current_regs, cg_
 				}
 
 				current_regs[dst_reg] = current_regs[src_reg];
-				current_regs[dst_reg]->ra.curr_reg = dst_reg;
+				cg_instr_ra(current_regs[dst_reg])->curr_reg = dst_reg;
 
 				if (current_regs[src_reg] != target_regs[src_reg])
 				{
@@ -1445,9 +1346,9 @@ move_swap_current2target(cg_bb *b, cg_instr *instr, cg_instr **current_regs, cg_
 		{
 			if (current_regs[i] != target_regs[i])
 			{
-				assert(current_regs[i]->ra.curr_reg == i);
+				assert(cg_instr_ra(current_regs[i])->curr_reg == i);
 				/* src <-> dst */
-				const int src_reg = target_regs[i]->ra.curr_reg;
+				const int src_reg = cg_instr_ra(target_regs[i])->curr_reg;
 				const int dst_reg = i;
 				insert_single_swap(b, instr, current_regs[dst_reg], current_regs[src_reg]);
 				grow_rinfo_as_needed(func);
@@ -1456,9 +1357,9 @@ move_swap_current2target(cg_bb *b, cg_instr *instr, cg_instr **current_regs, cg_
 				current_regs[dst_reg] = current_regs[src_reg];
 				current_regs[src_reg] = tmp;
 
-				const int tmpi = current_regs[dst_reg]->ra.curr_reg;
-				current_regs[dst_reg]->ra.curr_reg = current_regs[src_reg]->ra.curr_reg;
-				current_regs[src_reg]->ra.curr_reg = tmpi;
+				const int tmpi = cg_instr_ra(current_regs[dst_reg])->curr_reg;
+				cg_instr_ra(current_regs[dst_reg])->curr_reg = cg_instr_ra(current_regs[src_reg])->curr_reg;
+				cg_instr_ra(current_regs[src_reg])->curr_reg = tmpi;
 
 				keep_going = 1;
 			}
@@ -1470,7 +1371,7 @@ move_swap_current2target(cg_bb *b, cg_instr *instr, cg_instr **current_regs, cg_
 		assert(current_regs[i] == target_regs[i]);
 		if (current_regs[i])
 		{
-			current_regs[i]->ra.curr_reg = i;
+			cg_instr_ra(current_regs[i])->curr_reg = i;
 		}
 	}
 }
@@ -1489,8 +1390,8 @@ do_color_assignment(cg_func *func, unsigned max_regs)
 	{
 		cg_instr *arg = func->args[i];
 		assert(arg->op == CG_INSTR_OP_arg);
-		range_union(&func->ra.rinfo[i].liverange, func->ra.rinfo[arg->reg].liverange);
-		arg->reg = arg->ra.curr_reg = i;
+		range_union(func, &func->ra.rinfo[i].liverange, &func->ra.rinfo[arg->reg].liverange);
+		arg->reg = cg_instr_ra(arg)->curr_reg = i;
 	}
 
 	for (bix = 0; bix < func->n_bbs; bix++)
@@ -1500,13 +1401,13 @@ do_color_assignment(cg_func *func, unsigned max_regs)
 
 		lifetime_tracker_start(&lctx, b);
 
-		for (instr = b->instr_phi_first; instr != NULL; instr = instr->instr_next)
+		for (instr = cg_instr_phi_first(b); instr != NULL; instr = cg_instr_next(instr))
 		{
 			assert(instr->reg >= CG_REG_VREG0);
 			assign_color(func, instr, max_regs);
 		}
 
-		for (instr = b->instr_first; instr != NULL; instr = instr_next)
+		for (instr = cg_instr_first(b); instr != NULL; instr = instr_next)
 		{
 			cg_instr *tmp;
 			unsigned n_live;
@@ -1515,7 +1416,7 @@ do_color_assignment(cg_func *func, unsigned max_regs)
 			assert(tmp == instr);
 			assert(n_live <= max_regs && "Spilling has not lowered register usage to max_regs");
 
-			instr_next = instr->instr_next;
+			instr_next = cg_instr_next(instr);
 
 			cg_instr *pre_regs[CG_REG_VREG0];
 			cg_instr *call_regs[CG_REG_VREG0];
@@ -1540,9 +1441,9 @@ do_color_assignment(cg_func *func, unsigned max_regs)
 			}
 			else if (instr->op == CG_INSTR_OP_ret)
 			{
-				cg_instr *arg = (cg_instr *)graph_edge_tail(instr->args[0].u.vreg);
-				assert(arg->ra.curr_reg >= 0 && arg->ra.curr_reg < CG_REG_VREG0);
-				pre_regs[arg->ra.curr_reg] = arg;
+				cg_instr *arg = cg_instr_arg(instr, 0);
+				assert(cg_instr_ra(arg)->curr_reg >= 0 && cg_instr_ra(arg)->curr_reg < CG_REG_VREG0);
+				pre_regs[cg_instr_ra(arg)->curr_reg] = arg;
 				call_regs[0] = arg;
 
 				D(fprintf(stdout, "%s: ", func->name));
@@ -1552,8 +1453,8 @@ do_color_assignment(cg_func *func, unsigned max_regs)
 				D(debug_regs(stdout, "ret  ", call_regs, max_regs));
 
 				move_swap_current2target(b, instr, pre_regs, call_regs);
-				/* For consistency we need to undo the arg->ra.curr_reg change */
-				arg->ra.curr_reg = arg->reg;
+				/* For consistency we need to undo the cg_instr_ra(arg)->curr_reg change */
+				cg_instr_ra(arg)->curr_reg = arg->reg;
 			}
 
 			/* Harden arguments */
@@ -1561,12 +1462,12 @@ do_color_assignment(cg_func *func, unsigned max_regs)
 				int j;
 				for (j = 0; j < CG_INSTR_N_ARGS; j++)
 				{
-					if (instr->args[j].kind == CG_INSTR_ARG_VREG)
+					if (instr->arg_kind[j] == CG_INSTR_ARG_VREG)
 					{
-						cg_instr *arg = (cg_instr *)graph_edge_tail(instr->args[j].u.vreg);
+						cg_instr *arg = cg_instr_arg(instr, j);
 						assert(arg->reg < CG_REG_VREG0);
 
-						instr->args[j].kind = CG_INSTR_ARG_HREG;
+						instr->arg_kind[j] = CG_INSTR_ARG_HREG;
 						instr->args[j].u.hreg = arg->reg;
 					}
 				}
@@ -1590,7 +1491,7 @@ do_color_assignment(cg_func *func, unsigned max_regs)
 
 				if (instr->reg != -1)
 				{
-					instr->ra.curr_reg = 0;
+					cg_instr_ra(instr)->curr_reg = 0;
 					call_regs[0] = instr;
 					assert(!post_regs[instr->reg]);
 					post_regs[instr->reg] = instr;
@@ -1598,7 +1499,7 @@ do_color_assignment(cg_func *func, unsigned max_regs)
 
 				D(debug_regs(stdout, "call ", call_regs, max_regs));
 				D(debug_regs(stdout, "post ", post_regs, max_regs));
-				move_swap_current2target(b, instr->instr_next, call_regs, post_regs);
+				move_swap_current2target(b, cg_instr_next(instr), call_regs, post_regs);
 			}
 		}
 	}
@@ -1610,7 +1511,7 @@ queue_has(cg_instr **q, unsigned qsize, cg_instr *p)
 	unsigned i;
 	for (i = 0; i < qsize; i++)
 	{
-		if (q[i] && q[i]->ra.spill_id == -1 && q[i]->reg == p->reg)
+		if (q[i] && cg_instr_ra(q[i])->spill_id == -1 && q[i]->reg == p->reg)
 		{
 			return 1;
 		}
@@ -1637,8 +1538,8 @@ insert_safe_copies(cg_bb *b, cg_instr **src, cg_instr **dst, unsigned size)
 			}
 			assert(src[i] != NULL);
 
-			int dst_eq_spill_id = dst[i]->ra.spill_id != -1 ? dset_find(func->ra.equiv_spill_id, dst[i]->ra.spill_id) : -1;
-			int src_eq_spill_id = src[i]->ra.spill_id != -1 ? dset_find(func->ra.equiv_spill_id, src[i]->ra.spill_id) : -1;
+			int dst_eq_spill_id = cg_instr_ra(dst[i])->spill_id != -1 ? dset_find(func->ra.equiv_spill_id, cg_instr_ra(dst[i])->spill_id) : -1;
+			int src_eq_spill_id = cg_instr_ra(src[i])->spill_id != -1 ? dset_find(func->ra.equiv_spill_id, cg_instr_ra(src[i])->spill_id) : -1;
 
 			if (dst_eq_spill_id != -1 && src_eq_spill_id == -1)
 			{
@@ -1647,13 +1548,13 @@ insert_safe_copies(cg_bb *b, cg_instr **src, cg_instr **dst, unsigned size)
 				cg_instr *store = cg_instr_build(b, CG_INSTR_OP_str);
 				grow_rinfo_as_needed(func);
 				store->reg = -1; /* No output */
-				store->args[0].kind = CG_INSTR_ARG_HREG;
+				store->arg_kind[0] = CG_INSTR_ARG_HREG;
 				store->args[0].u.hreg = src[i]->reg;
-				store->args[1].kind = CG_INSTR_ARG_HREG;
+				store->arg_kind[1] = CG_INSTR_ARG_HREG;
 				store->args[1].u.hreg = CG_REG_sp;
 				store->args[1].offset = func->stack_frame_size + offset * 4;
 				cg_instr_link_last(store);
-				store->ra.dbg_spill_id = dst_eq_spill_id; /* For debug use only */
+				cg_instr_ra(store)->dbg_spill_id = dst_eq_spill_id; /* For debug use only */
 				/* Mark as done */
 				src[i] = NULL;
 				dst[i] = NULL;
@@ -1668,11 +1569,11 @@ insert_safe_copies(cg_bb *b, cg_instr **src, cg_instr **dst, unsigned size)
 					cg_instr *load = cg_instr_build(b, CG_INSTR_OP_ldr);
 					grow_rinfo_as_needed(func);
 					load->reg = dst[i]->reg;
-					load->args[0].kind = CG_INSTR_ARG_HREG;
+					load->arg_kind[0] = CG_INSTR_ARG_HREG;
 					load->args[0].u.hreg = CG_REG_sp;
 					load->args[0].offset = func->stack_frame_size + offset * 4;
 					cg_instr_link_last(load);
-					load->ra.dbg_spill_id = src_eq_spill_id; /* For debug use only */
+					cg_instr_ra(load)->dbg_spill_id = src_eq_spill_id; /* For debug use only */
 					/* Mark as done */
 					src[i] = NULL;
 					dst[i] = NULL;
@@ -1700,7 +1601,7 @@ insert_safe_copies(cg_bb *b, cg_instr **src, cg_instr **dst, unsigned size)
 				/* Insert copy */
 				cg_instr *mov = cg_instr_build(b, CG_INSTR_OP_mov);
 				grow_rinfo_as_needed(func);
-				mov->args[0].kind = CG_INSTR_ARG_HREG;
+				mov->arg_kind[0] = CG_INSTR_ARG_HREG;
 				mov->args[0].u.hreg = src[i]->reg;
 				mov->reg = dst[i]->reg;
 				cg_instr_link_last(mov);
@@ -1720,23 +1621,23 @@ insert_single_swap(cg_bb *b, cg_instr *before, cg_instr *x, cg_instr *y)
 	cg_instr *xor1 = cg_instr_build(b, CG_INSTR_OP_eor);
 	cg_instr *xor2 = cg_instr_build(b, CG_INSTR_OP_eor);
 
-	xor0->args[0].kind = CG_INSTR_ARG_HREG;
-	xor0->args[0].u.hreg = x->ra.curr_reg;
-	xor0->args[1].kind = CG_INSTR_ARG_HREG;
-	xor0->args[1].u.hreg = y->ra.curr_reg;
-	xor0->reg = xor0->ra.curr_reg = x->ra.curr_reg;
+	xor0->arg_kind[0] = CG_INSTR_ARG_HREG;
+	xor0->args[0].u.hreg = cg_instr_ra(x)->curr_reg;
+	xor0->arg_kind[1] = CG_INSTR_ARG_HREG;
+	xor0->args[1].u.hreg = cg_instr_ra(y)->curr_reg;
+	xor0->reg = cg_instr_ra(xor0)->curr_reg = cg_instr_ra(x)->curr_reg;
 
-	xor1->args[0].kind = CG_INSTR_ARG_HREG;
-	xor1->args[0].u.hreg = x->ra.curr_reg;
-	xor1->args[1].kind = CG_INSTR_ARG_HREG;
-	xor1->args[1].u.hreg = y->ra.curr_reg;
-	xor1->reg = xor1->ra.curr_reg = y->ra.curr_reg;
+	xor1->arg_kind[0] = CG_INSTR_ARG_HREG;
+	xor1->args[0].u.hreg = cg_instr_ra(x)->curr_reg;
+	xor1->arg_kind[1] = CG_INSTR_ARG_HREG;
+	xor1->args[1].u.hreg = cg_instr_ra(y)->curr_reg;
+	xor1->reg = cg_instr_ra(xor1)->curr_reg = cg_instr_ra(y)->curr_reg;
 
-	xor2->args[0].kind = CG_INSTR_ARG_HREG;
-	xor2->args[0].u.hreg = x->ra.curr_reg;
-	xor2->args[1].kind = CG_INSTR_ARG_HREG;
-	xor2->args[1].u.hreg = y->ra.curr_reg;
-	xor2->reg = xor2->ra.curr_reg = x->ra.curr_reg;
+	xor2->arg_kind[0] = CG_INSTR_ARG_HREG;
+	xor2->args[0].u.hreg = cg_instr_ra(x)->curr_reg;
+	xor2->arg_kind[1] = CG_INSTR_ARG_HREG;
+	xor2->args[1].u.hreg = cg_instr_ra(y)->curr_reg;
+	xor2->reg = cg_instr_ra(xor2)->curr_reg = cg_instr_ra(x)->curr_reg;
 
 	if (before)
 	{
@@ -1819,7 +1720,7 @@ do_ssa_deconstruction(cg_func *func)
 			cg_instr *phi;
 			unsigned idx = 0;
 
-			for (phi = b->instr_phi_first; phi != NULL; phi = phi->instr_next)
+			for (phi = cg_instr_phi_first(b); phi != NULL; phi = cg_instr_next(phi))
 			{
 				dst[idx] = phi;
 				src[idx] = cg_instr_phi_input_of(phi, pred);
@@ -1844,14 +1745,14 @@ do_insert_spill(cg_func *func)
 	{
 		cg_instr *instr, *next_instr;
 
-		for (instr = b->instr_first; instr != NULL; instr = next_instr)
+		for (instr = cg_instr_first(b); instr != NULL; instr = next_instr)
 		{
 			assert(instr->op != CG_INSTR_OP_phi);
-			next_instr = instr->instr_next;
+			next_instr = cg_instr_next(instr);
 
-			if (instr->ra.spill_id != -1)
+			if (cg_instr_ra(instr)->spill_id != -1)
 			{
-				int eq_spill_id = dset_find(func->ra.equiv_spill_id, instr->ra.spill_id);
+				int eq_spill_id = dset_find(func->ra.equiv_spill_id, cg_instr_ra(instr)->spill_id);
 
 				if (instr->op == CG_INSTR_OP_reload)
 				{
@@ -1859,11 +1760,11 @@ do_insert_spill(cg_func *func)
 					int offset = func->ra.spill_slot_offsets[eq_spill_id];
 					cg_instr *load = cg_instr_build(b, CG_INSTR_OP_ldr);
 					load->reg = instr->reg;
-					load->args[0].kind = CG_INSTR_ARG_HREG;
+					load->arg_kind[0] = CG_INSTR_ARG_HREG;
 					load->args[0].u.hreg = CG_REG_sp;
 					load->args[0].offset = func->stack_frame_size + offset * 4;
 					cg_instr_link_after(instr, load);
-					load->ra.dbg_spill_id = eq_spill_id; /* For debug use only */
+					cg_instr_ra(load)->dbg_spill_id = eq_spill_id; /* For debug use only */
 				}
 				else if (instr->op == CG_INSTR_OP_spill)
 				{
@@ -1871,13 +1772,13 @@ do_insert_spill(cg_func *func)
 					int offset = func->ra.spill_slot_offsets[eq_spill_id];
 					cg_instr *store = cg_instr_build(b, CG_INSTR_OP_str);
 					store->reg = -1; /* No output */
-					store->args[0].kind = CG_INSTR_ARG_HREG;
+					store->arg_kind[0] = CG_INSTR_ARG_HREG;
 					store->args[0].u.hreg = instr->args[0].u.hreg;
-					store->args[1].kind = CG_INSTR_ARG_HREG;
+					store->arg_kind[1] = CG_INSTR_ARG_HREG;
 					store->args[1].u.hreg = CG_REG_sp;
 					store->args[1].offset = func->stack_frame_size + offset * 4;
 					cg_instr_link_after(instr, store);
-					store->ra.dbg_spill_id = eq_spill_id; /* For debug use only */
+					cg_instr_ra(store)->dbg_spill_id = eq_spill_id; /* For debug use only */
 				}
 			}
 		}
@@ -1893,12 +1794,12 @@ do_cleanup(cg_func *func)
 	{
 		cg_instr *instr, *next_instr;
 		/* Drop phi-instructions */
-		b->instr_phi_first = NULL;
-		b->instr_phi_last = NULL;
+		b->instr_phi_first = 0;
+		b->instr_phi_last = 0;
 
-		for (instr = b->instr_first; instr != NULL; instr = next_instr)
+		for (instr = cg_instr_first(b); instr != NULL; instr = next_instr)
 		{
-			next_instr = instr->instr_next;
+			next_instr = cg_instr_next(instr);
 
 			switch (instr->op)
 			{
@@ -1930,7 +1831,7 @@ do_cleanup(cg_func *func)
 	func->stack_frame_size += func->ra.n_spill_slots * 4;
 }
 
-static void
+void
 cg_regalloc_ssa_func(cg_func *func, unsigned max_regs)
 {
 	cg_instr *phi_lift_movs[1024]; /* TODO:FIXME: */
@@ -1938,58 +1839,86 @@ cg_regalloc_ssa_func(cg_func *func, unsigned max_regs)
 	unsigned cntr = 0;
 	graph_marker marker;
 
+	max_regs = (0 < max_regs && max_regs <= CG_REG_sp) ? max_regs : CG_REG_sp;
+
+	cg_analysis_require(func, CG_ANALYSIS(CG_ANALYSIS_DOMTREE) | CG_ANALYSIS(CG_ANALYSIS_LOOPS));
+
+	interval_alloc_init(&func->ra.ival_alloc, func->arena);
 	func->ra.rinfo = calloc(func->vreg_cntr, sizeof(func->ra.rinfo[0]));
 	func->ra.n_rinfo = func->vreg_cntr;
 
 	graph_marker_alloc(&func->cfg_graph_ctx, &marker);
-	func->ra.rpo = calloc(func->n_bbs, sizeof(cg_bb *));
+	func->ra.rpo = arena_alloc(func->arena, func->n_bbs*sizeof(cg_bb *));
 	cntr = 0;
 	fill_rpo_rec(func, func->bb_first, &cntr, &marker);
 	assert(cntr == func->n_bbs);
 	graph_marker_free(&func->cfg_graph_ctx, &marker);
 
-	/* Annotate each block with its depth in the dominator tree */
-	cntr = 0;
-	annotate_w_dtpo(func, func->bb_first, &cntr);
-
 
 	/* Pristine */
 	D(debug_print_ra(func, "00_pristine", 0));
 
 	/* Phi-lifting */
+	stats_phase_begin("phi_lifting", func->name);
 	do_phi_lifting(func, phi_lift_movs, &n_phi_lift_movs);
+	stats_phase_end();
 	D(debug_print_ra(func, "01_phi_lifting", 0));
 
 	/* Build lifetime intervals */
+	stats_phase_begin("lifetime_intervals", func->name);
+#ifndef NDEBUG
+	cg_analysis_require(func, CG_ANALYSIS(CG_ANALYSIS_LIVENESS));
+#endif
 	do_lifetime_intervals(func);
+#ifndef NDEBUG
+	check_lifetime_intervals(func);
+#endif
+	stats_phase_end();
 	D(debug_print_ra(func, "02_lifetime_intervals", 1));
 
 	/* Phi-analysis */
+	stats_phase_begin("phi_analysis", func->name);
 	do_phi_analysis(func);
+	stats_phase_end();
 
 	/* Phi-mem-coalesce */
+	stats_phase_begin("phi_mem_coalesce", func->name);
 	do_phi_mem_coalesce(func, phi_lift_movs, n_phi_lift_movs);
+	stats_phase_end();
 	D(debug_print_ra(func, "03_phi_mem_coalesce", 1));
 
 	/* Select liveranges to spill */
+	stats_phase_begin("select_spill", func->name);
 	do_select_spill(func, max_regs);
+	stats_phase_end();
 	D(debug_print_ra(func, "04_select_spill", 1));
 
 	/* Color assignment */
+	stats_phase_begin("color_assignment", func->name);
 	do_color_assignment(func, max_regs);
+	stats_phase_end();
 	D(debug_print_ra(func, "05_color_assignment", 0));
 
 	/* SSA deconstruction */
+	stats_phase_begin("ssa_deconstruction", func->name);
 	do_ssa_deconstruction(func);
+	stats_phase_end();
 	D(debug_print_ra(func, "06_ssa_deconstruction", 0));
 
 	/* Insert non-phi spills */
+	stats_phase_begin("insert_spill", func->name);
 	do_insert_spill(func);
+	stats_phase_end();
 	D(debug_print_ra(func, "07_insert_spill", 0));
 
 	/* Cleanup */
+	stats_phase_begin("cleanup", func->name);
 	do_cleanup(func);
+	stats_phase_end();
 	D(debug_print_ra(func, "08_cleanup", 0));
+
+	/* Only instructions were changed, the cfg is intact */
+	cg_analysis_preserve(func, CG_ANALYSES_CFG);
 }
 
 void
@@ -1997,12 +1926,8 @@ cg_regalloc_ssa_tu(cg_tu *tu, unsigned max_regs)
 {
 	cg_func *f;
 
-	max_regs = (0 < max_regs && max_regs <= CG_REG_sp) ? max_regs : CG_REG_sp;
-
 	for (f = tu->func_first; f != NULL; f = f->func_next)
 	{
-		cg_dom_setup_dom_info(f);
-		cg_func_analyze_loops(f);
 		cg_regalloc_ssa_func(f, max_regs);
 	}
 }
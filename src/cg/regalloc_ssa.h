@@ -27,6 +27,9 @@
 #include "cg/cg.h"
 #include "ir/ir.h"
 
+void
+cg_regalloc_ssa_func(cg_func *func, unsigned max_regs);
+
 void
 cg_regalloc_ssa_tu(cg_tu *tu, unsigned max_regs);
 
@@ -23,55 +23,168 @@
 
 #include "frontend/ast_node.h"
 #include "frontend/ast_to_ir.h"
-#include "c95.tab.h"
+#include "frontend/parse_ctx.h"
 #include "ir/ir_tu.h"
+#include "ir/ir_analysis.h"
 #include "ir/ir_bb.h"
 #include "ir/ir_dom.h"
 #include "ir/ir_func.h"
 #include "ir/ir_node.h"
 #include "ir/ir_pass.h"
+#include "ir/ir_pass_mgr.h"
 #include "ir/ir_print.h"
 #include "ir_passes/mem2reg.h"
+#include "ir_passes/sra.h"
 #include "test/ir_sim.h"
 #include "cg/cg_import.h"
+#include "cg/cg_tu.h"
+#include "cg/cg_func.h"
 #include "cg/iselect.h"
 #include "cg/regalloc_ssa.h"
 #include "cg/cg_print.h"
 #include "cg/emit.h"
+#include "util/stats.h"
+#include "util/thread_pool.h"
+#include "server.h"
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-extern ast_node *root;
-extern FILE *yyin;
-int yyparse();
+void
+cg_branch_predication_func(cg_func *func);
 
 void
 cg_branch_predication_tu(cg_tu *tu);
 
-static void dummy(ir_func *f)
+static int dummy(ir_func *f)
 {
 	(void)f;
+	return 0;
 }
 
 static ir_pass pristine = {
 	"pristine",
-	dummy
+	dummy,
+	IR_ANALYSES_ALL
 };
 
 ir_pass *passlist[] = {
 	&pristine,
+	&sra,
 	&mem2reg,
 	NULL
 };
 
+/* Pipelines for -O<n>, pristine always runs first to capture the output
+   of the frontend */
+static const char *opt_levels[] = {
+	"",
+	"mem2reg",
+	"sra,mem2reg"
+};
+
+struct pass_hook_ctx {
+	unsigned idx;
+	int dump_ir;
+	const char *sim_ir_func;
+};
+
+static void after_pass(ir_pass *pass, ir_tu *itu, void *user)
+{
+	struct pass_hook_ctx *ctx = user;
+	char path[128];
+	FILE *out;
+
+	if (ctx->dump_ir)
+	{
+		snprintf(path, sizeof(path), "ir_%02d_%s.txt", ctx->idx, pass->name);
+		out = fopen(path, "w");
+		ir_print_tu(out, itu);
+		fclose(out);
+	}
+
+	if (ctx->sim_ir_func)
+	{
+		snprintf(path, sizeof(path), "sim_%02d_%s.txt", ctx->idx, pass->name);
+		out = fopen(path, "w");
+		ir_sim_func(out, itu, ctx->sim_ir_func);
+		fclose(out);
+	}
+
+	ctx->idx++;
+}
+
+/* Passes and code generation for a single function. */
+static void codegen_func(cg_tu *ctu, ir_func *f, FILE *out, unsigned max_regs)
+{
+	cg_func *cf;
+
+	stats_phase_begin("codegen", f->name);
+	stats_phase_begin("iselect", f->name);
+	cf = cg_iselect_func(ctu, f);
+	ir_func_destroy(f);
+	stats_phase_end();
+	stats_phase_begin("regalloc", cf->name);
+	cg_regalloc_ssa_func(cf, max_regs);
+	stats_phase_end();
+	stats_phase_begin("branch_predication", cf->name);
+	cg_branch_predication_func(cf);
+	stats_phase_end();
+	stats_phase_begin("emit", cf->name);
+	cg_emit_func(out, cf);
+	stats_phase_end();
+	cg_func_destroy(ctu, cf);
+	stats_phase_end();
+}
+
+/* With -j each function is compiled on its own, from IR passes to
+   emission, into a buffer of its own. The buffers are written in source
+   order so that the output does not depend on scheduling. */
+struct compile_job {
+	ir_func *f;
+	char *text;
+	size_t size;
+};
+
+struct compile_ctx {
+	cg_tu *ctu;
+	ir_pipeline *pipeline;
+	unsigned max_regs;
+};
+
+static void compile_func(void *item, unsigned thread_idx, void *user)
+{
+	struct compile_job *job = item;
+	struct compile_ctx *ctx = user;
+	FILE *out = open_memstream(&job->text, &job->size);
+
+	(void)thread_idx;
+	ir_pipeline_run_func(ctx->pipeline, job->f);
+	codegen_func(ctx->ctu, job->f, out, ctx->max_regs);
+	fclose(out);
+}
+
 static void help_exit(const char *prog)
 {
-	fprintf(stderr, "Usage: %s <input> [OPTIONS]\n", prog);
+	fprintf(stderr, "Usage: %s <input>... [OPTIONS]\n", prog);
+	fprintf(stderr, "  @<file>     read further arguments from file, separated by whitespace,\n");
+	fprintf(stderr, "              without quoting and without nested @<file>\n");
 	fprintf(stderr, "  --dump-(all|ast|ir|cg)\n");
 	fprintf(stderr, "  --sim-ir=<func>\n");
 	fprintf(stderr, "  --cg-max-regs=<n>\n");
+	fprintf(stderr, "  --passes=<pass>[,<pass>|,fixpoint(<passes>)]...\n");
+	fprintf(stderr, "  -O(0|1|2)   (default -O2)\n");
+	fprintf(stderr, "  --time-report[=json]\n");
+	fprintf(stderr, "  --mem-report[=json]\n");
+	fprintf(stderr, "  --trace=<file.json>\n");
+	fprintf(stderr, "  -j <n>      compile on n threads, functions of a single input\n");
+	fprintf(stderr, "              or whole inputs when there are several\n");
+	fprintf(stderr, "  -o <path>   output for a single input (default <input>.s)\n");
+	fprintf(stderr, "  --server=<socket>  serve compile requests on a Unix socket\n");
+	fprintf(stderr, "  --client=<socket>  forward to a server, compile here if there is none\n");
+	fprintf(stderr, "  --server-stop      with --client, stop the server\n");
 	fprintf(stderr, " The following options are for when codegen IR is imported only.\n");
 	fprintf(stderr, "  --cg-import=<path>\n");
 	fprintf(stderr, "  --cg-dump=<path>\n");
@@ -93,28 +206,771 @@ static const char *match_opt_with_value(const char *argv, const char *str)
 	return NULL;
 }
 
+/* Read in chunks rather than sizing the file up front with ftell() so
+   that pipes and FIFOs work too. */
+static char *read_file(const char *path, size_t *size)
+{
+	size_t room_for = 4096, n;
+	char *text;
+	FILE *fp;
+
+	if ((fp = fopen(path, "r")) == NULL)
+	{
+		return NULL;
+	}
+	text = malloc(room_for + 1);
+	*size = 0;
+	for (;;)
+	{
+		if (*size == room_for)
+		{
+			room_for *= 2;
+			text = realloc(text, room_for + 1);
+		}
+		n = fread(text + *size, 1, room_for - *size, fp);
+		if (n == 0)
+		{
+			break;
+		}
+		*size += n;
+	}
+	text[*size] = '\0';
+	fclose(fp);
+
+	return text;
+}
+
+static void argv_append(char ***argv, int *argc, int *room_for, char *arg)
+{
+	if (*argc == *room_for)
+	{
+		*room_for *= 2;
+		*argv = realloc(*argv, *room_for * sizeof(char *));
+	}
+	(*argv)[(*argc)++] = arg;
+}
+
+/* Replace each @<file> argument with the whitespace separated words of
+   that file. There is no quoting, so a word cannot contain whitespace,
+   and a response file cannot name another one. The strings are kept for
+   the lifetime of the process. */
+static void expand_response_files(int *argc, char ***argv)
+{
+	char **new_argv;
+	int new_argc = 0;
+	int room_for = *argc + 1;
+	int i;
+
+	new_argv = malloc(room_for * sizeof(char *));
+	for (i = 0; i < *argc; i++)
+	{
+		char *text, *word;
+		size_t size;
+
+		if (i == 0 || (*argv)[i][0] != '@')
+		{
+			argv_append(&new_argv, &new_argc, &room_for, (*argv)[i]);
+			continue;
+		}
+
+		if ((text = read_file(&(*argv)[i][1], &size)) == NULL)
+		{
+			fprintf(stderr, "%s: failed to open '%s'\n", (*argv)[0], &(*argv)[i][1]);
+			exit(1);
+		}
+
+		for (word = strtok(text, " \t\r\n"); word != NULL; word = strtok(NULL, " \t\r\n"))
+		{
+			if (word[0] == '@')
+			{
+				fprintf(stderr, "%s: '%s' names another response file, which is not supported\n", (*argv)[0], &(*argv)[i][1]);
+				exit(1);
+			}
+			argv_append(&new_argv, &new_argc, &room_for, word);
+		}
+	}
+	argv_append(&new_argv, &new_argc, &room_for, NULL);
+
+	*argc = new_argc - 1;
+	*argv = new_argv;
+}
+
+struct driver_opts {
+	const char *prog;
+	FILE *diag;
+	int dump_ast, dump_ir, dump_cg;
+	int cg_max_regs;
+	const char *sim_ir_func;
+	const char *passes;
+	const char *output;
+	unsigned jobs;
+};
+
+static void output_path(char *path, size_t size, const char *input, const struct driver_opts *opts)
+{
+	if (opts->output)
+	{
+		snprintf(path, size, "%s", opts->output);
+	}
+	else
+	{
+		snprintf(path, size, "%s.s", input);
+	}
+}
+
+/* Parse a single input and lower it to IR, NULL on failure. The parse
+   context with the AST is dropped before returning. */
+static ir_tu *parse_tu(const char *input, const struct driver_opts *opts)
+{
+	parse_ctx *pctx;
+	ast_node *root;
+	ir_tu *itu;
+	FILE *in;
+	FILE *out;
+
+	if ((in = fopen(input, "r")) == NULL)
+	{
+		fprintf(opts->diag, "%s: failed to open '%s'\n", opts->prog, input);
+		return NULL;
+	}
+	pctx = parse_ctx_create();
+	pctx->diag = opts->diag;
+	stats_phase_begin("parse", NULL);
+	root = parse_file(pctx, in);
+	stats_phase_end();
+	fclose(in);
+
+	if (root == NULL)
+	{
+		fprintf(opts->diag, "%s: failed to parse '%s'\n", opts->prog, input);
+		parse_ctx_destroy(pctx);
+		return NULL;
+	}
+
+	if (opts->dump_ast)
+	{
+		out = fopen("ast_00_pristine.txt", "w");
+		ast_node_dump_tree(out, root);
+		fclose(out);
+	}
+
+	stats_phase_begin("ast_to_ir", NULL);
+	itu = ast_to_ir(pctx);
+	stats_phase_end();
+
+	parse_ctx_destroy(pctx);
+
+	return itu;
+}
+
+/* Run the pipeline and code generation on a TU, writing <input>.s. The
+   TU is destroyed. */
+static void compile_tu(ir_tu *itu, const char *input, const struct driver_opts *opts, ir_pipeline *pipeline, unsigned n_threads)
+{
+	cg_tu *ctu;
+	char path[1024];
+	FILE *out;
+	int i;
+
+	if (n_threads <= 1)
+	{
+		struct pass_hook_ctx hook_ctx = {0, opts->dump_ir, opts->sim_ir_func};
+		ir_pipeline_run(pipeline, itu, after_pass, &hook_ctx);
+	}
+
+	if (!opts->dump_cg)
+	{
+		/* Generate code one function at a time so that only a single
+		   function body is kept in memory for each stage */
+		ir_func *f;
+
+		output_path(path, sizeof(path), input, opts);
+		out = fopen(path, "w");
+
+		stats_phase_begin("iselect", NULL);
+		ctu = cg_iselect_data(itu);
+		stats_phase_end();
+		stats_phase_begin("emit", NULL);
+		cg_emit_tu_header(out, ctu);
+		stats_phase_end();
+
+		if (n_threads <= 1)
+		{
+			for (f = itu->first_ir_func; f != NULL; f = f->tu_list_next)
+			{
+				if (ir_func_is_definition(f))
+				{
+					codegen_func(ctu, f, out, opts->cg_max_regs);
+				}
+			}
+		}
+		else
+		{
+			struct compile_ctx ctx = {ctu, pipeline, opts->cg_max_regs};
+			struct compile_job *jobs;
+			void **items;
+			unsigned n_jobs = 0;
+
+			for (f = itu->first_ir_func; f != NULL; f = f->tu_list_next)
+			{
+				n_jobs += ir_func_is_definition(f);
+			}
+
+			jobs = calloc(n_jobs, sizeof(*jobs));
+			items = calloc(n_jobs, sizeof(*items));
+			n_jobs = 0;
+			for (f = itu->first_ir_func; f != NULL; f = f->tu_list_next)
+			{
+				if (ir_func_is_definition(f))
+				{
+					jobs[n_jobs].f = f;
+					items[n_jobs] = &jobs[n_jobs];
+					n_jobs++;
+				}
+			}
+
+			thread_pool_run(n_threads, items, n_jobs, compile_func, &ctx);
+
+			for (i = 0; i < (int)n_jobs; i++)
+			{
+				fwrite(jobs[i].text, 1, jobs[i].size, out);
+				free(jobs[i].text);
+			}
+			free(items);
+			free(jobs);
+		}
+
+		fclose(out);
+		cg_tu_destroy(ctu);
+	}
+	else
+	{
+		stats_phase_begin("iselect", NULL);
+		ctu = cg_iselect_tu(itu);
+		stats_phase_end();
+		if (opts->dump_cg)
+		{
+			out = fopen("cg_00_iselect.txt", "w");
+			cg_print_tu(out, ctu);
+			fclose(out);
+		}
+
+		stats_phase_begin("regalloc", NULL);
+		cg_regalloc_ssa_tu(ctu, opts->cg_max_regs);
+		stats_phase_end();
+		if (opts->dump_cg)
+		{
+			out = fopen("cg_01_regalloc.txt", "w");
+			cg_print_tu(out, ctu);
+			fclose(out);
+		}
+
+		stats_phase_begin("branch_predication", NULL);
+		cg_branch_predication_tu(ctu);
+		stats_phase_end();
+		if (opts->dump_cg)
+		{
+			out = fopen("cg_02_branch_predication.txt", "w");
+			cg_print_tu(out, ctu);
+			fclose(out);
+		}
+
+		output_path(path, sizeof(path), input, opts);
+		out = fopen(path, "w");
+		stats_phase_begin("emit", NULL);
+		cg_emit_tu(out, ctu);
+		stats_phase_end();
+		fclose(out);
+		cg_tu_destroy(ctu);
+	}
+
+	ir_tu_destroy(itu);
+}
+
+/* In batch mode with -j the inputs are handed out to the thread pool,
+   one TU from parsing to emission per task. */
+struct tu_job {
+	const char *input;
+	int failed;
+};
+
+struct tu_ctx {
+	const struct driver_opts *opts;
+	ir_pipeline *pipeline;
+};
+
+static void compile_tu_job(void *item, unsigned thread_idx, void *user)
+{
+	struct tu_job *job = item;
+	struct tu_ctx *ctx = user;
+
+	ir_tu *itu;
+
+	(void)thread_idx;
+	if ((itu = parse_tu(job->input, ctx->opts)) == NULL)
+	{
+		job->failed = 1;
+		return;
+	}
+	compile_tu(itu, job->input, ctx->opts, ctx->pipeline, 1);
+}
+
+/* Options for compiling inputs, shared by the command line and server
+   requests. Returns 1 if argv[*i] was consumed, 0 if it is no such option
+   and -1 if it is malformed. */
+static int parse_compile_opt(int argc, char **argv, int *i, struct driver_opts *opt, const char **inputs, unsigned *n_inputs)
+{
+	const char *value;
+
+	if ((value = match_opt_with_value(argv[*i], "--cg-max-regs=")))
+	{
+		opt->cg_max_regs = strtol(value, NULL, 0);
+	}
+	else if ((value = match_opt_with_value(argv[*i], "--passes=")))
+	{
+		opt->passes = value;
+	}
+	else if (!strncmp(argv[*i], "-j", 2))
+	{
+		if ((value = match_opt_with_value(argv[*i], "-j")) == NULL)
+		{
+			if (++*i == argc)
+			{
+				return -1;
+			}
+			value = argv[*i];
+		}
+		opt->jobs = strtol(value, NULL, 0);
+	}
+	else if (!strcmp(argv[*i], "-O0") || !strcmp(argv[*i], "-O1") || !strcmp(argv[*i], "-O2"))
+	{
+		opt->passes = opt_levels[argv[*i][2] - '0'];
+	}
+	else if (!strcmp(argv[*i], "-o"))
+	{
+		if (++*i == argc)
+		{
+			return -1;
+		}
+		opt->output = argv[*i];
+	}
+	else if (argv[*i][0] != '-')
+	{
+		inputs[(*n_inputs)++] = argv[*i];
+	}
+	else
+	{
+		return 0;
+	}
+
+	return 1;
+}
+
+static ir_pipeline *build_pipeline(const char *passes)
+{
+	char spec[256];
+
+	snprintf(spec, sizeof(spec), "pristine%s%s", *passes ? "," : "", passes);
+	return ir_pipeline_parse(spec);
+}
+
+/* Compile each input to its own .s, returns the exit status */
+static int compile_inputs(struct driver_opts *opt, const char **inputs, unsigned n_inputs, ir_pipeline *pipeline)
+{
+	unsigned j;
+	int status = 0;
+
+	/* Dumps and simulation look at the whole TU between passes, with
+	   several inputs they simply end up describing the last one */
+	if (opt->dump_ast || opt->dump_ir || opt->dump_cg || opt->sim_ir_func || !ir_pipeline_is_func_local(pipeline))
+	{
+		opt->jobs = 1;
+	}
+
+	if (n_inputs > 1 && opt->jobs > 1)
+	{
+		struct tu_ctx ctx = {opt, pipeline};
+		struct tu_job *jobs = calloc(n_inputs, sizeof(*jobs));
+		void **items = calloc(n_inputs, sizeof(*items));
+
+		for (j = 0; j < n_inputs; j++)
+		{
+			jobs[j].input = inputs[j];
+			items[j] = &jobs[j];
+		}
+
+		thread_pool_run(opt->jobs, items, n_inputs, compile_tu_job, &ctx);
+
+		for (j = 0; j < n_inputs; j++)
+		{
+			status |= jobs[j].failed;
+		}
+		free(items);
+		free(jobs);
+
+		return status;
+	}
+
+	for (j = 0; j < n_inputs; j++)
+	{
+		ir_tu *itu;
+
+		/* Keep going like the threaded path does */
+		if ((itu = parse_tu(inputs[j], opt)) == NULL)
+		{
+			status = 1;
+			continue;
+		}
+		compile_tu(itu, inputs[j], opt, pipeline, opt->jobs);
+	}
+
+	return status;
+}
+
+/* The server keeps the output of the TUs it has compiled, keyed on the
+   options that affect code generation and the source text. Entries are
+   kept in least recently used order and the oldest are dropped once keys
+   and outputs together exceed OUTPUT_CACHE_MAX_BYTES. */
+#define OUTPUT_CACHE_BUCKETS 256
+#define OUTPUT_CACHE_MAX_BYTES (64UL << 20)
+
+struct cached_output {
+	struct cached_output *next;
+	struct cached_output *lru_prev;
+	struct cached_output *lru_next;
+	unsigned long hash;
+	char *key;
+	char *text;
+	size_t size;
+	size_t n_bytes; /* key and text */
+};
+
+struct output_cache {
+	struct cached_output *buckets[OUTPUT_CACHE_BUCKETS];
+	struct cached_output *lru_first; /* most recently used */
+	struct cached_output *lru_last;
+	size_t n_bytes;
+};
+
+static unsigned long hash_string(const char *str)
+{
+	unsigned long hash = 14695981039346656037UL;
+
+	while (*str)
+	{
+		hash = (hash ^ (unsigned char)*str++) * 1099511628211UL;
+	}
+	return hash;
+}
+
+static void lru_unlink(struct output_cache *cache, struct cached_output *co)
+{
+	if (co->lru_prev != NULL)
+	{
+		co->lru_prev->lru_next = co->lru_next;
+	}
+	else
+	{
+		cache->lru_first = co->lru_next;
+	}
+
+	if (co->lru_next != NULL)
+	{
+		co->lru_next->lru_prev = co->lru_prev;
+	}
+	else
+	{
+		cache->lru_last = co->lru_prev;
+	}
+}
+
+static void lru_link_first(struct output_cache *cache, struct cached_output *co)
+{
+	co->lru_prev = NULL;
+	co->lru_next = cache->lru_first;
+	if (cache->lru_first != NULL)
+	{
+		cache->lru_first->lru_prev = co;
+	}
+	else
+	{
+		cache->lru_last = co;
+	}
+	cache->lru_first = co;
+}
+
+static struct cached_output *output_cache_lookup(struct output_cache *cache, const char *key)
+{
+	unsigned long hash = hash_string(key);
+	struct cached_output *co;
+
+	for (co = cache->buckets[hash % OUTPUT_CACHE_BUCKETS]; co != NULL; co = co->next)
+	{
+		if (co->hash == hash && !strcmp(co->key, key))
+		{
+			lru_unlink(cache, co);
+			lru_link_first(cache, co);
+			return co;
+		}
+	}
+	return NULL;
+}
+
+static void output_cache_evict(struct output_cache *cache, struct cached_output *co)
+{
+	struct cached_output **link = &cache->buckets[co->hash % OUTPUT_CACHE_BUCKETS];
+
+	while (*link != co)
+	{
+		link = &(*link)->next;
+	}
+	*link = co->next;
+	lru_unlink(cache, co);
+	cache->n_bytes -= co->n_bytes;
+
+	free(co->key);
+	free(co->text);
+	free(co);
+}
+
+/* Takes ownership of key and text. An output larger than the whole cache,
+   or one already cached by an earlier input of the same request, is not
+   kept. */
+static void output_cache_insert(struct output_cache *cache, char *key, char *text, size_t size)
+{
+	size_t n_bytes = strlen(key) + 1 + size;
+	struct cached_output *co;
+
+	if (n_bytes > OUTPUT_CACHE_MAX_BYTES || output_cache_lookup(cache, key) != NULL)
+	{
+		free(key);
+		free(text);
+		return;
+	}
+
+	while (cache->n_bytes + n_bytes > OUTPUT_CACHE_MAX_BYTES)
+	{
+		output_cache_evict(cache, cache->lru_last);
+	}
+
+	co = calloc(1, sizeof(*co));
+	co->hash = hash_string(key);
+	co->key = key;
+	co->text = text;
+	co->size = size;
+	co->n_bytes = n_bytes;
+	co->next = cache->buckets[co->hash % OUTPUT_CACHE_BUCKETS];
+	cache->buckets[co->hash % OUTPUT_CACHE_BUCKETS] = co;
+	lru_link_first(cache, co);
+	cache->n_bytes += n_bytes;
+}
+
+static void output_cache_destroy(struct output_cache *cache)
+{
+	while (cache->lru_first != NULL)
+	{
+		output_cache_evict(cache, cache->lru_first);
+	}
+	free(cache);
+}
+
+static int serve_request(int argc, char **argv, FILE *diag, void *user)
+{
+	struct output_cache *cache = user;
+	struct driver_opts opt;
+	ir_pipeline *pipeline = NULL;
+	const char **inputs, **misses;
+	char **keys;
+	char path[1024];
+	unsigned n_inputs = 0, n_misses = 0, j;
+	int i, status = 1;
+
+	memset(&opt, 0, sizeof(opt));
+	opt.prog = argv[0];
+	opt.diag = diag;
+	opt.passes = opt_levels[2];
+
+	inputs = calloc(argc, sizeof(*inputs));
+	misses = calloc(argc, sizeof(*misses));
+	keys = calloc(argc, sizeof(*keys));
+
+	for (i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--server-stop"))
+		{
+			status = -1;
+			goto out;
+		}
+		if (parse_compile_opt(argc, argv, &i, &opt, inputs, &n_inputs) <= 0)
+		{
+			fprintf(diag, "%s: '%s' is not supported by the server\n", opt.prog, argv[i]);
+			goto out;
+		}
+	}
+
+	if (n_inputs == 0 || (opt.output && n_inputs > 1) || (pipeline = build_pipeline(opt.passes)) == NULL)
+	{
+		fprintf(diag, "%s: bad request\n", opt.prog);
+		goto out;
+	}
+
+	for (j = 0; j < n_inputs; j++)
+	{
+		struct cached_output *co;
+		size_t size, key_size;
+		char *text;
+		FILE *key;
+
+		if ((text = read_file(inputs[j], &size)) == NULL)
+		{
+			fprintf(diag, "%s: failed to open '%s'\n", opt.prog, inputs[j]);
+			goto out;
+		}
+		key = open_memstream(&keys[j], &key_size);
+		fprintf(key, "%s\n%d\n%s", opt.passes, opt.cg_max_regs, text);
+		fclose(key);
+		free(text);
+
+		if ((co = output_cache_lookup(cache, keys[j])) != NULL)
+		{
+			FILE *fp;
+
+			output_path(path, sizeof(path), inputs[j], &opt);
+			if ((fp = fopen(path, "w")) == NULL)
+			{
+				fprintf(diag, "%s: failed to open '%s'\n", opt.prog, path);
+				goto out;
+			}
+			fwrite(co->text, 1, co->size, fp);
+			fclose(fp);
+			free(keys[j]);
+			keys[j] = NULL;
+		}
+		else
+		{
+			keys[n_misses] = keys[j];
+			misses[n_misses++] = inputs[j];
+			if (n_misses - 1 != j)
+			{
+				keys[j] = NULL;
+			}
+		}
+	}
+
+	if ((status = compile_inputs(&opt, misses, n_misses, pipeline)) == 0)
+	{
+		for (j = 0; j < n_misses; j++)
+		{
+			size_t size;
+			char *text;
+
+			output_path(path, sizeof(path), misses[j], &opt);
+			if ((text = read_file(path, &size)) != NULL)
+			{
+				output_cache_insert(cache, keys[j], text, size);
+				keys[j] = NULL;
+			}
+		}
+	}
+
+out:
+	for (j = 0; j < n_inputs; j++)
+	{
+		free(keys[j]);
+	}
+	if (pipeline != NULL)
+	{
+		ir_pipeline_destroy(pipeline);
+	}
+	free(keys);
+	free(misses);
+	free(inputs);
+
+	return status;
+}
+
+static int run_server(const char *path, const char *prog)
+{
+	struct output_cache *cache = calloc(1, sizeof(*cache));
+	int ok;
+
+	if (!(ok = server_run(path, serve_request, cache)))
+	{
+		fprintf(stderr, "%s: failed to serve on '%s': %s\n", prog, path, strerror(errno));
+	}
+	output_cache_destroy(cache);
+
+	return !ok;
+}
+
 int main(int argc, char **argv)
 {
-	FILE *in = NULL;
 	FILE *out = NULL;
-	ir_tu *itu = NULL;
 	cg_tu *ctu = NULL;
+	ir_pipeline *pipeline;
+	const char **inputs;
+	unsigned n_inputs = 0;
+	int status;
 	int i;
 
-	struct {
-		int dump_ast, dump_ir, dump_cg;
-		int cg_max_regs;
-		const char *input;
-		const char *sim_ir_func;
-	} opt;
+	struct driver_opts opt;
 
 	memset(&opt, 0, sizeof(opt));
+	opt.prog = argv[0];
+	opt.diag = stderr;
+	opt.passes = opt_levels[2];
+
+	for (i = 0; passlist[i] != NULL; i++)
+	{
+		ir_pass_register(passlist[i]);
+	}
+
+	expand_response_files(&argc, &argv);
+	inputs = calloc(argc, sizeof(*inputs));
 
 	for (i = 1; i < argc; i++)
 	{
 		const char *value;
 
-		if (!strcmp(argv[i], "--dump-all"))
+		if ((value = match_opt_with_value(argv[i], "--server=")))
+		{
+			return run_server(value, argv[0]);
+		}
+		else if ((value = match_opt_with_value(argv[i], "--client=")))
+		{
+			/* Forward everything else, compile here if there is no
+			   server */
+			memmove(&argv[i], &argv[i + 1], (argc - i) * sizeof(char *));
+			argc--;
+			if ((status = server_forward(value, argc, argv)) >= 0)
+			{
+				return status;
+			}
+			for (i = 1; i < argc; i++)
+			{
+				if (!strcmp(argv[i], "--server-stop"))
+				{
+					fprintf(stderr, "%s: no server running on '%s'\n", argv[0], value);
+					return 0;
+				}
+			}
+			break;
+		}
+	}
+
+	for (i = 1; i < argc; i++)
+	{
+		const char *value;
+		int consumed;
+
+		if ((consumed = parse_compile_opt(argc, argv, &i, &opt, inputs, &n_inputs)) != 0)
+		{
+			if (consumed < 0)
+			{
+				help_exit(argv[0]);
+			}
+		}
+		else if (!strcmp(argv[i], "--dump-all"))
 		{
 			opt.dump_ast = 1;
 			opt.dump_ir = 1;
@@ -136,9 +992,21 @@ int main(int argc, char **argv)
 		{
 			opt.sim_ir_func = value;
 		}
-		else if ((value = match_opt_with_value(argv[i], "--cg-max-regs=")))
+		else if (!strcmp(argv[i], "--time-report") || !strcmp(argv[i], "--time-report=json"))
+		{
+			stats_enable(STATS_TIME, argv[i][13] ? STATS_FORMAT_JSON : STATS_FORMAT_TABLE);
+		}
+		else if (!strcmp(argv[i], "--mem-report") || !strcmp(argv[i], "--mem-report=json"))
 		{
-			opt.cg_max_regs = strtol(value, NULL, 0);
+			stats_enable(STATS_MEM, argv[i][12] ? STATS_FORMAT_JSON : STATS_FORMAT_TABLE);
+		}
+		else if ((value = match_opt_with_value(argv[i], "--trace=")))
+		{
+			if (!stats_trace_open(value))
+			{
+				fprintf(stderr, "%s: failed to open '%s'\n", argv[0], value);
+				exit(1);
+			}
 		}
 		else if ((value = match_opt_with_value(argv[i], "--cg-import=")))
 		{
@@ -171,106 +1039,28 @@ int main(int argc, char **argv)
 			fclose(out);
 			exit(0);
 		}
-		else if (!strncmp(argv[i], "--", 2))
-		{
-			help_exit(argv[0]);
-		}
 		else
 		{
-			if (opt.input)
-			{
-				help_exit(argv[0]);
-			}
-			opt.input = argv[i];
+			help_exit(argv[0]);
 		}
 	}
 
-	if (!opt.input)
+	if (n_inputs == 0 || (opt.output && n_inputs > 1))
 	{
 		help_exit(argv[0]);
 	}
 
-	if ((in = fopen(opt.input, "r")) == NULL)
-	{
-		fprintf(stderr, "%s: failed to open '%s'\n", argv[0], opt.input);
-		exit(1);
-	}
-	yyin = in;
-	do {
-		yyparse();
-	} while (!feof(in));
-	fclose(in);
-
-	if (opt.dump_ast)
-	{
-		out = fopen("ast_00_pristine.txt", "w");
-		ast_node_dump_tree(out, root);
-		fclose(out);
-	}
-
-	itu = ast_to_ir(root);
-
-	for (i = 0; passlist[i] != NULL; i++)
+	if ((pipeline = build_pipeline(opt.passes)) == NULL)
 	{
-		char path[128];
-		ir_func *f;
-		for (f = itu->first_ir_func; f != NULL; f = f->tu_list_next)
-		{
-			if (ir_func_is_definition(f))
-			{
-				passlist[i]->func(f);
-				ir_func_free_unused_nodes(f);
-			}
-		}
-
-		if (opt.dump_ir)
-		{
-			snprintf(path, sizeof(path), "ir_%02d_%s.txt", i, passlist[i]->name);
-			out = fopen(path, "w");
-			ir_print_tu(out, itu);
-			fclose(out);
-		}
-
-		if (opt.sim_ir_func)
-		{
-			snprintf(path, sizeof(path), "sim_%02d_%s.txt", i, passlist[i]->name);
-			out = fopen(path, "w");
-			ir_sim_func(out, itu, opt.sim_ir_func);
-			fclose(out);
-		}
+		help_exit(argv[0]);
 	}
 
-	{
-		char path[128];
-		ctu = cg_iselect_tu(itu);
-		if (opt.dump_cg)
-		{
-			out = fopen("cg_00_iselect.txt", "w");
-			cg_print_tu(out, ctu);
-			fclose(out);
-		}
-
-		cg_regalloc_ssa_tu(ctu, opt.cg_max_regs);
-		if (opt.dump_cg)
-		{
-			out = fopen("cg_01_regalloc.txt", "w");
-			cg_print_tu(out, ctu);
-			fclose(out);
-		}
-
-		cg_branch_predication_tu(ctu);
-		if (opt.dump_cg)
-		{
-			out = fopen("cg_02_branch_predication.txt", "w");
-			cg_print_tu(out, ctu);
-			fclose(out);
-		}
+	status = compile_inputs(&opt, inputs, n_inputs, pipeline);
 
-		snprintf(path, sizeof(path), "%s.s", opt.input);
-		out = fopen(path, "w");
-		cg_emit_tu(out, ctu);
-		fclose(out);
-	}
+	free(inputs);
+	ir_pipeline_destroy(pipeline);
+	stats_trace_close();
+	stats_report(stderr);
 
-	return 0;
+	return status;
 }
@@ -22,12 +22,11 @@
  */
 
 #include "ast_node.h"
+#include "util/arena.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 
-ast_node *root;
-
 const char *ast_op_to_str[] = {
 #define DEF_AST_OP(x) #x,
 #include "ast_op.def"
@@ -76,37 +75,49 @@ dump_tree_worker(FILE *fp, ast_node *n, char *indent_buf, int indent_pos)
     }
 }
 
+void *
+ast_alloc(parse_ctx *ctx, unsigned size)
+{
+	return arena_alloc(ctx->arena, size);
+}
+
+char *
+ast_strdup(parse_ctx *ctx, const char *str)
+{
+	return arena_strdup(ctx->arena, str);
+}
+
 void
 ast_node_dump_tree(FILE *fp, ast_node *n)
 {
 	char buf[128];
-	dump_tree_worker(fp, root, buf, 0);
+	dump_tree_worker(fp, n, buf, 0);
 }
 
 ast_node *
-ast_node_build0(ast_op op)
+ast_node_build0(parse_ctx *ctx, ast_op op)
 {
 	ast_node *n;
-	n = calloc(1, sizeof(ast_node));
+	n = ast_alloc(ctx, sizeof(ast_node));
 	n->op = op;
 	return n;
 }
 
 ast_node *
-ast_node_build1(ast_op op, ast_node *n1)
+ast_node_build1(parse_ctx *ctx, ast_op op, ast_node *n1)
 {
 	ast_node *n;
-	n = calloc(1, sizeof(ast_node));
+	n = ast_alloc(ctx, sizeof(ast_node));
 	n->op = op;
 	n->child = n1;
 	return n;
 }
 
 ast_node *
-ast_node_build2(ast_op op, ast_node *n1, ast_node *n2)
+ast_node_build2(parse_ctx *ctx, ast_op op, ast_node *n1, ast_node *n2)
 {
 	ast_node *n;
-	n = calloc(1, sizeof(ast_node));
+	n = ast_alloc(ctx, sizeof(ast_node));
 	n->op = op;
 	n->child = n1;
 	n->child->sibling = n2;
@@ -114,10 +125,10 @@ ast_node_build2(ast_op op, ast_node *n1, ast_node *n2)
 }
 
 ast_node *
-ast_node_build3(ast_op op, ast_node *n1, ast_node *n2, ast_node *n3)
+ast_node_build3(parse_ctx *ctx, ast_op op, ast_node *n1, ast_node *n2, ast_node *n3)
 {
 	ast_node *n;
-	n = calloc(1, sizeof(ast_node));
+	n = ast_alloc(ctx, sizeof(ast_node));
 	n->op = op;
 	n->child = n1;
 	n->child->sibling = n2;
@@ -127,10 +138,10 @@ ast_node_build3(ast_op op, ast_node *n1, ast_node *n2, ast_node *n3)
 }
 
 ast_node *
-ast_node_build4(ast_op op, ast_node *n1, ast_node *n2, ast_node *n3, ast_node *n4)
+ast_node_build4(parse_ctx *ctx, ast_op op, ast_node *n1, ast_node *n2, ast_node *n3, ast_node *n4)
 {
 	ast_node *n;
-	n = calloc(1, sizeof(ast_node));
+	n = ast_alloc(ctx, sizeof(ast_node));
 	n->op = op;
 	n->child = n1;
 	n->child->sibling = n2;
@@ -24,6 +24,8 @@
 #ifndef AST_NODE_H
 #define AST_NODE_H
 
+#include "frontend/parse_ctx.h"
+
 #include <stdio.h>
 
 typedef enum ast_op {
@@ -65,20 +67,28 @@ typedef struct ast_node {
 	} u;
 } ast_node;
 
+/* The AST, symbols, typedefs and token strings all live in the arena of
+   the parse context and go away with it */
+void *
+ast_alloc(parse_ctx *ctx, unsigned size);
+
+char *
+ast_strdup(parse_ctx *ctx, const char *str);
+
 ast_node *
-ast_node_build0(ast_op op);
+ast_node_build0(parse_ctx *ctx, ast_op op);
 
 ast_node *
-ast_node_build1(ast_op op, ast_node *n1);
+ast_node_build1(parse_ctx *ctx, ast_op op, ast_node *n1);
 
 ast_node *
-ast_node_build2(ast_op op, ast_node *n1, ast_node *n2);
+ast_node_build2(parse_ctx *ctx, ast_op op, ast_node *n1, ast_node *n2);
 
 ast_node *
-ast_node_build3(ast_op op, ast_node *n1, ast_node *n2, ast_node *n3);
+ast_node_build3(parse_ctx *ctx, ast_op op, ast_node *n1, ast_node *n2, ast_node *n3);
 
 ast_node *
-ast_node_build4(ast_op op, ast_node *n1, ast_node *n2, ast_node *n3, ast_node *n4);
+ast_node_build4(parse_ctx *ctx, ast_op op, ast_node *n1, ast_node *n2, ast_node *n3, ast_node *n4);
 
 ast_node *
 ast_node_append_sibling(ast_node *n, ast_node *n1);
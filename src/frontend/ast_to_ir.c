@@ -40,6 +40,7 @@
 #define D(x)
 
 typedef struct ast2ir_ctx {
+	parse_ctx *pctx;
 	ir_tu *tu;
 	ir_func *func;
 	ir_bb *entry_bb;
@@ -54,13 +55,13 @@ typedef struct ast2ir_ctx {
 static ir_node * build_expr(ast2ir_ctx *ctx, ast_node *ast_expr);
 
 
-static void fill_type_info(type_info *ti, ast_node *ts)
+static void fill_type_info(parse_ctx *pctx, type_info *ti, ast_node *ts)
 {
 	assert(ts->op == AST_OP_TYPE_SPECIFIER);
 	switch (ts->child->op)
 	{
 	case AST_OP_TYPE_NAME:
-		fill_type_info(ti, ast_type_lookup(ts->child->u.strvalue));
+		fill_type_info(pctx, ti, ast_type_lookup(pctx, ts->child->u.strvalue));
 		break;
 	case AST_OP_INT:
 		ti->basic_type = T_SIGNED_INT;
@@ -206,14 +207,14 @@ apply_usual_assign_conv(ast2ir_ctx *ctx, type_info *lhs_ti, type_info *rhs_ti, i
 	return res;
 }
 
-static ir_type type_get_ir(ast_node *ts)
+static ir_type type_get_ir(parse_ctx *pctx, ast_node *ts)
 {
 	ir_type type = i32;
 	assert(ts->op == AST_OP_TYPE_SPECIFIER);
 	switch (ts->child->op)
 	{
 	case AST_OP_TYPE_NAME:
-		type = type_get_ir(ast_type_lookup(ts->child->u.strvalue));
+		type = type_get_ir(pctx, ast_type_lookup(pctx, ts->child->u.strvalue));
 		break;
 	case AST_OP_INT:
 		type = i32;
@@ -306,13 +307,13 @@ static ir_node * build_addr(ast2ir_ctx *ctx, ast_node *n, ast_node **type_spec,
 
 	if (n->op == AST_OP_IDENTIFIER)
 	{
-		symbol *sym = symbol_lookup(n->u.strvalue);
+		symbol *sym = symbol_lookup(ctx->pctx, n->u.strvalue);
 		addr = sym->alloca;
 		if (type_spec) *type_spec = sym->type_spec;
 		if (is_pointer) *is_pointer = sym->is_pointer;
 		if (is_array) *is_array = sym->is_array;
 
-		fill_type_info(&n->ti, sym->type_spec);
+		fill_type_info(ctx->pctx, &n->ti, sym->type_spec);
 		if (sym->is_pointer)
 		{
 			n->ti.basic_type = T_POINTER;
@@ -336,7 +337,7 @@ static ir_node * build_addr(ast2ir_ctx *ctx, ast_node *n, ast_node **type_spec,
 		}
 		assert(child1->op == AST_OP_IDENTIFIER);
 		/* Find offset of child1 in type0. child1 has type1 */
-		u = ast_type_get_member_offset(type0, child1->u.strvalue, &type1, &is_pointer1);
+		u = ast_type_get_member_offset(ctx->pctx, type0, child1->u.strvalue, &type1, &is_pointer1);
 		off = ir_node_build_const(ctx->current_bb, i32, u);
 		addr = ir_node_build2(ctx->current_bb, IR_OP_add, p32, addr, off);
 		if (type_spec) *type_spec = type1;
@@ -363,13 +364,13 @@ static ir_node * build_addr(ast2ir_ctx *ctx, ast_node *n, ast_node **type_spec,
 			addr = ir_node_build1(ctx->current_bb, IR_OP_load, p32, addr);
 		}
 		idx = build_expr(ctx, child1);
-		u = ast_type_get_size(type0);
+		u = ast_type_get_size(ctx->pctx, type0);
 		esize = ir_node_build_const(ctx->current_bb, i32, u);
 		off = ir_node_build2(ctx->current_bb, IR_OP_mul, i32, idx, esize);
 		addr = ir_node_build2(ctx->current_bb, IR_OP_add, p32, addr, off);
 		if (type_spec) *type_spec = type0;
 
-		fill_type_info(&n->ti, type0);
+		fill_type_info(ctx->pctx, &n->ti, type0);
 	}
 
 	return addr;
@@ -401,7 +402,7 @@ static ir_node * build_expr(ast2ir_ctx *ctx, ast_node *ast_expr)
 			ir_node *tmp;
 			ast_node *type_spec;
 			addr = build_addr(ctx, ast_expr->child, &type_spec, NULL, NULL);
-			ir_type type = type_get_ir(type_spec);
+			ir_type type = type_get_ir(ctx->pctx, type_spec);
 			tmp = ir_node_build1(ctx->current_bb, IR_OP_load, p32, addr);
 			return ir_node_build1(ctx->current_bb, IR_OP_load, type, tmp);
 		}
@@ -466,7 +467,7 @@ static ir_node * build_expr(ast2ir_ctx *ctx, ast_node *ast_expr)
 			}
 			else
 			{
-				fill_type_info(&ast_expr->ti, type_spec);
+				fill_type_info(ctx->pctx, &ast_expr->ti, type_spec);
 			}
 
 			if (is_array)
@@ -475,7 +476,7 @@ static ir_node * build_expr(ast2ir_ctx *ctx, ast_node *ast_expr)
 			}
 			else
 			{
-				ir_type type = is_pointer ? p32 : type_get_ir(type_spec);
+				ir_type type = is_pointer ? p32 : type_get_ir(ctx->pctx, type_spec);
 				return ir_node_build1(ctx->current_bb, IR_OP_load, type, addr);
 			}
 		}
@@ -507,7 +508,7 @@ static ir_node * build_expr(ast2ir_ctx *ctx, ast_node *ast_expr)
 				args[n_args++] = tmp;
 			}
 
-			fill_type_info(&ast_expr->ti, ast_func->child->child);
+			fill_type_info(ctx->pctx, &ast_expr->ti, ast_func->child->child);
 
 			return ir_node_build_call(ctx->current_bb, target_func, target_func->ret_type, n_args, args);
 		}
@@ -520,7 +521,7 @@ static ir_node * build_expr(ast2ir_ctx *ctx, ast_node *ast_expr)
 			assert(ast_expr->child->op == AST_OP_SPECIFIER_QUALIFIER_LIST);
 			ts = ast_expr->child->child;
 			assert(ts->op == AST_OP_TYPE_SPECIFIER);
-			fill_type_info(&ast_expr->ti, ts);
+			fill_type_info(ctx->pctx, &ast_expr->ti, ts);
 			rhs_ir = build_expr(ctx, rhs);
 			return apply_usual_assign_conv(ctx, &ast_expr->ti, &rhs->ti, rhs_ir);
 		}
@@ -536,7 +537,7 @@ static ir_node * build_expr(ast2ir_ctx *ctx, ast_node *ast_expr)
 			ir_type type;
 
 			lhs_addr = build_addr(ctx, lhs, &lhs_type, &lhs_is_pointer, NULL);
-			type = lhs_is_pointer ? p32 : type_get_ir(lhs_type);
+			type = lhs_is_pointer ? p32 : type_get_ir(ctx->pctx, lhs_type);
 			rhs_ir = build_expr(ctx, rhs);
 			rhs_ir = apply_usual_assign_conv(ctx, &lhs->ti, &rhs->ti, rhs_ir);
 			(void)ir_node_build2(ctx->current_bb, IR_OP_store, type, lhs_addr, rhs_ir);
@@ -565,7 +566,7 @@ static ir_node * build_expr(ast2ir_ctx *ctx, ast_node *ast_expr)
 			op = ast_op_2_ir_op(ast_expr->op);
 			rhs_ir = build_expr(ctx, rhs);
 			lhs_addr = build_addr(ctx, lhs, &lhs_type, NULL, NULL);
-			type = type_get_ir(lhs_type);
+			type = type_get_ir(ctx->pctx, lhs_type);
 			lhs_load = ir_node_build1(ctx->current_bb, IR_OP_load, type, lhs_addr);
 
 			type_info ti1, ti2;
@@ -608,13 +609,13 @@ static ir_node * build_expr(ast2ir_ctx *ctx, ast_node *ast_expr)
 			if (lhs_is_pointer)
 			{
 				lhs_load = ir_node_build1(ctx->current_bb, IR_OP_load, p32, lhs_addr);
-				lhs_tmp = ir_node_build_const(ctx->current_bb, i32, ast_type_get_size(lhs_type));
+				lhs_tmp = ir_node_build_const(ctx->current_bb, i32, ast_type_get_size(ctx->pctx, lhs_type));
 				lhs_tmp = ir_node_build2(ctx->current_bb, op, p32, lhs_load, lhs_tmp);
 				(void)ir_node_build2(ctx->current_bb, IR_OP_store, p32, lhs_addr, lhs_tmp);
 			}
 			else
 			{
-				type = type_get_ir(lhs_type);
+				type = type_get_ir(ctx->pctx, lhs_type);
 				lhs_load = ir_node_build1(ctx->current_bb, IR_OP_load, type, lhs_addr);
 				lhs_tmp = ir_node_build_const(ctx->current_bb, type, 1);
 				lhs_tmp = ir_node_build2(ctx->current_bb, op, type, lhs_load, lhs_tmp);
@@ -678,7 +679,7 @@ static ir_node * build_expr(ast2ir_ctx *ctx, ast_node *ast_expr)
 					assert(child1->is_pointer);
 					assert(ir_node_type(ir2) != p32);
 					type = ir_node_type(ir1);
-					stride = ir_node_build_const(ctx->current_bb, ir_node_type(ir2), ast_type_get_size(child1->type));
+					stride = ir_node_build_const(ctx->current_bb, ir_node_type(ir2), ast_type_get_size(ctx->pctx, child1->type));
 					ir2 = ir_node_build2(ctx->current_bb, IR_OP_mul, ir_node_type(ir2), ir2, stride);
 				}
 				else if (ir_node_type(ir2) == p32)
@@ -686,7 +687,7 @@ static ir_node * build_expr(ast2ir_ctx *ctx, ast_node *ast_expr)
 					assert(child2->is_pointer);
 					assert(ir_node_type(ir1) != p32);
 					type = ir_node_type(ir2);
-					stride = ir_node_build_const(ctx->current_bb, ir_node_type(ir1), ast_type_get_size(child2->type));
+					stride = ir_node_build_const(ctx->current_bb, ir_node_type(ir1), ast_type_get_size(ctx->pctx, child2->type));
 					ir1 = ir_node_build2(ctx->current_bb, IR_OP_mul, ir_node_type(ir1), ir1, stride);
 				}
 			}
@@ -750,12 +751,12 @@ static void build_stmt(ast2ir_ctx *ctx, ast_node *ast_stmt)
 	case AST_OP_COMPOUND_STATEMENT:
 		{
 			ast_node *stmt;
-			symbol_scope_push();
+			symbol_scope_push(ctx->pctx);
 			for (stmt = ast_stmt->child; stmt != NULL; stmt = stmt->sibling)
 			{
 				build_stmt(ctx, stmt);
 			}
-			symbol_scope_pop();
+			symbol_scope_pop(ctx->pctx);
 		}
 		break;
 
@@ -785,9 +786,9 @@ static void build_stmt(ast2ir_ctx *ctx, ast_node *ast_stmt)
 			    ast_stmt->child->child->child->child->sibling->sibling != NULL)
 			{
 				const char *str = ast_stmt->child->child->child->child->sibling->u.strvalue;
-				ast_type_insert(str, ast_stmt->child->child);
+				ast_type_insert(ctx->pctx, str, ast_stmt->child->child);
 			}
-			type_size = ast_type_get_size(ast_stmt->child->child);
+			type_size = ast_type_get_size(ctx->pctx, ast_stmt->child->child);
 
 			assert(ast_stmt->child->sibling->op == AST_OP_INIT_DECLARATOR_LIST);
 			for (n = ast_stmt->child->sibling->child; n != NULL; n = n->sibling)
@@ -832,10 +833,10 @@ static void build_stmt(ast2ir_ctx *ctx, ast_node *ast_stmt)
 				}
 				assert(id->op == AST_OP_IDENTIFIER);
 
-				assert(!symbol_lookup(id->u.strvalue) &&
+				assert(!symbol_lookup(ctx->pctx, id->u.strvalue) &&
 				       "Redeclaration of symbol!");
 
-				sym = symbol_insert(id->u.strvalue);
+				sym = symbol_insert(ctx->pctx, id->u.strvalue);
 				sym->type_spec = ast_stmt->child->child;
 				sym->alloca = ir_node_build_alloca(ctx->entry_bb, (is_pointer ? 4 : type_size)*array_size, 1);
 				sym->is_pointer = is_pointer;
@@ -849,7 +850,7 @@ static void build_stmt(ast2ir_ctx *ctx, ast_node *ast_stmt)
 					ir_node *in = build_expr(ctx, n->child->sibling);
 					type_info lhs_ti;
 
-					fill_type_info(&lhs_ti, sym->type_spec);
+					fill_type_info(ctx->pctx, &lhs_ti, sym->type_spec);
 					in = apply_usual_assign_conv(ctx, &lhs_ti, &n->child->sibling->ti, in);
 
 					ir_node_build2(ctx->current_bb, IR_OP_store, ir_node_type(in), sym->alloca, in);
@@ -1107,7 +1108,7 @@ static void handle_declaration(ast2ir_ctx *ctx, ast_node *ast_decl)
 		unsigned n_params = 0;
 		int is_variadic = 0;
 
-		ret_type = dr->child->op == AST_OP_POINTER ? p32 : type_get_ir(ds->child);
+		ret_type = dr->child->op == AST_OP_POINTER ? p32 : type_get_ir(ctx->pctx, ds->child);
 
 		for (pd = dd->sibling->child; pd != NULL; pd = pd->sibling)
 		{
@@ -1120,7 +1121,7 @@ static void handle_declaration(ast2ir_ctx *ctx, ast_node *ast_decl)
 				}
 				else
 				{
-					param_types[n_params++] = type_get_ir(pd->child->child);
+					param_types[n_params++] = type_get_ir(ctx->pctx, pd->child->child);
 				}
 			}
 			else
@@ -1145,7 +1146,7 @@ static void handle_declaration(ast2ir_ctx *ctx, ast_node *ast_decl)
 	else
 	{
 		/* global variable declaration */
-		unsigned size = ast_type_get_size(ds->child);
+		unsigned size = ast_type_get_size(ctx->pctx, ds->child);
 		(void)ir_data_build(ctx->tu, id->u.strvalue, size, 4, NULL);
 	}
 }
@@ -1164,7 +1165,7 @@ static void handle_function_definition(ast2ir_ctx *ctx, ast_node *ast_func) /* T
 	assert(dr->op == AST_OP_DECLARATOR);
 	assert(cs->op == AST_OP_COMPOUND_STATEMENT);
 
-	ret_type = type_get_ir(ds->child);
+	ret_type = type_get_ir(ctx->pctx, ds->child);
 
 	assert(dr->child->op == AST_OP_DIRECT_DECLARATOR);
 	assert(dr->child->child->op == AST_OP_DIRECT_DECLARATOR);
@@ -1183,7 +1184,7 @@ static void handle_function_definition(ast2ir_ctx *ctx, ast_node *ast_func) /* T
 		}
 		else
 		{
-			param_types[n_params++] = type_get_ir(pd->child->child);
+			param_types[n_params++] = type_get_ir(ctx->pctx, pd->child->child);
 		}
 	}
 
@@ -1220,9 +1221,9 @@ static void handle_function_definition(ast2ir_ctx *ctx, ast_node *ast_func) /* T
 		assert(tmp->child->op == AST_OP_IDENTIFIER);
 
 		id = tmp->child;
-		size = ast_type_get_size(pd->child->child);
+		size = ast_type_get_size(ctx->pctx, pd->child->child);
 
-		sym = symbol_insert(id->u.strvalue);
+		sym = symbol_insert(ctx->pctx, id->u.strvalue);
 		sym->type_spec = pd->child->child;
 		sym->alloca = ir_node_build_alloca(ctx->entry_bb, is_pointer ? 4 : size, 1);
 		sym->is_pointer = is_pointer;
@@ -1250,15 +1251,16 @@ static void handle_function_definition(ast2ir_ctx *ctx, ast_node *ast_func) /* T
 	ir_bb_build_br(ctx->current_bb, ctx->exit_bb);
 }
 
-ir_tu * ast_to_ir(ast_node *root)
+ir_tu * ast_to_ir(parse_ctx *pctx)
 {
 	ast2ir_ctx ctx_, *ctx = &ctx_;
 	ast_node *tu;
 	ast_node *child;
-	assert(root->op == AST_OP_TU);
-	tu = root;
+	assert(pctx->root->op == AST_OP_TU);
+	tu = pctx->root;
 
 	memset(ctx, 0, sizeof(*ctx));
+	ctx->pctx = pctx;
 
 	ctx->tu = calloc(1, sizeof(ir_tu));
 
@@ -1266,9 +1268,9 @@ ir_tu * ast_to_ir(ast_node *root)
 	{
 		if (child->op == AST_OP_FUNCTION_DEF)
 		{
-			symbol_scope_push();
+			symbol_scope_push(ctx->pctx);
 			handle_function_definition(ctx, child);
-			symbol_scope_pop();
+			symbol_scope_pop(ctx->pctx);
 		}
 		else
 		{
@@ -27,6 +27,6 @@
 #include "frontend/ast_node.h"
 #include "ir/ir.h"
 
-ir_tu * ast_to_ir(ast_node *root);
+ir_tu * ast_to_ir(parse_ctx *pctx);
 
 #endif
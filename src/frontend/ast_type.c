@@ -34,24 +34,22 @@ struct type {
 	struct ast_node *type_spec;
 };
 
-static struct type *type_first = NULL;
-
 void
-ast_type_insert(const char *name, ast_node *ts)
+ast_type_insert(parse_ctx *ctx, const char *name, ast_node *ts)
 {
-	struct type *tmp = calloc(1, sizeof(struct type));
+	struct type *tmp = ast_alloc(ctx, sizeof(struct type));
 	assert(ts->op == AST_OP_TYPE_SPECIFIER);
-	tmp->name = strdup(name);
+	tmp->name = ast_strdup(ctx, name);
 	tmp->type_spec = ts;
-	tmp->next = type_first;
-	type_first = tmp;
+	tmp->next = ctx->type_first;
+	ctx->type_first = tmp;
 }
 
 ast_node *
-ast_type_lookup(const char *name)
+ast_type_lookup(parse_ctx *ctx, const char *name)
 {
 	struct type *curr;
-	for (curr = type_first; curr != NULL; curr = curr->next)
+	for (curr = ctx->type_first; curr != NULL; curr = curr->next)
 	{
 		if (strcmp(curr->name, name) == 0)
 		{
@@ -63,7 +61,7 @@ ast_type_lookup(const char *name)
 }
 
 unsigned
-ast_type_get_size(ast_node *n)
+ast_type_get_size(parse_ctx *ctx, ast_node *n)
 {
 	unsigned size = 0;
 	assert(n->op == AST_OP_TYPE_SPECIFIER);
@@ -78,7 +76,7 @@ ast_type_get_size(ast_node *n)
 		{
 			if (lst->sibling == NULL)
 			{
-				n = ast_type_lookup(lst->u.strvalue);
+				n = ast_type_lookup(ctx, lst->u.strvalue);
 				lst = n->child->child->sibling;
 			}
 			/* skip tag name */
@@ -105,7 +103,7 @@ ast_type_get_size(ast_node *n)
 				else
 				{
 					dd = sd2->child->child;
-					type_size = ast_type_get_size(sd->child->child);
+					type_size = ast_type_get_size(ctx, sd->child->child);
 				}
 				assert(dd->op == AST_OP_DIRECT_DECLARATOR);
 				if (dd->child->op == AST_OP_ARRAY)
@@ -131,7 +129,7 @@ ast_type_get_size(ast_node *n)
 	}
 	else if (n->child->op == AST_OP_TYPE_NAME)
 	{
-		size = ast_type_get_size(ast_type_lookup(n->child->u.strvalue));
+		size = ast_type_get_size(ctx, ast_type_lookup(ctx, n->child->u.strvalue));
 	}
 	else
 	{
@@ -156,7 +154,8 @@ ast_type_get_size(ast_node *n)
 }
 
 unsigned
-ast_type_get_member_offset(ast_node *n,
+ast_type_get_member_offset(parse_ctx *ctx,
+                           ast_node *n,
                            const char *member_name,
                            ast_node **member_type,
                            int *member_is_pointer)
@@ -173,7 +172,7 @@ ast_type_get_member_offset(ast_node *n,
 	{
 		if (lst->sibling == NULL)
 		{
-			n = ast_type_lookup(lst->u.strvalue);
+			n = ast_type_lookup(ctx, lst->u.strvalue);
 			lst = n->child->child->sibling;
 		}
 		lst = lst->sibling;
@@ -184,7 +183,7 @@ ast_type_get_member_offset(ast_node *n,
 		ast_node *sd2;
 		unsigned type_size;
 		assert(sd->child->op == AST_OP_SPECIFIER_QUALIFIER_LIST);
-		type_size = ast_type_get_size(sd->child->child);
+		type_size = ast_type_get_size(ctx, sd->child->child);
 		assert(sd->child->sibling->op == AST_OP_STRUCT_DECLARATOR_LIST);
 		for (sd2 = sd->child->sibling->child; sd2 != NULL; sd2 = sd2->sibling)
 		{
@@ -239,7 +238,7 @@ ast_type_get_member_offset(ast_node *n,
 }
 
 void
-ast_type_handle_typedef(ast_node *n)
+ast_type_handle_typedef(parse_ctx *ctx, ast_node *n)
 {
 /*
   DECLARATION [0x41318]
@@ -279,7 +278,7 @@ ast_type_handle_typedef(ast_node *n)
 
 	if (ts && id)
 	{
-		ast_type_insert(id->u.strvalue, ts);
+		ast_type_insert(ctx, id->u.strvalue, ts);
 	}
 }
 
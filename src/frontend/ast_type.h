@@ -24,25 +24,28 @@
 #ifndef AST_TYPE_H
 #define AST_TYPE_H
 
+#include "frontend/parse_ctx.h"
+
 struct ast_node;
 
 unsigned
-ast_type_get_size(struct ast_node *n);
+ast_type_get_size(parse_ctx *ctx, struct ast_node *n);
 
 
 unsigned
-ast_type_get_member_offset(struct ast_node *n,
+ast_type_get_member_offset(parse_ctx *ctx,
+                           struct ast_node *n,
                            const char *member_name,
                            struct ast_node **member_type,
                            int *member_is_pointer);
 void
-ast_type_handle_typedef(struct ast_node *n);
+ast_type_handle_typedef(parse_ctx *ctx, struct ast_node *n);
 
 
 void
-ast_type_insert(const char *name, struct ast_node *ts);
+ast_type_insert(parse_ctx *ctx, const char *name, struct ast_node *ts);
 
 struct ast_node *
-ast_type_lookup(const char *name);
+ast_type_lookup(parse_ctx *ctx, const char *name);
 
 #endif
@@ -0,0 +1,65 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "frontend/parse_ctx.h"
+#include "frontend/ast_node.h"
+#include "util/arena.h"
+#include "c95.tab.h"
+
+#include <stdlib.h>
+
+/* Generated from c95.l, see %option reentrant */
+int yylex_init_extra(parse_ctx *extra, void **scanner);
+void yyset_in(FILE *in, void *scanner);
+int yylex_destroy(void *scanner);
+
+parse_ctx *
+parse_ctx_create(void)
+{
+	parse_ctx *ctx = calloc(1, sizeof(parse_ctx));
+	ctx->arena = arena_create();
+	ctx->line = 1;
+	ctx->diag = stderr;
+	return ctx;
+}
+
+void
+parse_ctx_destroy(parse_ctx *ctx)
+{
+	arena_destroy(ctx->arena);
+	free(ctx);
+}
+
+ast_node *
+parse_file(parse_ctx *ctx, FILE *in)
+{
+	int err;
+
+	yylex_init_extra(ctx, &ctx->scanner);
+	yyset_in(in, ctx->scanner);
+	err = yyparse(ctx);
+	yylex_destroy(ctx->scanner);
+	ctx->scanner = NULL;
+
+	return err ? NULL : ctx->root;
+}
@@ -0,0 +1,61 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PARSE_CTX_H
+#define PARSE_CTX_H
+
+#include <stdio.h>
+
+struct arena;
+struct ast_node;
+struct symbol;
+struct type;
+
+#define SYMBOL_MAX_SCOPES 32
+
+/* All frontend state for one translation unit. The scanner and parser
+   are reentrant and keep everything here, so separate contexts can be
+   used from separate threads. */
+typedef struct parse_ctx {
+	void *scanner;
+	struct arena *arena; /* AST, symbols, typedefs and token strings */
+	struct ast_node *root;
+	struct type *type_first;
+	struct symbol *symbol_first[SYMBOL_MAX_SCOPES];
+	int scope_idx;
+	int line;
+	int column;
+	FILE *diag; /* syntax errors, stderr unless set */
+} parse_ctx;
+
+parse_ctx *
+parse_ctx_create(void);
+
+void
+parse_ctx_destroy(parse_ctx *ctx);
+
+/* Returns the root of the AST or NULL on a syntax error */
+struct ast_node *
+parse_file(parse_ctx *ctx, FILE *in);
+
+#endif
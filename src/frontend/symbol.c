@@ -22,31 +22,29 @@
  */
 
 #include "frontend/symbol.h"
+#include "frontend/ast_node.h"
 
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 
-static symbol *symbol_first[32] = {0};
-static int scope_idx = 0;
-
-symbol * symbol_insert(const char *name)
+symbol * symbol_insert(parse_ctx *ctx, const char *name)
 {
-	symbol *sym = calloc(1, sizeof(symbol));
-	sym->name = strdup(name);
-	sym->next = symbol_first[scope_idx];
-	symbol_first[scope_idx] = sym;
+	symbol *sym = ast_alloc(ctx, sizeof(symbol));
+	sym->name = ast_strdup(ctx, name);
+	sym->next = ctx->symbol_first[ctx->scope_idx];
+	ctx->symbol_first[ctx->scope_idx] = sym;
 
 	return sym;
 }
 
-symbol * symbol_lookup(const char *name)
+symbol * symbol_lookup(parse_ctx *ctx, const char *name)
 {
 	int i;
-	for (i = scope_idx; i >= 0; i--)
+	for (i = ctx->scope_idx; i >= 0; i--)
 	{
 		symbol *curr;
-		for (curr = symbol_first[i]; curr != NULL; curr = curr->next)
+		for (curr = ctx->symbol_first[i]; curr != NULL; curr = curr->next)
 		{
 			if (strcmp(curr->name, name) == 0)
 			{
@@ -58,15 +56,15 @@ symbol * symbol_lookup(const char *name)
 	return NULL;
 }
 
-void symbol_scope_push(void)
+void symbol_scope_push(parse_ctx *ctx)
 {
-	symbol_first[++scope_idx] = NULL;
-	assert(scope_idx < 32);
+	ctx->symbol_first[++ctx->scope_idx] = NULL;
+	assert(ctx->scope_idx < SYMBOL_MAX_SCOPES);
 }
 
-void symbol_scope_pop(void)
+void symbol_scope_pop(parse_ctx *ctx)
 {
-	symbol_first[scope_idx--] = NULL;
-	assert(scope_idx >= 0);
+	ctx->symbol_first[ctx->scope_idx--] = NULL;
+	assert(ctx->scope_idx >= 0);
 }
 
@@ -24,6 +24,8 @@
 #ifndef SYMBOL_H
 #define SYMBOL_H
 
+#include "frontend/parse_ctx.h"
+
 typedef struct symbol {
 	struct symbol *next;
 
@@ -34,9 +36,9 @@ typedef struct symbol {
 	int is_array;
 } symbol;
 
-symbol * symbol_insert(const char *name);
-symbol * symbol_lookup(const char *name);
-void symbol_scope_push(void);
-void symbol_scope_pop(void);
+symbol * symbol_insert(parse_ctx *ctx, const char *name);
+symbol * symbol_lookup(parse_ctx *ctx, const char *name);
+void symbol_scope_push(parse_ctx *ctx);
+void symbol_scope_pop(parse_ctx *ctx);
 
 #endif
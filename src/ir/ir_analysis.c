@@ -0,0 +1,123 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ir/ir_analysis.h"
+#include "ir/ir_bb_private.h"
+#include "ir/ir_dom.h"
+#include "ir/ir_func.h"
+#include "ir/ir_live.h"
+#include "util/graph_loop.h"
+#include <stddef.h>
+
+static void
+comp_rpo(void *unit)
+{
+	ir_bb_comp_cfg_orders(unit);
+}
+
+static void
+comp_domtree(void *unit)
+{
+	ir_dom_setup_dom_info(unit);
+}
+
+static void
+destroy_domtree(void *unit)
+{
+	ir_dom_destroy_dom_info(unit);
+}
+
+static void
+comp_df(void *unit)
+{
+	ir_dom_setup_df(unit);
+}
+
+static graph_loop_bb_info *
+get_bb_loop_info(graph_node *b)
+{
+	return &((ir_bb *)b)->loop_info;
+}
+
+static void
+comp_loops(void *unit)
+{
+	ir_func *func = unit;
+
+	graph_loop_analyze(&func->cfg_graph_ctx,
+	                   (graph_node *)func->entry,
+	                   func->n_ir_bbs,
+	                   get_bb_loop_info);
+}
+
+static void
+comp_liveness(void *unit)
+{
+	ir_live_setup(unit);
+}
+
+static void
+destroy_liveness(void *unit)
+{
+	ir_live_destroy(unit);
+}
+
+/* Graph 0 is the cfg and graph 1 the ssa graph. The block orders are left
+   to iterators in use when they are dropped, they live in the arena. */
+static const analysis_desc descs[IR_N_ANALYSES] = {
+	[IR_ANALYSIS_RPO] = {"rpo", 1, 0, comp_rpo, NULL},
+	[IR_ANALYSIS_DOMTREE] = {"domtree", 1, IR_ANALYSIS(IR_ANALYSIS_RPO), comp_domtree, destroy_domtree},
+	[IR_ANALYSIS_DF] = {"df", 1, IR_ANALYSIS(IR_ANALYSIS_DOMTREE), comp_df, NULL},
+	[IR_ANALYSIS_LOOPS] = {"loops", 1, 0, comp_loops, NULL},
+	[IR_ANALYSIS_LIVENESS] = {"liveness", 3, IR_ANALYSIS(IR_ANALYSIS_RPO), comp_liveness, destroy_liveness},
+};
+
+void
+ir_analysis_init(ir_func *func)
+{
+	analysis_mgr_init(&func->analyses, descs, IR_N_ANALYSES, &func->cfg_graph_ctx, &func->ssa_graph_ctx);
+}
+
+void
+ir_analysis_require(ir_func *func, unsigned mask)
+{
+	analysis_require(&func->analyses, func, mask);
+}
+
+void
+ir_analysis_preserve(ir_func *func, unsigned mask)
+{
+	analysis_preserve(&func->analyses, func, mask);
+}
+
+void
+ir_analysis_invalidate(ir_func *func, unsigned mask)
+{
+	analysis_invalidate(&func->analyses, func, mask);
+}
+
+void
+ir_analysis_drop_stale(ir_func *func)
+{
+	analysis_drop_stale(&func->analyses, func);
+}
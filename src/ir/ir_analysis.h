@@ -0,0 +1,60 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef IR_ANALYSIS_H
+#define IR_ANALYSIS_H
+
+#include "ir/ir.h"
+
+/* Analyses kept by the ir_func analysis manager, dependencies first */
+typedef enum ir_analysis {
+	IR_ANALYSIS_RPO,
+	IR_ANALYSIS_DOMTREE,
+	IR_ANALYSIS_DF,
+	IR_ANALYSIS_LOOPS,
+	IR_ANALYSIS_LIVENESS,
+	IR_N_ANALYSES
+} ir_analysis;
+
+#define IR_ANALYSIS(x) (1U << (x))
+#define IR_ANALYSES_NONE 0
+#define IR_ANALYSES_ALL (IR_ANALYSIS(IR_N_ANALYSES) - 1)
+/* Computed from the cfg alone, kept by passes that only change the ssa graph */
+#define IR_ANALYSES_CFG (IR_ANALYSES_ALL & ~IR_ANALYSIS(IR_ANALYSIS_LIVENESS))
+
+void
+ir_analysis_init(ir_func *func);
+
+void
+ir_analysis_require(ir_func *func, unsigned mask);
+
+void
+ir_analysis_preserve(ir_func *func, unsigned mask);
+
+void
+ir_analysis_invalidate(ir_func *func, unsigned mask);
+
+void
+ir_analysis_drop_stale(ir_func *func);
+
+#endif
@@ -22,8 +22,10 @@
  */
 
 #include "ir_bb_private.h"
+#include "ir_analysis.h"
 #include "ir_func.h"
 #include "ir_node_private.h"
+#include "util/arena.h"
 
 #include <assert.h>
 #include <stdlib.h>
@@ -33,8 +35,6 @@ typedef struct cfg_edge {
 	enum {DEFAULT_TARGET, FALSE_TARGET = DEFAULT_TARGET, TRUE_TARGET} target;
 } cfg_edge;
 
-static unsigned global_bb_id = 0;
-
 static int
 edge_cmp(void *a, void *b)
 {
@@ -47,17 +47,18 @@ edge_cmp(void *a, void *b)
 ir_bb *
 ir_bb_build(ir_func *func)
 {
-	ir_bb *bb = (ir_bb *)graph_create_node(sizeof(ir_bb));
-	bb->id = ++global_bb_id;
+	ir_bb *bb = (ir_bb *)graph_create_node(&func->cfg_graph_ctx, sizeof(ir_bb));
+	bb->id = ++func->bb_id_cntr;
 	bb->func = func;
 	func->n_ir_bbs++;
+	ir_node_store_add_bb(func->node_store, bb);
 
 	if (func->entry == NULL)
 	{
 		func->entry = bb;
 	}
 
-	bb->term_node = ir_node_build0(bb, IR_OP_term, i1);
+	bb->term_node = ir_node_slot(ir_node_build0(bb, IR_OP_term, i1));
 
 	return bb;
 }
@@ -120,7 +121,7 @@ ir_bb_build_value_ret(ir_bb *bb, ir_node *value)
 }
 
 static void
-po_worker(ir_bb_iter *it, graph_node *n, graph_marker *marker)
+po_worker(ir_func *func, graph_node *n, graph_marker *marker)
 {
 	graph_edge *edge;
 
@@ -134,60 +135,65 @@ po_worker(ir_bb_iter *it, graph_node *n, graph_marker *marker)
 	for (edge = graph_succ_first(n); edge != NULL; edge = graph_succ_next(edge))
 	{
 		graph_node *succ = graph_edge_head(edge);
-		po_worker(it, succ, marker);
+		po_worker(func, succ, marker);
 	}
 
-	it->po_bbs[it->idx++] = (ir_bb *)n;
+	func->po_bbs[func->n_po_bbs++] = (ir_bb *)n;
 }
 
+/* Fresh arrays are allocated so that iterators started before the cfg was
+   modified remain valid */
 void
-ir_bb_iter_init(ir_bb_iter *it, ir_func *func)
+ir_bb_comp_cfg_orders(ir_func *func)
 {
 	graph_marker marker;
+	unsigned i;
+
+	func->po_bbs = arena_alloc(func->arena, func->n_ir_bbs*sizeof(ir_bb *));
+	func->rpo_bbs = arena_alloc(func->arena, func->n_ir_bbs*sizeof(ir_bb *));
+	func->n_po_bbs = 0;
 
 	graph_marker_alloc(&func->cfg_graph_ctx, &marker);
+	po_worker(func, (graph_node *)func->entry, &marker);
+	graph_marker_free(&func->cfg_graph_ctx, &marker);
 
-	it->po_bbs = calloc(func->n_ir_bbs, sizeof(ir_bb *));
-	it->idx = 0;
+	for (i = 0; i < func->n_po_bbs; i++)
+	{
+		func->rpo_bbs[func->n_po_bbs-i-1] = func->po_bbs[i];
+	}
+}
 
-	po_worker(it, (graph_node *)func->entry, &marker);
+void
+ir_bb_iter_init(ir_bb_iter *it, ir_func *func)
+{
+	/* Will only do work if needed */
+	ir_analysis_require(func, IR_ANALYSIS(IR_ANALYSIS_RPO));
 
-	graph_marker_free(&func->cfg_graph_ctx, &marker);
+	it->bbs = func->rpo_bbs;
+	it->n_bbs = func->n_po_bbs;
+	it->idx = 0;
 }
 
 void
 ir_bb_iter_rev_init(ir_bb_iter *it, ir_func *func)
 {
-	graph_marker marker;
-	unsigned i;
-
-	graph_marker_alloc(&func->cfg_graph_ctx, &marker);
+	ir_analysis_require(func, IR_ANALYSIS(IR_ANALYSIS_RPO));
 
-	it->po_bbs = calloc(func->n_ir_bbs, sizeof(ir_bb *));
+	it->bbs = func->po_bbs;
+	it->n_bbs = func->n_po_bbs;
 	it->idx = 0;
-
-	po_worker(it, (graph_node *)func->entry, &marker);
-
-	for (i = 0; i < func->n_ir_bbs/2; i++)
-	{
-		ir_bb *tmp = it->po_bbs[func->n_ir_bbs-i-1];
-		it->po_bbs[func->n_ir_bbs-i-1] = it->po_bbs[i];
-		it->po_bbs[i] = tmp;
-	}
-
-	graph_marker_free(&func->cfg_graph_ctx, &marker);
 }
 
 ir_bb *
 ir_bb_iter_next(ir_bb_iter *it)
 {
-	if (it->idx == 0)
+	if (it->idx == it->n_bbs)
 	{
 		return NULL;
 	}
 	else
 	{
-		return it->po_bbs[--it->idx];
+		return it->bbs[it->idx++];
 	}
 }
 
@@ -249,13 +255,14 @@ ir_bb_get_false_target(ir_bb *bb)
 ir_node *
 ir_bb_get_term_node(ir_bb *bb)
 {
+	ir_node *term = ir_node_at(bb->func->node_store, bb->term_node);
 	ir_node *args[1];
 	unsigned n_args;
 
-	assert(bb->term_node != NULL);
-	assert(bb->term_node->op == IR_OP_term);
+	assert(term != NULL);
+	assert(term->op == IR_OP_term);
 
-	ir_node_get_args(bb->term_node, &n_args, args, 1);
+	ir_node_get_args(term, &n_args, args, 1);
 	if (n_args == 1)
 	{
 		return args[0];
@@ -273,20 +280,27 @@ ir_bb_id(ir_bb *bb)
 	return bb->id;
 }
 
-void *
-ir_bb_scratch(ir_bb *bb)
+struct ir_dom_info *
+ir_bb_dom_info(ir_bb *bb)
 {
-	return bb->scratch;
+	return bb->dom_info;
 }
 
-void
-ir_bb_scratch_set(ir_bb *bb, void *p)
+unsigned
+ir_bb_loop_nest(ir_bb *bb)
 {
-	bb->scratch = p;
-}
+	graph_node *n;
+	unsigned nest = bb->loop_info.type == GRAPH_LOOP_HEADER ? 1 : 0;
 
-struct ir_dom_info *
-ir_bb_dom_info(ir_bb *bb)
-{
-	return bb->dom_info;
+	/* Will only do work if needed */
+	ir_analysis_require(bb->func, IR_ANALYSIS(IR_ANALYSIS_LOOPS));
+
+	n = bb->loop_info.header;
+	while (n != NULL)
+	{
+		nest++;
+		n = ((ir_bb *)n)->loop_info.header;
+	}
+
+	return nest;
 }
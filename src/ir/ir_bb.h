@@ -25,8 +25,9 @@
 #include "ir/ir.h"
 
 typedef struct ir_bb_iter {
-	ir_bb **po_bbs;
+	ir_bb **bbs;
 	unsigned idx;
+	unsigned n_bbs;
 } ir_bb_iter;
 
 ir_bb *
@@ -68,11 +69,8 @@ ir_bb_get_term_node(ir_bb *bb);
 unsigned
 ir_bb_id(ir_bb *bb);
 
-void *
-ir_bb_scratch(ir_bb *bb);
-
-void
-ir_bb_scratch_set(ir_bb *bb, void *p);
-
 struct ir_dom_info *
 ir_bb_dom_info(ir_bb *bb);
+
+unsigned
+ir_bb_loop_nest(ir_bb *bb);
@@ -24,21 +24,28 @@
 #pragma once
 
 #include "util/graph.h"
+#include "util/graph_loop.h"
 #include "ir/ir_bb.h"
 
 struct ir_bb {
 	graph_node graph;
-	unsigned id;
 	ir_func *func;
-	ir_node *first_ir_node;
-	ir_node *last_ir_node;
-	ir_node *first_ir_phi_node;
-	ir_node *last_ir_phi_node;
+	unsigned id;
+	unsigned first_ir_node; /* node slots, see ir_node_private.h */
+	unsigned last_ir_node;
+	unsigned first_ir_phi_node;
+	unsigned last_ir_phi_node;
 	unsigned n_ir_nodes;
 	enum {IR_BB_TERM_BR, IR_BB_TERM_RET} term_kind;
-	ir_node *term_node;
+	unsigned term_node;
 
 	struct ir_dom_info *dom_info;
-	void *scratch;
+	struct graph_loop_bb_info loop_info;
+	struct bset_set *live_in; /* by node id, see ir_live.h */
+	struct bset_set *live_out;
 };
 
+/* Fill the ir_func post-order and reverse post-order arrays, use
+   IR_ANALYSIS_RPO rather than calling this directly */
+void
+ir_bb_comp_cfg_orders(ir_func *func);
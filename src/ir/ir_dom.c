@@ -24,91 +24,36 @@
 #include "ir/ir_dom.h"
 #include "ir/ir_bb_private.h"
 #include "ir/ir_func.h"
+#include "util/arena.h"
+#include "util/graph_dom.h"
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
 
-static ir_dom_info * intersect(ir_bb *b1, ir_bb *b2)
+static graph_dom_info *get_dom_info(graph_node *n)
 {
-	ir_dom_info *finger1 = b1->dom_info;
-	ir_dom_info *finger2 = b2->dom_info;
-
-	while (finger1 != finger2)
-	{
-		while (finger1->po < finger2->po)
-		{
-			finger1 = finger1->idom;
-		}
-
-		while (finger2->po < finger1->po)
-		{
-			finger2 = finger2->idom;
-		}
-	}
-
-	return finger1;
+	return &((ir_bb *)n)->dom_info->dom;
 }
 
 static void ir_dom_comp_idom(ir_func *func)
 {
 	ir_bb_iter bit;
 	ir_bb *b;
-	unsigned po = func->n_ir_bbs;
-	int changed;
 
 	ir_bb_iter_init(&bit, func);
 	while ((b = ir_bb_iter_next(&bit)))
 	{
-		b->dom_info = calloc(1, sizeof(ir_dom_info));
+		b->dom_info = arena_alloc(func->arena, sizeof(ir_dom_info));
 		b->dom_info->bb = b;
-		b->dom_info->po = --po;
 	}
 
-	func->entry->dom_info->idom = func->entry->dom_info;
+	graph_dom_analyze(&func->cfg_graph_ctx, (graph_node *)func->entry, func->n_ir_bbs, get_dom_info);
 
-	changed = 1;
-	while (changed)
+	ir_bb_iter_init(&bit, func);
+	while ((b = ir_bb_iter_next(&bit)))
 	{
-		changed = 0;
-
-		ir_bb_iter_init(&bit, func);
-		(void)ir_bb_iter_next(&bit); /* skip entry node */
-		while ((b = ir_bb_iter_next(&bit)))
-		{
-			graph_edge *edge;
-			ir_dom_info *new_idom;
-
-			for (edge = graph_pred_first((graph_node *)b);
-				 edge != NULL;
-				 edge = graph_pred_next(edge))
-			{
-				ir_bb *p = (ir_bb *)graph_edge_tail(edge);
-				if (p->dom_info->idom != NULL)
-				{
-					new_idom = p->dom_info;
-					break;
-				}
-			}
-
-			assert(new_idom->idom != NULL);
-
-			for (edge = graph_pred_first((graph_node *)b);
-				 edge != NULL;
-				 edge = graph_pred_next(edge))
-			{
-				ir_bb *p = (ir_bb *)graph_edge_tail(edge);
-				if (p->dom_info != new_idom && p->dom_info->idom != NULL)
-				{
-					new_idom = intersect(p, new_idom->bb);
-				}
-			}
-
-			if (b->dom_info->idom != new_idom)
-			{
-				b->dom_info->idom = new_idom;
-				changed = 1;
-			}
-		}
+		ir_bb *idom = (ir_bb *)b->dom_info->dom.idom;
+		b->dom_info->idom = idom != NULL ? idom->dom_info : b->dom_info;
 	}
 }
 
@@ -122,7 +67,7 @@ static void ir_dom_comp_domtree(ir_func *func)
 	while ((b = ir_bb_iter_next(&bit)))
 	{
 		ir_dom_info *idom = b->dom_info->idom;
-		ir_dom_info_lst *lst = calloc(1, sizeof(ir_dom_info_lst));
+		ir_dom_info_lst *lst = arena_alloc(func->arena, sizeof(ir_dom_info_lst));
 		lst->next = idom->domtree_children;
 		idom->domtree_children = lst;
 		lst->info = b->dom_info;
@@ -149,7 +94,7 @@ static void ir_dom_comp_df(ir_func *func)
 				while (runner != b->dom_info->idom)
 				{
 					/* add b to runners df set */
-					ir_dom_info_lst *lst = calloc(1, sizeof(ir_dom_info_lst));
+					ir_dom_info_lst *lst = arena_alloc(func->arena, sizeof(ir_dom_info_lst));
 					lst->next = runner->df;
 					runner->df = lst;
 					lst->info = b->dom_info;
@@ -203,18 +148,36 @@ void ir_dom_setup_dom_info(ir_func *func)
 {
 	ir_dom_comp_idom(func);
 	ir_dom_comp_domtree(func);
-	ir_dom_comp_df(func);
 }
 
-void ir_dom_destroy_dom_info(ir_func *func)
+void ir_dom_setup_df(ir_func *func)
 {
 	ir_bb_iter bit;
 	ir_bb *b;
 
+	/* Frontiers may be recomputed on top of an unchanged dominator tree */
 	ir_bb_iter_init(&bit, func);
 	while ((b = ir_bb_iter_next(&bit)))
 	{
-		assert(b->dom_info != NULL);
-		free(b->dom_info);
+		b->dom_info->df = NULL;
+	}
+
+	ir_dom_comp_df(func);
+}
+
+int ir_dom_dominates(ir_bb *a, ir_bb *b)
+{
+	return graph_dom_dominates(&a->dom_info->dom, &b->dom_info->dom);
+}
+
+void ir_dom_destroy_dom_info(ir_func *func)
+{
+	unsigned i;
+
+	/* Memory is owned by the function arena. The tree was built for the
+	   blocks in the current order, blocks added since have none. */
+	for (i = 0; i < func->n_po_bbs; i++)
+	{
+		func->po_bbs[i]->dom_info = NULL;
 	}
 }
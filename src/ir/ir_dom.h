@@ -25,6 +25,7 @@
 #define IR_DOM_H
 
 #include "ir/ir.h"
+#include "util/graph_dom.h"
 
 typedef struct ir_dom_info_lst
 {
@@ -38,11 +39,13 @@ typedef struct ir_dom_info
 	struct ir_dom_info *idom;
 	struct ir_dom_info_lst *df;
 	struct ir_dom_info_lst *domtree_children;
-	unsigned po;
+	graph_dom_info dom;
 
 } ir_dom_info;
 
 void ir_dom_setup_dom_info(ir_func *func);
+void ir_dom_setup_df(ir_func *func);
 void ir_dom_destroy_dom_info(ir_func *func);
+int ir_dom_dominates(ir_bb *a, ir_bb *b);
 
 #endif
@@ -22,7 +22,11 @@
  */
 
 #include "ir_func.h"
+#include "ir_node_private.h"
+#include "ir_analysis.h"
 #include "ir_tu.h"
+#include "util/arena.h"
+#include "util/stats.h"
 
 #include <assert.h>
 #include <stdlib.h>
@@ -41,6 +45,11 @@ ir_func_build(ir_tu *tu,
 	func->ret_type = ret_type;
 	func->param_types = calloc(n_params, sizeof(ir_type));
 	func->n_params = n_params;
+	func->arena = arena_create();
+	func->cfg_graph_ctx.arena = func->arena;
+	func->ssa_graph_ctx.arena = func->arena;
+	func->node_store = ir_node_store_create(func);
+	ir_analysis_init(func);
 	for (i = 0; i < n_params; i++)
 	{
 		func->param_types[i] = param_types[i];
@@ -87,3 +96,49 @@ ir_func_is_definition(ir_func *func)
 {
 	return func->entry != NULL;
 }
+
+void
+ir_func_get_usage(ir_func *func, arena_usage *usage)
+{
+	arena_get_usage(func->arena, usage);
+	ir_node_store_get_usage(func->node_store, usage);
+}
+
+void
+ir_func_destroy(ir_func *func)
+{
+	arena_usage usage, store_usage = {0};
+
+	arena_get_usage(func->arena, &usage);
+	ir_node_store_get_usage(func->node_store, &store_usage);
+	stats_count("ir.bbs", func->name, func->n_ir_bbs);
+	stats_count("ir.nodes", func->name, func->n_ir_nodes);
+	stats_count("ir.edges", func->name, func->ssa_graph_ctx.n_edges);
+	stats_count("ir.arena.allocs", func->name, usage.n_allocs);
+	stats_count("ir.arena.bytes", func->name, usage.n_bytes);
+	stats_count("ir.arena.reserved", func->name, usage.n_reserved);
+	stats_count("ir.store.allocs", func->name, store_usage.n_allocs);
+	stats_count("ir.store.bytes", func->name, store_usage.n_bytes);
+	stats_count("ir.store.reserved", func->name, store_usage.n_reserved);
+
+	/* Drop the body in one go. The ir_func itself is kept as a declaration
+	   since call nodes in other functions may still refer to it. */
+	ir_analysis_invalidate(func, IR_ANALYSES_ALL);
+	arena_destroy(func->arena);
+	ir_node_store_destroy(func->node_store);
+
+	memset(&func->cfg_graph_ctx, 0, sizeof(func->cfg_graph_ctx));
+	memset(&func->ssa_graph_ctx, 0, sizeof(func->ssa_graph_ctx));
+	func->entry = NULL;
+	func->exit = NULL;
+	func->n_ir_bbs = 0;
+	func->n_ir_nodes = 0;
+	func->po_bbs = NULL;
+	func->rpo_bbs = NULL;
+	func->n_po_bbs = 0;
+
+	func->arena = arena_create();
+	func->cfg_graph_ctx.arena = func->arena;
+	func->ssa_graph_ctx.arena = func->arena;
+	func->node_store = ir_node_store_create(func);
+}
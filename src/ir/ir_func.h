@@ -25,8 +25,11 @@
 #define IR_FUNC_H
 
 #include "ir/ir.h"
+#include "util/analysis.h"
 #include "util/graph.h"
 
+struct arena_usage;
+
 struct ir_func {
 	const char *name;
 	graph_ctx cfg_graph_ctx;
@@ -35,14 +38,20 @@ struct ir_func {
 	ir_func *tu_list_next;
 	ir_bb *entry;
 	ir_bb *exit;
-	ir_node *first_unused_ir_node;
-	ir_node *last_unused_ir_node;
 	unsigned n_ir_bbs;
 	unsigned n_ir_nodes;
+	unsigned bb_id_cntr; /* ids are only unique within the function */
+	unsigned node_id_cntr;
+	ir_bb **po_bbs; /* cfg orders, kept by IR_ANALYSIS_RPO */
+	ir_bb **rpo_bbs;
+	unsigned n_po_bbs;
 	unsigned n_params;
 	ir_type *param_types;
 	ir_type ret_type;
 	int is_variadic;
+	struct arena *arena; /* owns bbs, edges and pass side data */
+	struct ir_node_store *node_store; /* owns nodes */
+	analysis_mgr analyses;
 	void *scratch;
 };
 
@@ -68,4 +77,16 @@ ir_func_is_definition(ir_func *func);
 
 void ir_func_free_unused_nodes(ir_func *func);
 
+/* Hand out node ids 1..n again so that side tables indexed by id are
+   dense after nodes have been removed */
+void
+ir_func_renumber_nodes(ir_func *func);
+
+/* Memory held by the arena and the node store of func */
+void
+ir_func_get_usage(ir_func *func, struct arena_usage *usage);
+
+void
+ir_func_destroy(ir_func *func);
+
 #endif
@@ -0,0 +1,165 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ir/ir_live.h"
+#include "ir/ir_analysis.h"
+#include "ir/ir_bb_private.h"
+#include "ir/ir_func.h"
+#include "ir/ir_node_private.h"
+#include "util/bset.h"
+#include <stdlib.h>
+
+/*
+ * Liveness is found by walking from each use back to the definition, the
+ * way the register allocator builds its intervals, rather than by iterating
+ * dataflow equations over all blocks. Only blocks where a value is live are
+ * visited. A phi use counts as a use at the end of the corresponding
+ * predecessor.
+ */
+typedef struct live_ctx {
+	ir_node *def;
+	ir_bb **stack; /* blocks with def newly live-in */
+	unsigned sp;
+} live_ctx;
+
+static void
+live_in(live_ctx *ctx, ir_bb *b)
+{
+	/* Predecessors out of reach of the entry have no sets */
+	if (b->id == ctx->def->bb || b->live_in == NULL || bset_has(b->live_in, ctx->def->id))
+	{
+		return;
+	}
+
+	bset_add(b->live_in, ctx->def->id);
+	ctx->stack[ctx->sp++] = b;
+}
+
+static void
+live_out(live_ctx *ctx, ir_bb *b)
+{
+	if (b->live_out == NULL || bset_has(b->live_out, ctx->def->id))
+	{
+		return;
+	}
+
+	bset_add(b->live_out, ctx->def->id);
+	live_in(ctx, b);
+}
+
+static void
+explore_def(live_ctx *ctx, ir_node *def)
+{
+	ir_node_store *store = ir_node_store_of(def);
+	unsigned i;
+
+	ctx->def = def;
+	for (i = 0; i < def->n_uses; i++)
+	{
+		ir_node_use use = ir_node_uses(def)[i];
+		ir_node *user = ir_node_at(store, use.node);
+
+		if (user->op == IR_OP_phi)
+		{
+			live_out(ctx, ir_node_phi_bb(user, use.idx));
+		}
+		else
+		{
+			live_in(ctx, ir_node_store_bb(store, user->bb));
+		}
+
+		while (ctx->sp > 0)
+		{
+			ir_bb *b = ctx->stack[--ctx->sp];
+			graph_edge *edge;
+
+			for (edge = graph_pred_first((graph_node *)b); edge != NULL; edge = graph_pred_next(edge))
+			{
+				live_out(ctx, (ir_bb *)graph_edge_tail(edge));
+			}
+		}
+	}
+}
+
+void
+ir_live_setup(ir_func *func)
+{
+	live_ctx ctx;
+	ir_bb_iter bit;
+	ir_bb *b;
+
+	ir_bb_iter_init(&bit, func);
+	while ((b = ir_bb_iter_next(&bit)))
+	{
+		b->live_in = bset_create_sparse_set(func->arena, func->node_id_cntr + 1);
+		b->live_out = bset_create_sparse_set(func->arena, func->node_id_cntr + 1);
+	}
+
+	/* A block is pushed at most once per definition */
+	ctx.stack = malloc(func->n_ir_bbs*sizeof(ir_bb *));
+	ctx.sp = 0;
+
+	ir_bb_iter_init(&bit, func);
+	while ((b = ir_bb_iter_next(&bit)))
+	{
+		ir_node_iter nit;
+		ir_node *n;
+
+		ir_node_iter_init(&nit, b);
+		while ((n = ir_node_iter_next(&nit)))
+		{
+			explore_def(&ctx, n);
+		}
+	}
+
+	free(ctx.stack);
+}
+
+void
+ir_live_destroy(ir_func *func)
+{
+	unsigned i;
+
+	/* Memory is owned by the function arena. The sets were made for the
+	   blocks in the current order, which the cfg may since have changed. */
+	for (i = 0; i < func->n_po_bbs; i++)
+	{
+		func->po_bbs[i]->live_in = NULL;
+		func->po_bbs[i]->live_out = NULL;
+	}
+}
+
+bset_set *
+ir_live_in(ir_bb *bb)
+{
+	/* Will only do work if needed */
+	ir_analysis_require(bb->func, IR_ANALYSIS(IR_ANALYSIS_LIVENESS));
+	return bb->live_in;
+}
+
+bset_set *
+ir_live_out(ir_bb *bb)
+{
+	ir_analysis_require(bb->func, IR_ANALYSIS(IR_ANALYSIS_LIVENESS));
+	return bb->live_out;
+}
@@ -0,0 +1,46 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef IR_LIVE_H
+#define IR_LIVE_H
+
+#include "ir/ir.h"
+#include "util/bset.h"
+
+/* Ssa values live on entry to and exit from bb, as sets of node ids. Blocks
+   that can not be reached from the entry have none. The sets are computed
+   on first use and are only valid until the function is modified. */
+bset_set *
+ir_live_in(ir_bb *bb);
+
+bset_set *
+ir_live_out(ir_bb *bb);
+
+/* Use IR_ANALYSIS_LIVENESS rather than calling these directly */
+void
+ir_live_setup(ir_func *func);
+
+void
+ir_live_destroy(ir_func *func);
+
+#endif
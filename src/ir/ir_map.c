@@ -0,0 +1,138 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ir_map.h"
+#include "ir_node_private.h"
+#include "ir_bb_private.h"
+
+#include "ir_func.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void
+map_init(ir_map *map, ir_func *func, unsigned elem_size, unsigned n_elems)
+{
+	assert(elem_size > 0);
+	map->func = func;
+	map->elem_size = elem_size;
+	map->n_elems = n_elems;
+	map->present = calloc(n_elems, 1);
+	map->elems = calloc(n_elems, elem_size);
+}
+
+static void
+map_destroy(ir_map *map)
+{
+	free(map->present);
+	free(map->elems);
+	memset(map, 0, sizeof(*map));
+}
+
+static void
+map_grow(ir_map *map, unsigned n_elems)
+{
+	unsigned old = map->n_elems;
+
+	map->n_elems = n_elems;
+	map->present = realloc(map->present, n_elems);
+	map->elems = realloc(map->elems, (size_t)n_elems * map->elem_size);
+	memset(map->present + old, 0, n_elems - old);
+	memset(map->elems + (size_t)old * map->elem_size, 0, (size_t)(n_elems - old) * map->elem_size);
+}
+
+static void *
+map_lookup(ir_map *map, unsigned id)
+{
+	if (id >= map->n_elems || !map->present[id])
+	{
+		return NULL;
+	}
+	return map->elems + (size_t)id * map->elem_size;
+}
+
+static void *
+map_get(ir_map *map, unsigned id, unsigned max_id)
+{
+	if (id >= map->n_elems)
+	{
+		/* Cover everything built so far, plus some slack */
+		assert(id <= max_id);
+		map_grow(map, max_id + 1 + max_id / 4);
+	}
+	map->present[id] = 1;
+	return map->elems + (size_t)id * map->elem_size;
+}
+
+void
+ir_node_map_init(ir_node_map *map, ir_func *func, unsigned elem_size)
+{
+	map_init(&map->map, func, elem_size, func->node_id_cntr + 1);
+}
+
+void
+ir_node_map_destroy(ir_node_map *map)
+{
+	map_destroy(&map->map);
+}
+
+void *
+ir_node_map_lookup(ir_node_map *map, ir_node *n)
+{
+	assert(ir_node_store_of(n)->func == map->map.func);
+	return map_lookup(&map->map, n->id);
+}
+
+void *
+ir_node_map_get(ir_node_map *map, ir_node *n)
+{
+	assert(ir_node_store_of(n)->func == map->map.func);
+	return map_get(&map->map, n->id, map->map.func->node_id_cntr);
+}
+
+void
+ir_bb_map_init(ir_bb_map *map, ir_func *func, unsigned elem_size)
+{
+	map_init(&map->map, func, elem_size, func->bb_id_cntr + 1);
+}
+
+void
+ir_bb_map_destroy(ir_bb_map *map)
+{
+	map_destroy(&map->map);
+}
+
+void *
+ir_bb_map_lookup(ir_bb_map *map, ir_bb *bb)
+{
+	assert(bb->func == map->map.func);
+	return map_lookup(&map->map, bb->id);
+}
+
+void *
+ir_bb_map_get(ir_bb_map *map, ir_bb *bb)
+{
+	assert(bb->func == map->map.func);
+	return map_get(&map->map, bb->id, map->map.func->bb_id_cntr);
+}
@@ -0,0 +1,74 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "ir/ir.h"
+
+/* Side tables keyed on the per function node and block ids. Entries are
+   elem_size bytes each, stored in a flat array that grows to cover nodes
+   and blocks built while the map is live. Entries start out zeroed.
+   Pointers to entries stay valid until the map has to grow, i.e. until an
+   entry is requested for a node or block built after the map. */
+
+typedef struct ir_map {
+	ir_func *func;
+	unsigned elem_size;
+	unsigned n_elems;
+	unsigned char *present;
+	char *elems;
+} ir_map;
+
+typedef struct ir_node_map {
+	ir_map map;
+} ir_node_map;
+
+typedef struct ir_bb_map {
+	ir_map map;
+} ir_bb_map;
+
+void
+ir_node_map_init(ir_node_map *map, ir_func *func, unsigned elem_size);
+
+void
+ir_node_map_destroy(ir_node_map *map);
+
+/* Entry for n, NULL if it has none yet */
+void *
+ir_node_map_lookup(ir_node_map *map, ir_node *n);
+
+/* Entry for n, created zeroed if it has none yet */
+void *
+ir_node_map_get(ir_node_map *map, ir_node *n);
+
+void
+ir_bb_map_init(ir_bb_map *map, ir_func *func, unsigned elem_size);
+
+void
+ir_bb_map_destroy(ir_bb_map *map);
+
+void *
+ir_bb_map_lookup(ir_bb_map *map, ir_bb *bb);
+
+void *
+ir_bb_map_get(ir_bb_map *map, ir_bb *bb);
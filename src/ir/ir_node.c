@@ -27,187 +27,258 @@
 #include "ir_bb.h"
 #include "ir_func.h"
 #include "ir_validate.h"
+#include "util/arena.h"
+#include "util/word_pool.h"
 
 #include <assert.h>
 #include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 
-typedef struct node_edge {
-	graph_edge edge;
-	union {
-		struct {
-			unsigned idx;
-		} arg;
-		struct {
-			ir_bb *bb;
-		} phi_arg;
-	} u;
-} node_edge;
+/*
+ * Operands are kept in the args of a node indexed by operand slot. Phi
+ * operands are kept in the order they were added, with the incoming block
+ * in u.phi.bbs. Every operand slot has a matching entry in the use list of
+ * the operand so that replacing a node only has to patch the slots of its
+ * users.
+ *
+ * Out of line arrays come from the word pool of the store. Operand counts
+ * never shrink, so their capacity follows from the count and is not stored.
+ * Use lists do shrink and keep their capacity in uses_room.
+ */
+static void
+args_reserve(ir_node *n, unsigned n_args)
+{
+	ir_node_store *store = ir_node_store_of(n);
+	int out_of_line = n->op == IR_OP_phi || n->n_args > IR_NODE_INLINE_ARGS;
+	unsigned room = out_of_line ? word_pool_room(n->n_args) : IR_NODE_INLINE_ARGS;
+	unsigned new_room;
+	unsigned words;
+
+	assert(n_args <= USHRT_MAX && "Too many operands!");
+	if (n_args <= room)
+	{
+		return;
+	}
 
+	new_room = word_pool_room(n_args);
+	if (out_of_line)
+	{
+		n->args.words = word_pool_realloc(&store->pool, n->args.words, room, new_room);
+	}
+	else
+	{
+		words = word_pool_alloc(&store->pool, new_room);
+		memcpy(store->pool.words + words, n->args.slots, n->n_args * sizeof(*store->pool.words));
+		n->args.words = words;
+	}
 
-static unsigned global_node_id = 0;
+	if (n->op == IR_OP_phi)
+	{
+		ir_node_cold *cold = ir_node_cold_of(n);
+		cold->u.phi.bbs = word_pool_realloc(&store->pool, cold->u.phi.bbs, room, new_room);
+	}
+}
 
-static int
-edge_cmp(void *a, void *b)
+static void
+use_add(ir_node *arg, ir_node *user, unsigned idx)
 {
-	ir_node *n_a = a;
-	ir_node *n_b = b;
-	int id_a, id_b;
+	ir_node_store *store = ir_node_store_of(arg);
+	ir_node_cold *cold = ir_node_cold_of(arg);
+	ir_func *func = store->func;
+	ir_node_use *use;
 
-	switch (n_a->op)
+	if (arg->n_uses == cold->uses_room)
 	{
-		case IR_OP_br:
-		case IR_OP_ret:
-		case IR_OP_term:
-			id_a = n_a->bb->id * 0x10000;
-			break;
-		default:
-			id_a = n_a->id;
-			break;
+		unsigned room = word_pool_room(arg->n_uses + 1);
+		unsigned words;
+
+		if (cold->uses_room > 1)
+		{
+			words = word_pool_realloc(&store->pool, arg->uses.words, cold->uses_room * 2, room * 2);
+		}
+		else
+		{
+			words = word_pool_alloc(&store->pool, room * 2);
+			memcpy(store->pool.words + words, &arg->uses.inline_use, arg->n_uses * sizeof(*use));
+		}
+		arg->uses.words = words;
+		cold->uses_room = room;
 	}
 
-	switch (n_b->op)
+	use = &ir_node_uses(arg)[arg->n_uses++];
+	use->node = ir_node_slot(user);
+	use->idx = idx;
+
+	func->ssa_graph_ctx.version++;
+	func->ssa_graph_ctx.n_edges++;
+}
+
+static void
+use_remove(ir_node *arg, ir_node *user, unsigned idx)
+{
+	ir_func *func = ir_node_store_of(arg)->func;
+	ir_node_use *uses = ir_node_uses(arg);
+	unsigned slot = ir_node_slot(user);
+	unsigned i;
+
+	for (i = 0; i < arg->n_uses; i++)
 	{
-		case IR_OP_br:
-		case IR_OP_ret:
-		case IR_OP_term:
-			id_b = n_b->bb->id * 0x10000;
-			break;
-		default:
-			id_b = n_b->id;
+		if (uses[i].node == slot && uses[i].idx == idx)
+		{
 			break;
+		}
 	}
 
-	return id_a - id_b;
+	assert(i < arg->n_uses && "Use not found!");
+	arg->n_uses--;
+	memmove(&uses[i], &uses[i + 1], (arg->n_uses - i) * sizeof(*uses));
+
+	func->ssa_graph_ctx.version++;
+	func->ssa_graph_ctx.n_edges--;
 }
 
 static void
 bb_link_phi_last(ir_node *n, ir_bb *bb)
 {
+	ir_node_store *store = ir_node_store_of(n);
+	unsigned slot = ir_node_slot(n);
+
 	assert(n->op == IR_OP_phi);
-	n->bb_list_next = NULL;
+	n->bb_list_next = 0;
 	n->bb_list_prev = bb->last_ir_phi_node;
-	if (bb->first_ir_phi_node != NULL)
+	if (bb->first_ir_phi_node != 0)
 	{
-		assert(bb->last_ir_phi_node != NULL);
-		bb->last_ir_phi_node->bb_list_next = n;
+		assert(bb->last_ir_phi_node != 0);
+		ir_node_at(store, bb->last_ir_phi_node)->bb_list_next = slot;
 	}
 	else
 	{
-		assert(bb->last_ir_phi_node == NULL);
-		bb->first_ir_phi_node = n;
+		assert(bb->last_ir_phi_node == 0);
+		bb->first_ir_phi_node = slot;
 	}
-	bb->last_ir_phi_node = n;
+	bb->last_ir_phi_node = slot;
 }
 
 static void
 bb_unlink_phi(ir_node *n)
 {
-	ir_bb *bb = n->bb;
+	ir_node_store *store = ir_node_store_of(n);
+	ir_bb *bb = ir_node_store_bb(store, n->bb);
+	unsigned slot = ir_node_slot(n);
 	assert(n->op == IR_OP_phi);
 
-	if (bb->first_ir_phi_node == n)
+	if (bb->first_ir_phi_node == slot)
 	{
-		assert(n->bb_list_prev == NULL);
+		assert(n->bb_list_prev == 0);
 		bb->first_ir_phi_node = n->bb_list_next;
 	}
 	else
 	{
-		assert(n->bb_list_prev != NULL);
-		n->bb_list_prev->bb_list_next = n->bb_list_next;
+		assert(n->bb_list_prev != 0);
+		ir_node_at(store, n->bb_list_prev)->bb_list_next = n->bb_list_next;
 	}
 
-	if (bb->last_ir_phi_node == n)
+	if (bb->last_ir_phi_node == slot)
 	{
-		assert(n->bb_list_next == NULL);
+		assert(n->bb_list_next == 0);
 		bb->last_ir_phi_node = n->bb_list_prev;
 	}
 	else
 	{
-		assert(n->bb_list_next != NULL);
-		n->bb_list_next->bb_list_prev = n->bb_list_prev;
+		assert(n->bb_list_next != 0);
+		ir_node_at(store, n->bb_list_next)->bb_list_prev = n->bb_list_prev;
 	}
 
-	n->bb_list_prev = NULL;
-	n->bb_list_next = NULL;
+	n->bb_list_prev = 0;
+	n->bb_list_next = 0;
 }
 static void
 bb_link_last(ir_node *n, ir_bb *bb)
 {
+	ir_node_store *store = ir_node_store_of(n);
+	unsigned slot = ir_node_slot(n);
+
 	assert(n->op != IR_OP_phi);
-	n->bb_list_next = NULL;
+	n->bb_list_next = 0;
 	n->bb_list_prev = bb->last_ir_node;
-	if (bb->first_ir_node != NULL)
+	if (bb->first_ir_node != 0)
 	{
-		assert(bb->last_ir_node != NULL);
-		bb->last_ir_node->bb_list_next = n;
+		assert(bb->last_ir_node != 0);
+		ir_node_at(store, bb->last_ir_node)->bb_list_next = slot;
 	}
 	else
 	{
-		assert(bb->last_ir_node == NULL);
-		bb->first_ir_node = n;
+		assert(bb->last_ir_node == 0);
+		bb->first_ir_node = slot;
 	}
-	bb->last_ir_node = n;
+	bb->last_ir_node = slot;
 }
 
 static void
 bb_link_before(ir_node *n, ir_node *before, ir_bb *bb)
 {
+	ir_node_store *store = ir_node_store_of(n);
+	unsigned slot = ir_node_slot(n);
+
 	assert(n->op != IR_OP_phi);
-	n->bb_list_next = before;
-	if (before->bb_list_prev != NULL)
+	n->bb_list_next = ir_node_slot(before);
+	if (before->bb_list_prev != 0)
 	{
-		before->bb_list_prev->bb_list_next = n;
+		ir_node_at(store, before->bb_list_prev)->bb_list_next = slot;
 		n->bb_list_prev = before->bb_list_prev;
 	}
 	else
 	{
-		n->bb_list_prev = NULL;
-		bb->first_ir_node = n;
+		n->bb_list_prev = 0;
+		bb->first_ir_node = slot;
 	}
-	before->bb_list_prev = n;
+	before->bb_list_prev = slot;
 }
 
 static void
 bb_unlink(ir_node *n)
 {
-	ir_bb *bb = n->bb;
+	ir_node_store *store = ir_node_store_of(n);
+	ir_bb *bb = ir_node_store_bb(store, n->bb);
+	unsigned slot = ir_node_slot(n);
 	assert(n->op != IR_OP_phi);
 
-	if (bb->first_ir_node == n)
+	if (bb->first_ir_node == slot)
 	{
-		assert(n->bb_list_prev == NULL);
+		assert(n->bb_list_prev == 0);
 		bb->first_ir_node = n->bb_list_next;
 	}
 	else
 	{
-		assert(n->bb_list_prev != NULL);
-		n->bb_list_prev->bb_list_next = n->bb_list_next;
+		assert(n->bb_list_prev != 0);
+		ir_node_at(store, n->bb_list_prev)->bb_list_next = n->bb_list_next;
 	}
 
-	if (bb->last_ir_node == n)
+	if (bb->last_ir_node == slot)
 	{
-		assert(n->bb_list_next == NULL);
+		assert(n->bb_list_next == 0);
 		bb->last_ir_node = n->bb_list_prev;
 	}
 	else
 	{
-		assert(n->bb_list_next != NULL);
-		n->bb_list_next->bb_list_prev = n->bb_list_prev;
+		assert(n->bb_list_next != 0);
+		ir_node_at(store, n->bb_list_next)->bb_list_prev = n->bb_list_prev;
 	}
 
-	n->bb_list_prev = NULL;
-	n->bb_list_next = NULL;
+	n->bb_list_prev = 0;
+	n->bb_list_next = 0;
 }
 
 static void
 bb_redist_depth(ir_bb *bb)
 {
+	ir_node_store *store = bb->func->node_store;
 	unsigned depth = 0x10000;
 	ir_node *n;
-	for (n = bb->first_ir_node; n != NULL; n = n->bb_list_next)
+	for (n = ir_node_at(store, bb->first_ir_node); n != NULL; n = ir_node_at(store, n->bb_list_next))
 	{
-		n->bb_list_depth = depth;
+		ir_node_cold_of(n)->bb_list_depth = depth;
 		depth += 0x10000;
 	}
 }
@@ -215,26 +286,30 @@ bb_redist_depth(ir_bb *bb)
 static void
 bb_move_up_before(ir_node *before, ir_node *n)
 {
-	graph_edge *edge;
+	ir_node_store *store = ir_node_store_of(n);
+	ir_bb *bb = ir_node_store_bb(store, before->bb);
+	ir_node_cold *cold = ir_node_cold_of(n);
 	unsigned dist;
+	unsigned i;
 
-	dist = before->bb_list_depth - (before->bb_list_prev ? before->bb_list_prev->bb_list_depth : 0);
+	dist = ir_node_cold_of(before)->bb_list_depth -
+	       (before->bb_list_prev ? ir_node_cold_of(ir_node_at(store, before->bb_list_prev))->bb_list_depth : 0);
 
 	if (dist < 2)
 	{
-		bb_redist_depth(before->bb);
+		bb_redist_depth(bb);
 	}
 
 	bb_unlink(n);
-	n->bb_list_depth = before->bb_list_depth - dist/2;
-	bb_link_before(n, before, before->bb);
+	cold->bb_list_depth = ir_node_cold_of(before)->bb_list_depth - dist/2;
+	bb_link_before(n, before, bb);
 
-	for (edge = graph_pred_first((graph_node *)n); edge != NULL; edge = graph_pred_next(edge))
+	for (i = 0; i < n->n_args; i++)
 	{
-		ir_node *pred = (ir_node *)graph_edge_tail(edge);
+		ir_node *pred = ir_node_arg(n, i);
 		if (pred->bb == n->bb &&
 		    pred->op != IR_OP_phi &&
-		    pred->bb_list_depth > n->bb_list_depth)
+		    ir_node_cold_of(pred)->bb_list_depth > cold->bb_list_depth)
 		{
 			bb_move_up_before(n, pred);
 		}
@@ -244,138 +319,174 @@ bb_move_up_before(ir_node *before, ir_node *n)
 static void
 bb_move_up_if_needed(ir_node *n)
 {
-	graph_edge *edge;
+	ir_node_store *store = ir_node_store_of(n);
+	ir_node_use *uses = ir_node_uses(n);
 	ir_node *min_node = NULL;
 	unsigned min_depth = UINT_MAX;
+	unsigned i;
 
-	for (edge = graph_succ_first((graph_node *)n); edge != NULL; edge = graph_succ_next(edge))
+	for (i = 0; i < n->n_uses; i++)
 	{
-		ir_node *succ = (ir_node *)graph_edge_head(edge);
+		ir_node *succ = ir_node_at(store, uses[i].node);
 		if (succ->bb == n->bb &&
 		    succ->op != IR_OP_phi &&
 		    succ->op != IR_OP_term &&
-		    succ->bb_list_depth < min_depth)
+		    ir_node_cold_of(succ)->bb_list_depth < min_depth)
 		{
-			min_depth = succ->bb_list_depth;
+			min_depth = ir_node_cold_of(succ)->bb_list_depth;
 			min_node = succ;
 		}
 	}
 
-	if (min_node != NULL && n->bb_list_depth > min_node->bb_list_depth)
+	if (min_node != NULL && ir_node_cold_of(n)->bb_list_depth > min_depth)
 	{
 		bb_move_up_before(min_node, n);
 	}
 }
 
+/*
+ * Nodes without uses are queued on the unused list of the function and
+ * freed by ir_func_free_unused_nodes(). A node that gets used again stays
+ * queued and is skipped when the queue is drained, so both transitions are
+ * O(1) and only a single link is needed.
+ */
 static void
 mark_unused(ir_node *n, ir_func *func)
 {
+	ir_node_store *store = func->node_store;
+	ir_node_cold *cold = ir_node_cold_of(n);
+	unsigned slot;
+
 	if (n->op == IR_OP_call || n->op == IR_OP_store)
 	{
 		return;
 	}
 
-	assert(n->status == IR_NODE_USED);
-	n->unused_list_next = NULL;
-	n->unused_list_prev = func->last_unused_ir_node;
-	if (func->first_unused_ir_node != NULL)
+	assert(cold->status == IR_NODE_USED);
+	cold->status = IR_NODE_UNUSED;
+	if (cold->in_unused_list)
 	{
-		assert(func->last_unused_ir_node != NULL);
-		func->last_unused_ir_node->unused_list_next = n;
+		return;
+	}
+
+	slot = ir_node_slot(n);
+	cold->in_unused_list = 1;
+	cold->unused_list_next = 0;
+	if (store->first_unused != 0)
+	{
+		assert(store->last_unused != 0);
+		ir_node_cold_of(ir_node_at(store, store->last_unused))->unused_list_next = slot;
 	}
 	else
 	{
-		assert(func->last_unused_ir_node == NULL);
-		func->first_unused_ir_node = n;
+		assert(store->last_unused == 0);
+		store->first_unused = slot;
 	}
-	func->last_unused_ir_node = n;
-	n->status = IR_NODE_UNUSED;
+	store->last_unused = slot;
 }
 
 static void
 mark_used(ir_node *n)
 {
-	ir_func *func = n->bb->func;
 	if (n->op == IR_OP_call || n->op == IR_OP_store)
 	{
 		return;
 	}
 
-	assert(n->status == IR_NODE_UNUSED);
-	if (func->first_unused_ir_node == n)
-	{
-		assert(n->unused_list_prev == NULL);
-		func->first_unused_ir_node = n->unused_list_next;
-	}
-	else
-	{
-		assert(n->unused_list_prev != NULL);
-		n->unused_list_prev->unused_list_next = n->unused_list_next;
-	}
+	assert(ir_node_cold_of(n)->status == IR_NODE_UNUSED);
+	ir_node_cold_of(n)->status = IR_NODE_USED;
+}
 
-	if (func->last_unused_ir_node == n)
-	{
-		assert(n->unused_list_next == NULL);
-		func->last_unused_ir_node = n->unused_list_prev;
-	}
-	else
+static ir_node *
+store_alloc_node(ir_node_store *store)
+{
+	unsigned slot = store->n_slots++;
+	ir_node_block *b;
+	ir_node *n;
+
+	if (slot / IR_NODE_BLOCK_NODES == store->n_blocks)
 	{
-		assert(n->unused_list_next != NULL);
-		n->unused_list_next->unused_list_prev = n->unused_list_prev;
+		if (store->n_blocks == store->blocks_room)
+		{
+			store->blocks_room *= 2;
+			store->blocks = realloc(store->blocks, store->blocks_room * sizeof(*store->blocks));
+		}
+		b = aligned_alloc(IR_NODE_BLOCK_SIZE, IR_NODE_BLOCK_SIZE);
+		assert(b != NULL);
+		b->store = store;
+		b->first_slot = store->n_blocks * IR_NODE_BLOCK_NODES;
+		store->blocks[store->n_blocks++] = b;
 	}
 
-	n->unused_list_prev = NULL;
-	n->unused_list_next = NULL;
-	n->status = IR_NODE_USED;
-}
+	n = ir_node_at(store, slot);
+	memset(n, 0, sizeof(*n));
+	memset(ir_node_cold_of(n), 0, sizeof(ir_node_cold));
 
+	return n;
+}
 
 static ir_node *
 build_node(ir_bb *bb, ir_op op, ir_type type)
 {
-	ir_node *n = (ir_node *)graph_create_node(sizeof(ir_node));
+	ir_func *func = bb->func;
+	ir_node_store *store = func->node_store;
+	ir_node *n = store_alloc_node(store);
+	ir_node_cold *cold = ir_node_cold_of(n);
+
+	func->ssa_graph_ctx.n_nodes++;
 	n->op = op;
 	n->type = type;
-	n->bb = bb;
-	n->id = ++global_node_id;
-	n->status = IR_NODE_USED;
+	n->bb = bb->id;
+	n->id = ++func->node_id_cntr;
+	cold->status = IR_NODE_USED;
+	cold->uses_room = 1;
+
+	if (op == IR_OP_phi)
+	{
+		n->args.words = word_pool_alloc(&store->pool, word_pool_room(0));
+		cold->u.phi.bbs = word_pool_alloc(&store->pool, word_pool_room(0));
+	}
 
 	if (op != IR_OP_term)
 	{
 		bb->n_ir_nodes++;
-		bb->func->n_ir_nodes++;
+		func->n_ir_nodes++;
 		if (op == IR_OP_phi)
 		{
-			n->bb_list_depth = 0;
+			cold->bb_list_depth = 0;
 			bb_link_phi_last(n, bb);
 		}
 		else
 		{
-			n->bb_list_depth = (bb->last_ir_node != NULL ? bb->last_ir_node->bb_list_depth : 0) + 0x10000;
+			ir_node *last = ir_node_at(store, bb->last_ir_node);
+			cold->bb_list_depth = (last != NULL ? ir_node_cold_of(last)->bb_list_depth : 0) + 0x10000;
 			bb_link_last(n, bb);
 		}
 		if (op != IR_OP_store && op != IR_OP_call)
 		{
-			mark_unused(n, bb->func);
+			mark_unused(n, func);
 		}
 	}
 
 	return n;
 }
 
+/* The count goes up before the slot is written, as it decides where calls
+   keep their operands */
 static void
 add_arg(ir_node *n, unsigned arg_idx, ir_node *arg)
 {
-	graph_ctx *gctx = &n->bb->func->ssa_graph_ctx;
-	node_edge *arg_edge;
+	assert(arg_idx == n->n_args);
 
-	if (graph_succ_first((graph_node *)arg) == NULL)
+	if (arg->n_uses == 0)
 	{
 		mark_used(arg);
 	}
 
-	arg_edge = (node_edge *)graph_edge_create(gctx, (graph_node*)arg, (graph_node*)n, sizeof(node_edge), edge_cmp);
-	arg_edge->u.arg.idx = arg_idx;
+	args_reserve(n, n->n_args + 1);
+	n->n_args++;
+	ir_node_args(n)[arg_idx] = ir_node_slot(arg);
+	use_add(arg, n, arg_idx);
 }
 
 ir_node *
@@ -450,20 +561,20 @@ ir_node_build_const(ir_bb *bb, ir_type type, unsigned value)
 
 	switch (type) {
 	case i1:
-		n->u.constant.u.i1 = value ? 1 : 0;;
+		ir_node_cold_of(n)->u.constant.u.i1 = value ? 1 : 0;;
 		break;
 	case i8:
-		n->u.constant.u.i8 = value;
+		ir_node_cold_of(n)->u.constant.u.i8 = value;
 		break;
 	case i16:
-		n->u.constant.u.i16 = value;
+		ir_node_cold_of(n)->u.constant.u.i16 = value;
 		break;
 	case i32:
 	case p32:
-		n->u.constant.u.i32 = value;
+		ir_node_cold_of(n)->u.constant.u.i32 = value;
 	case i64:
 	case p64:
-		n->u.constant.u.i64 = value;
+		ir_node_cold_of(n)->u.constant.u.i64 = value;
 		break;
 	default:
 		assert(0);
@@ -482,8 +593,8 @@ ir_node_build_alloca(ir_bb *bb, unsigned size, unsigned align)
 
 	n = build_node(bb, IR_OP_alloca, p32);
 
-	n->u.alloca.size = size;
-	n->u.alloca.align = align;
+	ir_node_cold_of(n)->u.alloca.size = size;
+	ir_node_cold_of(n)->u.alloca.align = align;
 
 	ir_validate_node(n);
 
@@ -497,7 +608,7 @@ ir_node_build_addr_of(ir_bb *bb, ir_data *sym)
 
 	n = build_node(bb, IR_OP_addr_of, p32);
 
-	n->u.addr_of.sym = sym;
+	ir_node_cold_of(n)->u.addr_of.sym = sym;
 
 	ir_validate_node(n);
 
@@ -511,7 +622,7 @@ ir_node_build_getparam(ir_bb *bb, ir_type type, unsigned idx)
 
 	n = build_node(bb, IR_OP_getparam, type);
 
-	n->u.getparam.idx = idx;
+	ir_node_cold_of(n)->u.getparam.idx = idx;
 
 	ir_validate_node(n);
 
@@ -531,7 +642,7 @@ ir_node_build_call(ir_bb *bb, ir_func *target, ir_type type, unsigned n_args, ir
 		add_arg(n, i, args[i]);
 	}
 
-	n->u.call.target = target;
+	ir_node_cold_of(n)->u.call.target = target;
 
 	ir_validate_node(n);
 
@@ -554,17 +665,21 @@ ir_node_build_phi(ir_bb *bb, ir_type type)
 void
 ir_node_add_phi_arg(ir_node *phi, ir_bb *arg_bb, ir_node *arg)
 {
-	graph_ctx *gctx = &phi->bb->func->ssa_graph_ctx;
-	node_edge *phi_edge;
+	ir_node_store *store;
+
 	assert(phi->op == IR_OP_phi);
 
-	if (graph_succ_first((graph_node *)arg) == NULL)
+	if (arg->n_uses == 0)
 	{
 		mark_used(arg);
 	}
 
-	phi_edge = (node_edge *)graph_edge_create(gctx, (graph_node*)arg, (graph_node*)phi, sizeof(node_edge), edge_cmp);
-	phi_edge->u.phi_arg.bb = arg_bb;
+	args_reserve(phi, phi->n_args + 1);
+	store = ir_node_store_of(phi);
+	ir_node_args(phi)[phi->n_args] = ir_node_slot(arg);
+	store->pool.words[ir_node_cold_of(phi)->u.phi.bbs + phi->n_args] = arg_bb->id;
+	use_add(arg, phi, phi->n_args);
+	phi->n_args++;
 
 	ir_validate_node(phi);
 }
@@ -572,21 +687,21 @@ ir_node_add_phi_arg(ir_node *phi, ir_bb *arg_bb, ir_node *arg)
 void
 ir_node_remove(ir_node *n)
 {
-	graph_ctx *gctx = &n->bb->func->ssa_graph_ctx;
-	ir_node *args[4];
-	unsigned n_args;
+	ir_node_store *store = ir_node_store_of(n);
+	ir_func *func = store->func;
+	graph_ctx *gctx = &func->ssa_graph_ctx;
 	unsigned i;
 
 	if (n->op == IR_OP_store || n->op == IR_OP_call)
 	{
-		mark_unused(n, n->bb->func);
+		mark_unused(n, func);
 	}
 
-	assert(graph_succ_first((graph_node *)n) == NULL && "Cannot remove used node!");
+	assert(n->n_uses == 0 && "Cannot remove used node!");
 
-	mark_used(n); /* remove it from unused list */
-	n->bb->n_ir_nodes--;
-	n->bb->func->n_ir_nodes--;
+	mark_used(n); /* skipped when the unused list is drained */
+	ir_node_store_bb(store, n->bb)->n_ir_nodes--;
+	func->n_ir_nodes--;
 
 	if (n->op == IR_OP_phi)
 	{
@@ -597,69 +712,84 @@ ir_node_remove(ir_node *n)
 		bb_unlink(n);
 	}
 
-	ir_node_get_args(n, &n_args, args, sizeof(args)/sizeof(args[0]));
-	for (i = 0; i < n_args; i++)
+	for (i = 0; i < n->n_args; i++)
 	{
-		graph_edge *edge = graph_succ_first((graph_node *)args[i]);
-		if (edge != NULL && graph_succ_next(edge) == NULL)
+		ir_node *arg = ir_node_arg(n, i);
+		if (arg->n_uses == 1)
 		{
-			/* pred with exactly one succ (n) will become unused */
-			mark_unused(args[i], args[i]->bb->func);
+			/* arg with exactly one use (n) will become unused */
+			mark_unused(arg, func);
 		}
+		use_remove(arg, n, i);
 	}
 
-	graph_node_delete(gctx, (graph_node *)n);
+	gctx->version++;
+	gctx->n_nodes--;
 }
 
 void
 ir_node_replace(ir_node *old, ir_node *new)
 {
-	graph_ctx *gctx = &old->bb->func->ssa_graph_ctx;
-	graph_edge *edge, *next_edge;
+	ir_node_store *store = ir_node_store_of(old);
+	graph_ctx *gctx = &store->func->ssa_graph_ctx;
+	unsigned slot = ir_node_slot(new);
+	unsigned i;
+
+	assert(old != new);
+	assert(ir_node_store_of(new) == store);
 
-	if (graph_succ_first((graph_node *)old) != NULL)
+	if (old->n_uses != 0)
 	{
-		mark_unused(old, old->bb->func);
-		if (graph_succ_first((graph_node *)new) == NULL)
+		mark_unused(old, store->func);
+		if (new->n_uses == 0)
 		{
 			mark_used(new);
 		}
 	}
 
-	for (edge = graph_succ_first((graph_node *)old); edge != NULL; edge = next_edge)
+	for (i = 0; i < old->n_uses; i++)
 	{
-		ir_node *succ = (ir_node *)graph_edge_head(edge);
-		node_edge *new_edge = (node_edge *)graph_edge_create(gctx, (graph_node*)new, (graph_node*)succ, sizeof(node_edge), edge_cmp);
-		new_edge->u = ((node_edge *)edge)->u;
-		next_edge = graph_succ_next(edge);
-		graph_edge_delete(gctx, edge);
-		ir_validate_node(succ);
+		/* Copied, adding a use may move the use arrays */
+		ir_node_use use = ir_node_uses(old)[i];
+		ir_node *user = ir_node_at(store, use.node);
+		ir_node_args(user)[use.idx] = slot;
+		use_add(new, user, use.idx);
+		ir_validate_node(user);
 	}
 
+	gctx->version++;
+	gctx->n_edges -= old->n_uses;
+	old->n_uses = 0;
+
 	bb_move_up_if_needed(new);
 }
 
 void
 ir_node_change_arg(ir_node *n, ir_node *old_arg, ir_node *new_arg)
 {
-	graph_ctx *gctx = &n->bb->func->ssa_graph_ctx;
-	graph_edge *edge, *next_edge;
+	unsigned old_slot = ir_node_slot(old_arg);
+	unsigned i;
 
-	assert(0 && "Needs to handle unused");
+	if (new_arg->n_uses == 0)
+	{
+		mark_used(new_arg);
+	}
 
-	for (edge = graph_pred_first((graph_node *)n); edge != NULL; edge = next_edge)
+	for (i = 0; i < n->n_args; i++)
 	{
-		ir_node *pred = (ir_node *)graph_edge_tail(edge);
-		next_edge = graph_pred_next(edge);
-		if (pred == old_arg)
+		if (ir_node_args(n)[i] == old_slot)
 		{
-			node_edge *new_edge = (node_edge *)graph_edge_create(
-					gctx, (graph_node*)new_arg, (graph_node*)n, sizeof(node_edge), edge_cmp);
-			new_edge->u.arg.idx = ((node_edge *)edge)->u.arg.idx;
-			graph_edge_delete(gctx, edge);
+			use_remove(old_arg, n, i);
+			ir_node_args(n)[i] = ir_node_slot(new_arg);
+			use_add(new_arg, n, i);
 		}
 	}
 
+	if (old_arg->n_uses == 0)
+	{
+		mark_unused(old_arg, ir_node_store_of(old_arg)->func);
+	}
+
 	ir_validate_node(n);
 
 	bb_move_up_if_needed(new_arg);
@@ -669,180 +799,184 @@ int
 ir_node_cmp(ir_node *a, ir_node *b)
 {
 	assert(a->bb == b->bb);
-	return a->bb_list_depth - b->bb_list_depth;
+	return ir_node_cold_of(a)->bb_list_depth - ir_node_cold_of(b)->bb_list_depth;
 }
 
 void
 ir_node_arg_iter_init(ir_node_arg_iter *it, ir_node *n)
 {
 	assert(n->op != IR_OP_phi);
-	it->next_edge = graph_pred_first((graph_node*)n);
+	it->n = n;
+	it->next = 0;
 }
 
 ir_node *
 ir_node_arg_iter_next(ir_node_arg_iter *it, unsigned *arg_idx)
 {
-	if (it->next_edge == NULL)
+	if (it->next >= it->n->n_args)
 	{
 		return NULL;
 	}
-	else
+
+	if (arg_idx != NULL)
 	{
-		ir_node *arg = (ir_node *)graph_edge_tail(it->next_edge);
-		if (arg_idx != NULL)
-		{
-			*arg_idx = ((node_edge *)it->next_edge)->u.arg.idx;
-		}
-		it->next_edge = graph_pred_next(it->next_edge);
-		return arg;
+		*arg_idx = it->next;
 	}
+	return ir_node_arg(it->n, it->next++);
 }
 
 void
 ir_node_phi_arg_iter_init(ir_node_phi_arg_iter *it, ir_node *phi)
 {
 	assert(phi->op == IR_OP_phi);
-	it->next_edge = graph_pred_first((graph_node*)phi);
+	it->n = phi;
+	it->next = 0;
 }
 
 ir_node *
 ir_node_phi_arg_iter_next(ir_node_phi_arg_iter *it, ir_bb **arg_bb)
 {
-	if (it->next_edge == NULL)
+	if (it->next >= it->n->n_args)
 	{
 		return NULL;
 	}
-	else
+
+	if (arg_bb != NULL)
 	{
-		ir_node *arg = (ir_node *)graph_edge_tail(it->next_edge);
-		if (arg_bb != NULL)
-		{
-			*arg_bb = ((node_edge *)it->next_edge)->u.phi_arg.bb;
-		}
-		it->next_edge = graph_pred_next(it->next_edge);
-		return arg;
+		*arg_bb = ir_node_phi_bb(it->n, it->next);
 	}
+	return ir_node_arg(it->n, it->next++);
 }
 
 void
 ir_node_use_iter_init(ir_node_use_iter *it, ir_node *n)
 {
-	it->next_edge = graph_succ_first((graph_node*)n);
+	it->n = n;
+	it->next = 0;
 }
 
 ir_node *
 ir_node_use_iter_next(ir_node_use_iter *it, unsigned *arg_idx)
 {
-	if (it->next_edge == NULL)
+	ir_node_use *use;
+	ir_node *user;
+
+	if (it->next >= it->n->n_uses)
 	{
 		return NULL;
 	}
-	else
+
+	use = &ir_node_uses(it->n)[it->next++];
+	user = ir_node_at(ir_node_store_of(it->n), use->node);
+	if (arg_idx != NULL && user->op != IR_OP_phi)
 	{
-		ir_node *use = (ir_node *)graph_edge_head(it->next_edge);
-		if (arg_idx != NULL && use->op != IR_OP_phi)
-		{
-			*arg_idx = ((node_edge *)it->next_edge)->u.arg.idx;
-		}
-		it->next_edge = graph_succ_next(it->next_edge);
-		return use;
+		*arg_idx = use->idx;
 	}
+	return user;
 }
 
 void
 ir_node_get_args(ir_node *n, unsigned *n_args, ir_node **args, unsigned args_size)
 {
-	graph_edge *edge = graph_pred_first((graph_node*)n);
-	unsigned counter = 0;
+	unsigned i;
 
 	assert(n->op != IR_OP_phi);
 
-	while (edge)
+	for (i = 0; i < n->n_args && i < args_size; i++)
 	{
-		ir_node *arg = (ir_node *)graph_edge_tail(edge);
-		unsigned arg_idx = ((node_edge *)edge)->u.arg.idx;
-
-		if (arg_idx < args_size)
-		{
-			args[arg_idx] = arg;
-		}
-		counter++;
-		edge = graph_pred_next(edge);
+		args[i] = ir_node_arg(n, i);
 	}
 
 	if (n_args != NULL)
 	{
-		*n_args = counter;
+		*n_args = n->n_args;
 	}
 }
 
+/*
+ * Node iteration walks the phi list followed by the regular node list (or
+ * the reverse). The successor is fetched before a node is handed out so the
+ * current node may be removed. Nodes appended behind the current node are
+ * visited only if it was not the last one of its list, as the iterator has
+ * then already moved on to the other list or to the end.
+ */
+static void
+node_iter_enter_second_list(ir_node_iter *it)
+{
+	it->in_phis = !it->in_phis;
+	it->next = ir_node_at(it->bb->func->node_store, it->rev ? it->bb->last_ir_phi_node : it->bb->first_ir_node);
+}
+
 void
 ir_node_iter_init(ir_node_iter *it, ir_bb *bb)
 {
-	ir_node *n;
-	unsigned idx = 0;
-
-	it->po_nodes = calloc(bb->n_ir_nodes, sizeof(ir_node *));
-
-	idx = bb->n_ir_nodes;
-	for (n = bb->first_ir_phi_node; n != NULL; n = n->bb_list_next)
+	it->bb = bb;
+	it->rev = 0;
+	it->in_phis = 1;
+	it->next = ir_node_at(bb->func->node_store, bb->first_ir_phi_node);
+	if (it->next == NULL)
 	{
-		assert(n->op == IR_OP_phi);
-		it->po_nodes[--idx] = n;
+		node_iter_enter_second_list(it);
 	}
-	for (n = bb->first_ir_node; n != NULL; n = n->bb_list_next)
-	{
-		assert(n->op != IR_OP_phi);
-		it->po_nodes[--idx] = n;
-	}
-	assert(idx == 0);
-	it->idx = bb->n_ir_nodes;
 }
 
 void
 ir_node_iter_rev_init(ir_node_iter *it, ir_bb *bb)
 {
-	ir_node *n;
-	unsigned idx = 0;
-
-	it->po_nodes = calloc(bb->n_ir_nodes, sizeof(ir_node *));
-
-	idx = bb->n_ir_nodes;
-	for (n = bb->last_ir_phi_node; n != NULL; n = n->bb_list_prev)
-	{
-		assert(n->op == IR_OP_phi);
-		it->po_nodes[--idx] = n;
-	}
-	for (n = bb->last_ir_node; n != NULL; n = n->bb_list_prev)
+	it->bb = bb;
+	it->rev = 1;
+	it->in_phis = 0;
+	it->next = ir_node_at(bb->func->node_store, bb->last_ir_node);
+	if (it->next == NULL)
 	{
-		assert(n->op != IR_OP_phi);
-		it->po_nodes[--idx] = n;
+		node_iter_enter_second_list(it);
 	}
-	assert(idx == 0);
-	it->idx = bb->n_ir_nodes;
 }
 
 ir_node *
 ir_node_iter_next(ir_node_iter *it)
 {
-	if (it->idx == 0)
+	ir_node *n = it->next;
+
+	if (n == NULL)
 	{
 		return NULL;
 	}
-	else
+
+	assert((n->op == IR_OP_phi) == it->in_phis);
+
+	it->next = ir_node_at(ir_node_store_of(n), it->rev ? n->bb_list_prev : n->bb_list_next);
+	if (it->next == NULL && it->in_phis != it->rev)
 	{
-		return it->po_nodes[--it->idx];
+		node_iter_enter_second_list(it);
 	}
+
+	return n;
 }
 
 void ir_func_free_unused_nodes(ir_func *func)
 {
-	while (func->first_unused_ir_node != NULL)
+	ir_node_store *store = func->node_store;
+
+	while (store->first_unused != 0)
 	{
-		ir_node *n = func->first_unused_ir_node;
+		ir_node *n = ir_node_at(store, store->first_unused);
+		ir_node_cold *cold = ir_node_cold_of(n);
+		unsigned i;
 
-		n->bb->n_ir_nodes--;
-		n->bb->func->n_ir_nodes--;
+		store->first_unused = cold->unused_list_next;
+		if (store->first_unused == 0)
+		{
+			store->last_unused = 0;
+		}
+		cold->in_unused_list = 0;
+		if (cold->status != IR_NODE_UNUSED)
+		{
+			continue;
+		}
+
+		ir_node_store_bb(store, n->bb)->n_ir_nodes--;
+		func->n_ir_nodes--;
 		if (n->op == IR_OP_phi)
 		{
 			bb_unlink_phi(n);
@@ -853,63 +987,134 @@ void ir_func_free_unused_nodes(ir_func *func)
 		}
 		mark_used(n);
 
-		if (n->op == IR_OP_phi)
+		for (i = 0; i < n->n_args; i++)
 		{
-			ir_node_phi_arg_iter it;
-			ir_node *arg;
-
-			ir_node_phi_arg_iter_init(&it, n);
-			while ((arg = ir_node_phi_arg_iter_next(&it, NULL)))
+			ir_node *arg = ir_node_arg(n, i);
+			if (arg->n_uses == 1)
 			{
-				graph_edge *edge = graph_succ_first((graph_node *)arg);
-				if (edge != NULL && graph_succ_next(edge) == NULL)
-				{
-					mark_unused(arg, arg->bb->func);
-				}
+				mark_unused(arg, func);
 			}
+			use_remove(arg, n, i);
 		}
-		else
-		{
-			ir_node *args[4];
-			unsigned n_args;
-			unsigned i;
 
-			ir_node_get_args(n, &n_args, args, sizeof(args)/sizeof(args[0]));
-			for (i = 0; i < n_args; i++)
-			{
-				graph_edge *edge = graph_succ_first((graph_node *)args[i]);
-				if (edge != NULL && graph_succ_next(edge) == NULL)
-				{
-					mark_unused(args[i], args[i]->bb->func);
-				}
-			}
-		}
+		func->ssa_graph_ctx.version++;
+		func->ssa_graph_ctx.n_nodes--;
+	}
+}
 
-		graph_node_delete(&func->ssa_graph_ctx, (graph_node *)n);
+void
+ir_func_renumber_nodes(ir_func *func)
+{
+	ir_bb_iter bit;
+	ir_bb *bb;
+	unsigned id = 0;
+
+	/* Blocks are only found by walking the cfg, so nodes in unreachable
+	   blocks could end up sharing ids with renumbered ones */
+	ir_bb_iter_init(&bit, func);
+	if (func->n_po_bbs != func->n_ir_bbs)
+	{
+		return;
+	}
+
+	while ((bb = ir_bb_iter_next(&bit)))
+	{
+		ir_node_iter nit;
+		ir_node *n;
+
+		ir_node_iter_init(&nit, bb);
+		while ((n = ir_node_iter_next(&nit)))
+		{
+			n->id = ++id;
+		}
+		ir_node_at(func->node_store, bb->term_node)->id = ++id;
 	}
+
+	func->node_id_cntr = id;
 }
 
 void
 ir_bb_set_term_node(ir_bb *bb, ir_node *n)
 {
-	graph_ctx *gctx = &bb->func->ssa_graph_ctx;
-	node_edge *edge;
+	ir_node *term = ir_node_at(bb->func->node_store, bb->term_node);
+	unsigned i;
 
-	assert(bb->term_node != NULL);
-	assert(bb->term_node->op == IR_OP_term);
+	assert(term != NULL);
+	assert(term->op == IR_OP_term);
 
-	graph_preds_delete(gctx, (graph_node *)bb->term_node);
+	for (i = 0; i < term->n_args; i++)
+	{
+		use_remove(ir_node_arg(term, i), term, i);
+	}
+	term->n_args = 0;
 
 	if (n != NULL)
 	{
-		if (graph_succ_first((graph_node *)n) == NULL)
+		add_arg(term, 0, n);
+	}
+}
+
+ir_node_store *
+ir_node_store_create(ir_func *func)
+{
+	ir_node_store *store = calloc(1, sizeof(*store));
+
+	store->func = func;
+	store->blocks_room = 4;
+	store->blocks = malloc(store->blocks_room * sizeof(*store->blocks));
+	store->n_slots = 1;
+	store->bbs_room = 16;
+	store->bbs = calloc(store->bbs_room, sizeof(*store->bbs));
+	word_pool_init(&store->pool);
+
+	return store;
+}
+
+void
+ir_node_store_destroy(ir_node_store *store)
+{
+	unsigned i;
+
+	for (i = 0; i < store->n_blocks; i++)
+	{
+		free(store->blocks[i]);
+	}
+	free(store->blocks);
+	free(store->bbs);
+	word_pool_destroy(&store->pool);
+	free(store);
+}
+
+void
+ir_node_store_add_bb(ir_node_store *store, ir_bb *bb)
+{
+	unsigned old_room = store->bbs_room;
+
+	if (bb->id >= store->bbs_room)
+	{
+		while (bb->id >= store->bbs_room)
 		{
-			mark_used(n);
+			store->bbs_room *= 2;
 		}
-
-		edge = (node_edge *)graph_edge_create(gctx, (graph_node *)n, (graph_node *)bb->term_node, sizeof(node_edge), edge_cmp);
-		edge->u.arg.idx = 0;
+		store->bbs = realloc(store->bbs, store->bbs_room * sizeof(*store->bbs));
+		memset(store->bbs + old_room, 0, (store->bbs_room - old_room) * sizeof(*store->bbs));
 	}
+
+	store->bbs[bb->id] = bb;
+}
+
+/* Node blocks and the block table count as handed out in full, the word
+   pool up to what is in use */
+void
+ir_node_store_get_usage(ir_node_store *store, arena_usage *usage)
+{
+	usage->n_allocs += store->n_blocks + 3;
+	usage->n_bytes += (unsigned long)store->n_blocks * IR_NODE_BLOCK_SIZE +
+	                  (unsigned long)store->pool.n_words * sizeof(*store->pool.words) +
+	                  (unsigned long)store->bbs_room * sizeof(*store->bbs);
+	usage->n_reserved += (unsigned long)store->n_blocks * IR_NODE_BLOCK_SIZE +
+	                     (unsigned long)store->pool.words_room * sizeof(*store->pool.words) +
+	                     (unsigned long)store->bbs_room * sizeof(*store->bbs);
 }
 
 unsigned
@@ -927,7 +1132,7 @@ ir_node_type(ir_node *n)
 ir_bb *
 ir_node_bb(ir_node *n)
 {
-	return n->bb;
+	return ir_node_store_bb(ir_node_store_of(n), n->bb);
 }
 
 ir_op
@@ -940,34 +1145,34 @@ ir_data *
 ir_node_addr_of_data(ir_node *n)
 {
 	assert(n->op == IR_OP_addr_of);
-	return n->u.addr_of.sym;
+	return ir_node_cold_of(n)->u.addr_of.sym;
 }
 
 ir_func *
 ir_node_call_target(ir_node *n)
 {
 	assert(n->op == IR_OP_call);
-	return n->u.call.target;
+	return ir_node_cold_of(n)->u.call.target;
 }
 
 unsigned
 ir_node_alloca_size(ir_node *n)
 {
 	assert(n->op == IR_OP_alloca);
-	return n->u.alloca.size;
+	return ir_node_cold_of(n)->u.alloca.size;
 }
 
 unsigned
 ir_node_alloca_align(ir_node *n)
 {
 	assert(n->op == IR_OP_alloca);
-	return n->u.alloca.align;
+	return ir_node_cold_of(n)->u.alloca.align;
 }
 
 unsigned
 ir_node_getparam_idx(ir_node *n)
 {
-	return n->u.getparam.idx;
+	return ir_node_cold_of(n)->u.getparam.idx;
 }
 
 uint64_t
@@ -980,20 +1185,20 @@ ir_node_const_as_u64(ir_node *n)
 	switch (n->type) {
 	default:
 		assert(n->type == i1);
-		value = n->u.constant.u.i1;
+		value = ir_node_cold_of(n)->u.constant.u.i1;
 		break;
 	case i8:
-		value = n->u.constant.u.i8;
+		value = ir_node_cold_of(n)->u.constant.u.i8;
 		break;
 	case i16:
-		value = n->u.constant.u.i16;
+		value = ir_node_cold_of(n)->u.constant.u.i16;
 		break;
 	case i32:
 	case p32:
-		value = n->u.constant.u.i32;
+		value = ir_node_cold_of(n)->u.constant.u.i32;
 	case i64:
 	case p64:
-		value = n->u.constant.u.i64;
+		value = ir_node_cold_of(n)->u.constant.u.i64;
 		break;
 	}
 
@@ -1010,34 +1215,23 @@ ir_node_const_as_i64(ir_node *n)
 	switch (n->type) {
 	default:
 		assert(n->type == i1);
-		value = n->u.constant.u.i1;
+		value = ir_node_cold_of(n)->u.constant.u.i1;
 		break;
 	case i8:
-		value = n->u.constant.u.i8;
+		value = ir_node_cold_of(n)->u.constant.u.i8;
 		break;
 	case i16:
-		value = n->u.constant.u.i16;
+		value = ir_node_cold_of(n)->u.constant.u.i16;
 		break;
 	case i32:
 	case p32:
-		value = n->u.constant.u.i32;
+		value = ir_node_cold_of(n)->u.constant.u.i32;
 	case i64:
 	case p64:
-		value = n->u.constant.u.i64;
+		value = ir_node_cold_of(n)->u.constant.u.i64;
 		break;
 	}
 
 	return value;
 }
 
-void *
-ir_node_scratch(ir_node *n)
-{
-	return n->scratch;
-}
-
-void
-ir_node_scratch_set(ir_node *n, void *p)
-{
-	n->scratch = p;
-}
@@ -35,20 +35,25 @@ typedef enum ir_op {
 } ir_op;
 
 typedef struct ir_node_arg_iter {
-	graph_edge *next_edge;
+	ir_node *n;
+	unsigned next;
 } ir_node_arg_iter;
 
 typedef struct ir_node_phi_arg_iter {
-	graph_edge *next_edge;
+	ir_node *n;
+	unsigned next;
 } ir_node_phi_arg_iter;
 
 typedef struct ir_node_use_iter {
-	graph_edge *next_edge;
+	ir_node *n;
+	unsigned next;
 } ir_node_use_iter;
 
 typedef struct ir_node_iter {
-	ir_node **po_nodes;
-	unsigned idx;
+	ir_bb *bb;
+	ir_node *next;
+	int in_phis;
+	int rev;
 } ir_node_iter;
 
 
@@ -180,9 +185,3 @@ ir_node_const_as_i64(ir_node *n);
 
 uint64_t
 ir_node_const_as_u64(ir_node *n);
-
-void *
-ir_node_scratch(ir_node *n);
-
-void
-ir_node_scratch_set(ir_node *n, void *p);
@@ -24,27 +24,61 @@
 #pragma once
 
 #include "ir/ir_node.h"
+#include "util/word_pool.h"
+
+#include <stddef.h>
+#include <stdint.h>
 
 /* TODO:FIXME: Add POISON define or something to make sure that this file is
  * never included outside the ir/ directory (i.e. it is not to be seen by the
  * front end, ir passes nor codegen) */
 
-struct ir_node {
-	graph_node graph;
+struct arena_usage;
 
-	struct ir_node *bb_list_prev;
-	struct ir_node *bb_list_next;
-	struct ir_node *unused_list_prev;
-	struct ir_node *unused_list_next;
-	unsigned bb_list_depth;
+/*
+ * Nodes refer to other nodes by slot, the index of a node in the node store
+ * of its function, and to their block by block id. Slot 0 is never handed
+ * out and stands for no node. Slots are fixed for the life of a node. Node
+ * ids are separate from slots. They label nodes for printing and for id
+ * indexed side tables, and ir_func_renumber_nodes() hands them out again.
+ */
+
+/* Number of operands kept inside the node itself. Call nodes with more
+   arguments and all phi nodes keep them in the store word pool. */
+#define IR_NODE_INLINE_ARGS 3
 
-	enum {IR_NODE_USED, IR_NODE_UNUSED} status;
+typedef struct ir_node_use {
+	unsigned node; /* slot of the user */
+	unsigned idx; /* operand slot in node */
+} ir_node_use;
 
+/* The part of a node that node, operand and use iteration touch. It is 44
+   bytes and holds no pointers, so a node spans at most two cache lines.
+   Most nodes have a single use, which is kept inline until a second one is
+   added. */
+struct ir_node {
 	unsigned id;
-	struct ir_bb *bb;
-	ir_op op;
-	ir_type type;
+	unsigned bb; /* block id */
+	unsigned bb_list_prev; /* slot */
+	unsigned bb_list_next; /* slot */
+	unsigned char op; /* ir_op */
+	unsigned char type; /* ir_type */
+	unsigned short n_args;
+	unsigned n_uses;
+	union {
+		unsigned slots[IR_NODE_INLINE_ARGS];
+		unsigned words; /* phis and calls with more arguments */
+	} args;
+	union {
+		ir_node_use inline_use;
+		unsigned words; /* once uses_room is above one */
+	} uses;
+};
 
+/* The part of a node that is only needed when building, moving and
+   removing nodes and by the per op accessors. It is kept in a side array
+   parallel to the nodes. */
+typedef struct ir_node_cold {
 	union {
 		struct {
 			unsigned size;
@@ -68,8 +102,135 @@ struct ir_node {
 		struct {
 			ir_func *target;
 		} call;
+		struct {
+			unsigned bbs; /* words of block ids, parallel to args */
+		} phi;
 	} u;
+	unsigned unused_list_next; /* slot */
+	unsigned bb_list_depth;
+	unsigned uses_room; /* one while the use is inline */
+	unsigned char status; /* IR_NODE_USED or IR_NODE_UNUSED */
+	unsigned char in_unused_list;
+} ir_node_cold;
 
-	void *scratch;
-};
+/* Nodes are allocated in blocks that are aligned to their size. The block
+   of a node, and through it the store, the slot and the cold part of the
+   node, is found by masking the node address. */
+#define IR_NODE_BLOCK_SIZE 8192
+#define IR_NODE_BLOCK_NODES \
+	((IR_NODE_BLOCK_SIZE - 16) / (sizeof(struct ir_node) + sizeof(ir_node_cold)))
+
+typedef struct ir_node_block {
+	struct ir_node_store *store;
+	unsigned first_slot;
+	struct ir_node nodes[IR_NODE_BLOCK_NODES];
+	ir_node_cold cold[IR_NODE_BLOCK_NODES];
+} ir_node_block;
+
+typedef struct ir_node_store {
+	ir_func *func;
+	ir_node_block **blocks;
+	unsigned n_blocks;
+	unsigned blocks_room;
+	unsigned n_slots; /* handed out, slot 0 included */
+	unsigned first_unused; /* slots, see mark_unused() */
+	unsigned last_unused;
+	ir_bb **bbs; /* by block id */
+	unsigned bbs_room;
+	word_pool pool; /* out of line operand, phi block and use arrays */
+} ir_node_store;
+
+enum {IR_NODE_USED, IR_NODE_UNUSED};
+
+ir_node_store *
+ir_node_store_create(ir_func *func);
+
+void
+ir_node_store_destroy(ir_node_store *store);
+
+/* Make bb reachable through its id from the nodes of the function */
+void
+ir_node_store_add_bb(ir_node_store *store, ir_bb *bb);
+
+/* Add the blocks and words held by the store to usage */
+void
+ir_node_store_get_usage(ir_node_store *store, struct arena_usage *usage);
+
+static inline ir_node_block *
+ir_node_block_of(ir_node *n)
+{
+	return (ir_node_block *)((uintptr_t)n & ~(uintptr_t)(IR_NODE_BLOCK_SIZE - 1));
+}
+
+static inline ir_node_store *
+ir_node_store_of(ir_node *n)
+{
+	return ir_node_block_of(n)->store;
+}
+
+static inline unsigned
+ir_node_slot(ir_node *n)
+{
+	ir_node_block *b = ir_node_block_of(n);
+	return b->first_slot + (n - b->nodes);
+}
+
+static inline ir_node_cold *
+ir_node_cold_of(ir_node *n)
+{
+	ir_node_block *b = ir_node_block_of(n);
+	return &b->cold[n - b->nodes];
+}
+
+/* NULL for slot 0 */
+static inline ir_node *
+ir_node_at(ir_node_store *store, unsigned slot)
+{
+	if (slot == 0)
+	{
+		return NULL;
+	}
+	return &store->blocks[slot / IR_NODE_BLOCK_NODES]->nodes[slot % IR_NODE_BLOCK_NODES];
+}
+
+static inline ir_bb *
+ir_node_store_bb(ir_node_store *store, unsigned id)
+{
+	return store->bbs[id];
+}
+
+/* Operand slots of n. The array is only valid until the next out of line
+   array of the function is allocated. */
+static inline unsigned *
+ir_node_args(ir_node *n)
+{
+	if (n->op == IR_OP_phi || n->n_args > IR_NODE_INLINE_ARGS)
+	{
+		return ir_node_store_of(n)->pool.words + n->args.words;
+	}
+	return n->args.slots;
+}
+
+static inline ir_node *
+ir_node_arg(ir_node *n, unsigned idx)
+{
+	return ir_node_at(ir_node_store_of(n), ir_node_args(n)[idx]);
+}
+
+/* Uses of n, valid as long as the operand slots are */
+static inline ir_node_use *
+ir_node_uses(ir_node *n)
+{
+	if (ir_node_cold_of(n)->uses_room > 1)
+	{
+		return (ir_node_use *)(ir_node_store_of(n)->pool.words + n->uses.words);
+	}
+	return &n->uses.inline_use;
+}
 
+static inline ir_bb *
+ir_node_phi_bb(ir_node *phi, unsigned idx)
+{
+	ir_node_store *store = ir_node_store_of(phi);
+	return store->bbs[store->pool.words[ir_node_cold_of(phi)->u.phi.bbs + idx]];
+}
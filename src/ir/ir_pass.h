@@ -26,9 +26,14 @@
 
 #include "ir.h"
 
+/* A pass works either on one function at a time (func) or on the whole
+   translation unit (tu). Both return non-zero if the IR was changed, when
+   nothing changed all analyses are kept regardless of preserves. */
 typedef struct ir_pass {
 	const char *name;
-	void (*func)(ir_func *f);
+	int (*func)(ir_func *f);
+	unsigned preserves; /* analyses still valid after the pass, see ir_analysis.h */
+	int (*tu)(ir_tu *tu);
 } ir_pass;
 
 #endif
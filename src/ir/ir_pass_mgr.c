@@ -0,0 +1,369 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ir/ir_pass_mgr.h"
+#include "ir/ir_analysis.h"
+#include "ir/ir_func.h"
+#include "ir/ir_tu.h"
+#include "util/stats.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_PASSES 32
+#define MAX_FIXPOINT_ITERATIONS 16
+
+typedef struct ir_pipeline_elem {
+	struct ir_pipeline_elem *next;
+	ir_pass *pass;
+	ir_pipeline *group; /* fixpoint group if pass is NULL */
+} ir_pipeline_elem;
+
+struct ir_pipeline {
+	ir_pipeline_elem *first;
+	ir_pipeline_elem *last;
+	char *spec; /* of a fixpoint group, for diagnostics */
+};
+
+static ir_pass *registry[MAX_PASSES];
+static unsigned n_registered;
+
+void
+ir_pass_register(ir_pass *pass)
+{
+	assert(n_registered < MAX_PASSES);
+	assert(ir_pass_lookup(pass->name) == NULL && "Pass already registered");
+	assert((pass->func != NULL) != (pass->tu != NULL));
+	registry[n_registered++] = pass;
+}
+
+ir_pass *
+ir_pass_lookup(const char *name)
+{
+	unsigned i;
+	for (i = 0; i < n_registered; i++)
+	{
+		if (!strcmp(registry[i]->name, name))
+		{
+			return registry[i];
+		}
+	}
+	return NULL;
+}
+
+static void
+append_elem(ir_pipeline *pl, ir_pass *pass, ir_pipeline *group)
+{
+	ir_pipeline_elem *elem = calloc(1, sizeof(ir_pipeline_elem));
+	elem->pass = pass;
+	elem->group = group;
+	if (pl->last != NULL)
+	{
+		pl->last->next = elem;
+	}
+	else
+	{
+		pl->first = elem;
+	}
+	pl->last = elem;
+}
+
+/* Recursive descent over
+     pipeline := [elem {',' elem}]
+     elem     := name | 'fixpoint(' pipeline ')' */
+static ir_pipeline *
+parse_pipeline(const char **p)
+{
+	ir_pipeline *pl = calloc(1, sizeof(ir_pipeline));
+
+	while (**p != '\0' && **p != ')')
+	{
+		const char *start = *p;
+		char name[64];
+		size_t len;
+
+		while (**p != '\0' && **p != ',' && **p != '(' && **p != ')')
+		{
+			(*p)++;
+		}
+
+		len = *p - start;
+		if (len == 0 || len >= sizeof(name))
+		{
+			fprintf(stderr, "malformed pass pipeline near '%s'\n", start);
+			ir_pipeline_destroy(pl);
+			return NULL;
+		}
+		memcpy(name, start, len);
+		name[len] = '\0';
+
+		if (**p == '(')
+		{
+			ir_pipeline *group;
+
+			if (strcmp(name, "fixpoint"))
+			{
+				fprintf(stderr, "unknown pass group '%s'\n", name);
+				ir_pipeline_destroy(pl);
+				return NULL;
+			}
+
+			start = ++(*p);
+			if ((group = parse_pipeline(p)) == NULL)
+			{
+				ir_pipeline_destroy(pl);
+				return NULL;
+			}
+			if (**p != ')')
+			{
+				fprintf(stderr, "missing ')' in pass pipeline\n");
+				ir_pipeline_destroy(group);
+				ir_pipeline_destroy(pl);
+				return NULL;
+			}
+			group->spec = strndup(start, *p - start);
+			(*p)++;
+			append_elem(pl, NULL, group);
+		}
+		else
+		{
+			ir_pass *pass = ir_pass_lookup(name);
+			if (pass == NULL)
+			{
+				fprintf(stderr, "unknown pass '%s'\n", name);
+				ir_pipeline_destroy(pl);
+				return NULL;
+			}
+			append_elem(pl, pass, NULL);
+		}
+
+		if (**p == ',')
+		{
+			(*p)++;
+		}
+	}
+
+	return pl;
+}
+
+ir_pipeline *
+ir_pipeline_parse(const char *spec)
+{
+	const char *p = spec;
+	ir_pipeline *pl = parse_pipeline(&p);
+
+	if (pl != NULL && *p != '\0')
+	{
+		fprintf(stderr, "unbalanced ')' in pass pipeline\n");
+		ir_pipeline_destroy(pl);
+		return NULL;
+	}
+
+	return pl;
+}
+
+void
+ir_pipeline_destroy(ir_pipeline *pl)
+{
+	ir_pipeline_elem *elem, *next;
+
+	for (elem = pl->first; elem != NULL; elem = next)
+	{
+		next = elem->next;
+		if (elem->group != NULL)
+		{
+			ir_pipeline_destroy(elem->group);
+		}
+		free(elem);
+	}
+	free(pl->spec);
+	free(pl);
+}
+
+/* Functions left untouched keep all their analyses */
+static void
+finish_func(ir_func *f, ir_pass *pass, int changed)
+{
+	ir_analysis_preserve(f, changed ? pass->preserves : IR_ANALYSES_ALL);
+	ir_func_free_unused_nodes(f);
+}
+
+static int
+run_func_pass(ir_pass *pass, ir_func *f)
+{
+	int changed;
+
+	ir_analysis_drop_stale(f);
+	stats_phase_begin(pass->name, f->name);
+	changed = pass->func(f);
+	finish_func(f, pass, changed);
+	stats_phase_end();
+
+	return changed;
+}
+
+static int
+run_pass(ir_pass *pass, ir_tu *tu, ir_pass_hook hook, void *user)
+{
+	int changed = 0;
+	ir_func *f;
+
+	if (pass->tu != NULL)
+	{
+		for (f = tu->first_ir_func; f != NULL; f = f->tu_list_next)
+		{
+			if (ir_func_is_definition(f))
+			{
+				ir_analysis_drop_stale(f);
+			}
+		}
+		stats_phase_begin(pass->name, NULL);
+		changed = pass->tu(tu);
+		stats_phase_end();
+		for (f = tu->first_ir_func; f != NULL; f = f->tu_list_next)
+		{
+			if (ir_func_is_definition(f))
+			{
+				finish_func(f, pass, changed);
+			}
+		}
+	}
+	else
+	{
+		for (f = tu->first_ir_func; f != NULL; f = f->tu_list_next)
+		{
+			if (ir_func_is_definition(f))
+			{
+				changed |= run_func_pass(pass, f);
+			}
+		}
+	}
+
+	if (hook != NULL)
+	{
+		hook(pass, tu, user);
+	}
+
+	return changed;
+}
+
+/* A group still changing the IR after MAX_FIXPOINT_ITERATIONS runs is
+   stopped there. The result is not a fixpoint, so say so. */
+static void
+warn_not_converged(ir_pipeline *group, const char *func_name)
+{
+	if (func_name != NULL)
+	{
+		fprintf(stderr, "warning: fixpoint(%s) still changed '%s' after %d iterations\n",
+		        group->spec, func_name, MAX_FIXPOINT_ITERATIONS);
+	}
+	else
+	{
+		fprintf(stderr, "warning: fixpoint(%s) still changed the translation unit after %d iterations\n",
+		        group->spec, MAX_FIXPOINT_ITERATIONS);
+	}
+}
+
+int
+ir_pipeline_run(ir_pipeline *pl, ir_tu *tu, ir_pass_hook hook, void *user)
+{
+	ir_pipeline_elem *elem;
+	int changed = 0;
+
+	for (elem = pl->first; elem != NULL; elem = elem->next)
+	{
+		if (elem->pass != NULL)
+		{
+			changed |= run_pass(elem->pass, tu, hook, user);
+		}
+		else
+		{
+			unsigned i;
+			for (i = 0; i < MAX_FIXPOINT_ITERATIONS; i++)
+			{
+				if (!ir_pipeline_run(elem->group, tu, hook, user))
+				{
+					break;
+				}
+				changed = 1;
+			}
+			if (i == MAX_FIXPOINT_ITERATIONS)
+			{
+				warn_not_converged(elem->group, NULL);
+			}
+		}
+	}
+
+	return changed;
+}
+
+int
+ir_pipeline_is_func_local(ir_pipeline *pl)
+{
+	ir_pipeline_elem *elem;
+
+	for (elem = pl->first; elem != NULL; elem = elem->next)
+	{
+		if (elem->pass != NULL ? elem->pass->tu != NULL : !ir_pipeline_is_func_local(elem->group))
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+int
+ir_pipeline_run_func(ir_pipeline *pl, ir_func *f)
+{
+	ir_pipeline_elem *elem;
+	int changed = 0;
+
+	for (elem = pl->first; elem != NULL; elem = elem->next)
+	{
+		if (elem->pass != NULL)
+		{
+			assert(elem->pass->func != NULL);
+			changed |= run_func_pass(elem->pass, f);
+		}
+		else
+		{
+			unsigned i;
+			for (i = 0; i < MAX_FIXPOINT_ITERATIONS; i++)
+			{
+				if (!ir_pipeline_run_func(elem->group, f))
+				{
+					break;
+				}
+				changed = 1;
+			}
+			if (i == MAX_FIXPOINT_ITERATIONS)
+			{
+				warn_not_converged(elem->group, f->name);
+			}
+		}
+	}
+
+	return changed;
+}
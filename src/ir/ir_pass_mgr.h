@@ -0,0 +1,66 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef IR_PASS_MGR_H
+#define IR_PASS_MGR_H
+
+#include "ir/ir_pass.h"
+
+/*
+ * Passes are registered by name and arranged into pipelines described by
+ * strings such as "sra,mem2reg,fixpoint(a,b)". A fixpoint group is
+ * repeated until none of its passes reports a change.
+ */
+
+typedef struct ir_pipeline ir_pipeline;
+
+/* Called after each pass that was run, e.g. to dump or simulate the IR */
+typedef void (*ir_pass_hook)(ir_pass *pass, ir_tu *tu, void *user);
+
+void
+ir_pass_register(ir_pass *pass);
+
+ir_pass *
+ir_pass_lookup(const char *name);
+
+/* Returns NULL and reports to stderr if spec is malformed or names an
+   unknown pass */
+ir_pipeline *
+ir_pipeline_parse(const char *spec);
+
+void
+ir_pipeline_destroy(ir_pipeline *pl);
+
+/* Returns non-zero if any pass changed the IR */
+int
+ir_pipeline_run(ir_pipeline *pl, ir_tu *tu, ir_pass_hook hook, void *user);
+
+/* Non-zero if the pipeline has function passes only and thus can be run
+   on each function independently with ir_pipeline_run_func() */
+int
+ir_pipeline_is_func_local(ir_pipeline *pl);
+
+int
+ir_pipeline_run_func(ir_pipeline *pl, ir_func *f);
+
+#endif
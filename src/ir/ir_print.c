@@ -146,39 +146,41 @@ ir_print_bb(FILE *fp, ir_bb *bb)
 void
 ir_print_node(FILE *fp, ir_node *n)
 {
+	ir_node_cold *cold = ir_node_cold_of(n);
+
 	fprintf(fp, "%%%d = %s %s ", n->id, op2str[n->op], type2str[n->type]);
 
 	if (n->op == IR_OP_addr_of)
 	{
-		fprintf(fp, "@%s", n->u.addr_of.sym->name);
+		fprintf(fp, "@%s", cold->u.addr_of.sym->name);
 	}
 	else if (n->op == IR_OP_alloca)
 	{
-		fprintf(fp, "%d, %d", n->u.alloca.size, n->u.alloca.align);
+		fprintf(fp, "%d, %d", cold->u.alloca.size, cold->u.alloca.align);
 	}
 	else if (n->op == IR_OP_getparam)
 	{
-		fprintf(fp, "%d", n->u.getparam.idx);
+		fprintf(fp, "%d", cold->u.getparam.idx);
 	}
 	else if (n->op == IR_OP_const)
 	{
 		switch (n->type) {
 		case i1:
-			fprintf(fp, "%s", n->u.constant.u.i1 ? "true" : "false");
+			fprintf(fp, "%s", cold->u.constant.u.i1 ? "true" : "false");
 			break;
 		case i8:
-			fprintf(fp, "0x%02hhx", n->u.constant.u.i8);
+			fprintf(fp, "0x%02hhx", cold->u.constant.u.i8);
 			break;
 		case i16:
-			fprintf(fp, "0x%04hx", n->u.constant.u.i16);
+			fprintf(fp, "0x%04hx", cold->u.constant.u.i16);
 			break;
 		case i32:
 		case p32:
-			fprintf(fp, "0x%08x", n->u.constant.u.i32);
+			fprintf(fp, "0x%08x", cold->u.constant.u.i32);
 			break;
 		case i64:
 		case p64:
-			fprintf(fp, "0x%016llx", n->u.constant.u.i64);
+			fprintf(fp, "0x%016llx", cold->u.constant.u.i64);
 			break;
 		default:
 			assert(0);
@@ -210,7 +212,7 @@ ir_print_node(FILE *fp, ir_node *n)
 
 		if (n->op == IR_OP_call)
 		{
-			fprintf(fp, "@%s ", n->u.call.target->name);
+			fprintf(fp, "@%s ", cold->u.call.target->name);
 		}
 
 		ir_node_get_args(n, &n_args, args, sizeof(args)/sizeof(args[0]));
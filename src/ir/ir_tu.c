@@ -0,0 +1,59 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ir/ir_tu.h"
+#include "ir/ir_func.h"
+#include "ir/ir_data.h"
+#include "ir/ir_analysis.h"
+#include "util/arena.h"
+
+#include <stdlib.h>
+
+void
+ir_tu_destroy(ir_tu *tu)
+{
+	ir_func *f, *f_next;
+	ir_data *d, *d_next;
+
+	/* Bodies that made it through codegen have already been dropped by
+	   ir_func_destroy, what is left is the declaration part. */
+	for (f = tu->first_ir_func; f != NULL; f = f_next)
+	{
+		f_next = f->tu_list_next;
+		ir_analysis_invalidate(f, IR_ANALYSES_ALL);
+		arena_destroy(f->arena);
+		free((char *)f->name);
+		free(f->param_types);
+		free(f);
+	}
+
+	for (d = tu->first_ir_data; d != NULL; d = d_next)
+	{
+		d_next = d->tu_next;
+		free((char *)d->name);
+		free(d->init);
+		free(d);
+	}
+
+	free(tu);
+}
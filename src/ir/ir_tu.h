@@ -32,4 +32,7 @@ struct ir_tu {
 	ir_data *first_ir_data;
 };
 
+void
+ir_tu_destroy(ir_tu *tu);
+
 #endif
@@ -70,6 +70,8 @@ report_error(ir_node *n)
 void
 ir_validate_node(ir_node *n)
 {
+	ir_node_cold *cold = ir_node_cold_of(n);
+	ir_func *func = ir_node_store_of(n)->func;
 	ir_node_phi_arg_iter it;
 	ir_node *arg, *args[16];
 	unsigned i, n_args;
@@ -99,14 +101,14 @@ ir_validate_node(ir_node *n)
 	case IR_OP_call:
 
 		ir_node_get_args(n, &n_args, args, sizeof(args)/sizeof(args[0]));
-		if (n_args < n->u.call.target->n_params ||
-		    (!n->u.call.target->is_variadic && n_args > n->u.call.target->n_params))
+		if (n_args < cold->u.call.target->n_params ||
+		    (!cold->u.call.target->is_variadic && n_args > cold->u.call.target->n_params))
 		{
 			report_error(n);
 		}
-		for (i = 0; i < n->u.call.target->n_params; i++)
+		for (i = 0; i < cold->u.call.target->n_params; i++)
 		{
-			if (args[i]->type != n->u.call.target->param_types[i])
+			if (args[i]->type != cold->u.call.target->param_types[i])
 			{
 				report_error(n);
 			}
@@ -217,8 +219,8 @@ ir_validate_node(ir_node *n)
 
 	case IR_OP_getparam:
 
-		if (n->u.getparam.idx >= n->bb->func->n_params ||
-		    n->type != n->bb->func->param_types[n->u.getparam.idx])
+		if (cold->u.getparam.idx >= func->n_params ||
+		    n->type != func->param_types[cold->u.getparam.idx])
 		{
 			report_error(n);
 		}
@@ -21,73 +21,112 @@
  * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include "ir/ir_analysis.h"
 #include "ir/ir_dom.h"
 #include "ir/ir_bb.h"
 #include "ir/ir_node.h"
 #include "ir/ir_func.h"
+#include "ir/ir_map.h"
 #include "ir_passes/mem2reg.h"
-#include "util/bset.h"
+#include "util/arena.h"
 #include "util/graph.h"
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 
-struct node_stack {
-	struct node_stack *next;
-	ir_node *n;
-};
 
+typedef struct bb_lst {
+	struct bb_lst *next;
+	ir_bb *bb;
+} bb_lst;
 
 typedef struct variable {
+	struct variable *next;
 	ir_node *alloca;
+	ir_type type;
 	int is_rejected;
-	unsigned live_idx;
-	struct node_stack *stack;
+	unsigned stamp; /* unique non-zero id used to stamp block_info */
+	ir_node *top_def; /* reaching definition during renaming */
+	bb_lst *def_bbs; /* blocks storing to the variable */
+	bb_lst *use_bbs; /* blocks loading it before any store */
+	ir_bb *last_bb; /* state while summarizing blocks */
+	int last_bb_stores;
 } variable;
 
-static graph_marker scratch_marker;
+/* Per block state for phi placement, kept in a block map.
+   Stamps hold the id of the variable they are valid for so nothing needs
+   to be reset between variables. */
+typedef struct block_info {
+	ir_bb *bb;
+	unsigned level; /* depth in the dominator tree */
+	unsigned def_stamp;
+	unsigned livein_stamp;
+	unsigned bank_stamp;
+	unsigned phi_stamp;
+	unsigned visit_stamp;
+	struct block_info *bank_next;
+} block_info;
+
+/* Thread local as functions may be compiled concurrently */
+static __thread ir_node_map var_map;
+static __thread ir_bb_map block_map;
+static __thread arena *scratch_arena;
 static variable * scratch_get_var(ir_node *n)
 {
-	if (graph_marker_is_set((graph_node *)n, &scratch_marker))
-	{
-		return (variable *)ir_node_scratch(n);
-	}
-	else
-	{
-		return NULL;
-	}
+	variable **var = ir_node_map_lookup(&var_map, n);
+	return var != NULL ? *var : NULL;
 }
 
 static void scratch_set_var(ir_node *n, variable *v)
 {
-	graph_marker_set((graph_node *)n, &scratch_marker);
-	ir_node_scratch_set(n, v);
+	*(variable **)ir_node_map_get(&var_map, n) = v;
 }
 
-static void push_def(variable *var, ir_node *n)
-{
-	struct node_stack *slot = calloc(1, sizeof(struct node_stack));
-	slot->n = n;
-	slot->next = var->stack;
-	var->stack = slot;
-}
+/* Definitions pushed while renaming are logged together with the value
+   they shadow so leaving a block restores the previous ones by simply
+   unwinding the log. */
+typedef struct def_log_entry {
+	variable *var;
+	ir_node *prev;
+} def_log_entry;
 
-static void pop_def(variable *var)
-{
-	assert(var->stack != NULL);
-	var->stack = var->stack->next;
-}
+typedef struct rename_frame {
+	ir_bb *bb;
+	ir_dom_info_lst *next_child;
+	unsigned log_height;
+} rename_frame;
+
+typedef struct rename_ctx {
+	def_log_entry *log;
+	unsigned n_log;
+	unsigned log_room_for;
+} rename_ctx;
 
-static ir_node * top_def(variable *var)
+static void push_def(rename_ctx *ctx, variable *var, ir_node *n)
 {
-	if (var->stack != NULL)
+	if (ctx->n_log == ctx->log_room_for)
 	{
-		return var->stack->n;
+		def_log_entry *log;
+		ctx->log_room_for = ctx->log_room_for ? ctx->log_room_for*2 : 64;
+		log = arena_alloc(scratch_arena, ctx->log_room_for*sizeof(def_log_entry));
+		memcpy(log, ctx->log, ctx->n_log*sizeof(def_log_entry));
+		ctx->log = log;
 	}
-	else
+
+	ctx->log[ctx->n_log].var = var;
+	ctx->log[ctx->n_log].prev = var->top_def;
+	ctx->n_log++;
+	var->top_def = n;
+}
+
+static void pop_defs(rename_ctx *ctx, unsigned height)
+{
+	while (ctx->n_log > height)
 	{
-		return NULL;
+		def_log_entry *entry = &ctx->log[--ctx->n_log];
+		entry->var->top_def = entry->prev;
 	}
 }
 
@@ -123,33 +162,15 @@ static void link_def_use_to_var(variable *var, ir_node *n)
 	}
 }
 
-static void insert_phi_in_iter_df(ir_bb *bb, variable *var, ir_type type, graph_marker *marker)
-{
-	ir_dom_info_lst *lst;
-	ir_node *phi;
-
-	graph_marker_set((graph_node *)bb, marker);
-
-	for (lst = ir_bb_dom_info(bb)->df; lst != NULL; lst = lst->next)
-	{
-		ir_bb *df = lst->info->bb;
-		if (!graph_marker_is_set((graph_node *)df, marker) &&
-		    bset_has(ir_bb_scratch(df), var->live_idx))
-		{
-			/* Variable is in livein[df] so a phi-node is needed in df */
-			phi = ir_node_build_phi(df, type);
-			scratch_set_var(phi, var);
-			insert_phi_in_iter_df(df, var, type, marker);
-		}
-	}
-}
-
-static void walk_domtree_rename(ir_bb *bb)
+/* Rename the variable accesses of a single block. Phi-nodes and stores
+   push new definitions, loads are replaced by the reaching definition and
+   both loads and stores are removed as we go. Finally the phi-nodes of the
+   successors get their argument for this block. */
+static void rename_bb(rename_ctx *ctx, ir_bb *bb)
 {
 	ir_node_iter nit;
 	ir_node *n, *nn;
 	graph_edge *edge;
-	ir_dom_info_lst *lst;
 
 	ir_node_iter_init(&nit, bb);
 	while ((n = ir_node_iter_next(&nit)))
@@ -164,21 +185,23 @@ static void walk_domtree_rename(ir_bb *bb)
 		switch (ir_node_op(n))
 		{
 		case IR_OP_phi:
-			push_def(var, n);
+			push_def(ctx, var, n);
 			break;
 
 		case IR_OP_store:
 			ir_node_get_args(n, NULL, args, 2);
-			push_def(var, args[1]);
+			push_def(ctx, var, args[1]);
+			ir_node_remove(n);
 			break;
 
 		case IR_OP_load:
-			if ((nn = top_def(var)) == NULL)
+			if ((nn = var->top_def) == NULL)
 			{
 				nn = ir_node_build0(bb, IR_OP_undef, ir_node_type(n));
 			}
 
 			ir_node_replace(n, nn);
+			ir_node_remove(n);
 			break;
 
 		default:
@@ -202,131 +225,258 @@ static void walk_domtree_rename(ir_bb *bb)
 
 			assert(var->is_rejected == 0);
 
-			if ((nn = top_def(var)) == NULL)
+			if ((nn = var->top_def) == NULL)
 			{
 				nn = ir_node_build0(bb, IR_OP_undef, ir_node_type(n));
 			}
 			ir_node_add_phi_arg(n, bb, nn);
 		}
 	}
+}
 
-	for (lst = ir_bb_dom_info(bb)->domtree_children; lst != NULL; lst = lst->next)
-	{
-		walk_domtree_rename(lst->info->bb);
-	}
+/* Walk the dominator tree with an explicit stack, the definitions made in a
+   block are visible to the blocks it dominates only. */
+static void rename_vars(ir_func *func)
+{
+	rename_frame *stack = arena_alloc(scratch_arena, func->n_ir_bbs*sizeof(rename_frame));
+	rename_ctx ctx = {NULL, 0, 0};
+	unsigned si = 0;
 
-	ir_node_iter_init(&nit, bb);
-	while ((n = ir_node_iter_next(&nit)))
+	stack[si].bb = func->entry;
+	stack[si].next_child = ir_bb_dom_info(func->entry)->domtree_children;
+	stack[si].log_height = 0;
+	si++;
+	rename_bb(&ctx, func->entry);
+
+	while (si > 0)
 	{
-		variable *var = scratch_get_var(n);
-		if (var == NULL || var->is_rejected)
+		rename_frame *top = &stack[si-1];
+		ir_dom_info_lst *child = top->next_child;
+
+		if (child == NULL)
 		{
+			pop_defs(&ctx, top->log_height);
+			si--;
 			continue;
 		}
 
-		switch (ir_node_op(n))
-		{
-		case IR_OP_phi:
-			pop_def(var);
-			break;
-
-		case IR_OP_store:
-			pop_def(var);
-			ir_node_remove(n);
-			break;
+		top->next_child = child->next;
+		stack[si].bb = child->info->bb;
+		stack[si].next_child = child->info->domtree_children;
+		stack[si].log_height = ctx.n_log;
+		si++;
+		rename_bb(&ctx, child->info->bb);
+	}
+}
 
-		case IR_OP_load:
-			ir_node_remove(n);
-			break;
+static block_info *get_block_info(ir_bb *bb)
+{
+	return ir_bb_map_get(&block_map, bb);
+}
 
-		default:
-			break;
-		}
-	}
+static void bb_lst_push(bb_lst **lst, ir_bb *bb)
+{
+	bb_lst *elem = arena_alloc(scratch_arena, sizeof(bb_lst));
+	elem->bb = bb;
+	elem->next = *lst;
+	*lst = elem;
 }
 
-static void compute_livein(ir_func *func, unsigned n_vars)
+/* Single pass over the function recording, for each variable, the blocks
+   that store to it and the blocks where it is live-in because of a load
+   that is not preceded by a store. Also fills in the block_info of all
+   blocks. */
+static void summarize_blocks(ir_func *func)
 {
-	bset_set *tmp, *gen, *kill, *liveout;
-	int livein_changed = 1;
 	ir_bb_iter bit;
 	ir_bb *bb;
 
 	ir_bb_iter_init(&bit, func);
 	while ((bb = ir_bb_iter_next(&bit)))
 	{
-		ir_bb_scratch_set(bb, bset_create_set(n_vars)); /* TODO:FIXME: Can do this more efficiently with a node marker */
+		block_info *info = get_block_info(bb);
+		ir_dom_info *idom = ir_bb_dom_info(bb)->idom;
+		ir_node_iter nit;
+		ir_node *n;
+
+		/* Dominators precede the blocks they dominate in RPO */
+		info->bb = bb;
+		info->level = idom->bb != bb ? get_block_info(idom->bb)->level + 1 : 0;
+
+		ir_node_iter_init(&nit, bb);
+		while ((n = ir_node_iter_next(&nit)))
+		{
+			ir_op op = ir_node_op(n);
+			variable *var;
+
+			if ((op != IR_OP_load && op != IR_OP_store) || (var = scratch_get_var(n)) == NULL)
+			{
+				continue;
+			}
+
+			if (var->last_bb != bb)
+			{
+				var->last_bb = bb;
+				var->last_bb_stores = 0;
+				if (op == IR_OP_load)
+				{
+					bb_lst_push(&var->use_bbs, bb);
+				}
+			}
+
+			if (op == IR_OP_store && !var->last_bb_stores)
+			{
+				var->last_bb_stores = 1;
+				var->type = ir_node_type(n);
+				bb_lst_push(&var->def_bbs, bb);
+			}
+		}
+	}
+}
+
+/* Sparse liveness for a single variable: walk backwards from the blocks
+   where it is upward exposed and stop at blocks that store to it. */
+static void compute_var_livein(variable *var, block_info **worklist)
+{
+	unsigned wi = 0;
+	bb_lst *lst;
+
+	for (lst = var->def_bbs; lst != NULL; lst = lst->next)
+	{
+		get_block_info(lst->bb)->def_stamp = var->stamp;
 	}
 
-	tmp  = bset_create_set(n_vars);
-	gen  = bset_create_set(n_vars);
-	kill = bset_create_set(n_vars);
-	liveout = bset_create_set(n_vars);
+	for (lst = var->use_bbs; lst != NULL; lst = lst->next)
+	{
+		block_info *info = get_block_info(lst->bb);
+		info->livein_stamp = var->stamp;
+		worklist[wi++] = info;
+	}
 
-	while (livein_changed)
+	while (wi > 0)
 	{
-		livein_changed = 0;
-		ir_bb_iter_rev_init(&bit, func);
-		while ((bb = ir_bb_iter_next(&bit)))
+		block_info *info = worklist[--wi];
+		graph_edge *edge;
+
+		for (edge = graph_pred_first((graph_node *)info->bb); edge != NULL; edge = graph_pred_next(edge))
 		{
-			bset_set *livein = ir_bb_scratch(bb);
-			graph_edge *edge;
-			ir_node_iter nit;
-			ir_node *n;
-
-			bset_clear(tmp);
-			bset_clear(gen);
-			bset_clear(kill);
-			bset_clear(liveout);
-
-			/* liveout[bb] is union of livein[succ] for all succs of bb */
-			for (edge = graph_succ_first((graph_node *)bb);
-				 edge != NULL;
-				 edge = graph_succ_next(edge))
+			ir_bb *pbb = (ir_bb *)graph_edge_tail(edge);
+			block_info *pred;
+
+			if (ir_bb_dom_info(pbb) == NULL)
 			{
-				ir_bb *succ = (ir_bb *)graph_edge_head(edge);
-				bset_union(liveout, ir_bb_scratch(succ));
+				/* unreachable predecessor */
+				continue;
+			}
+
+			pred = get_block_info(pbb);
+			if (pred->livein_stamp != var->stamp && pred->def_stamp != var->stamp)
+			{
+				pred->livein_stamp = var->stamp;
+				worklist[wi++] = pred;
 			}
+		}
+	}
+}
+
+static void bank_insert(block_info **bank, block_info *info, unsigned stamp)
+{
+	info->bank_stamp = stamp;
+	info->bank_next = bank[info->level];
+	bank[info->level] = info;
+}
+
+/* Place phi-nodes in the iterated dominance frontier of the defining
+   blocks, found by walking the DJ-graph (Sreedhar and Gao). Blocks are
+   taken deepest first from a bank of per-level lists; the dominator
+   subtree of each is visited and join edges leading to a block no deeper
+   than the current root hit the frontier. Phi-nodes are only placed
+   where the variable is live-in, giving pruned SSA form. */
+static void place_phis(variable *var, block_info **bank, block_info **stack, unsigned max_level)
+{
+	unsigned stamp = var->stamp;
+	int level = max_level;
+	bb_lst *lst;
+
+	for (lst = var->def_bbs; lst != NULL; lst = lst->next)
+	{
+		bank_insert(bank, get_block_info(lst->bb), stamp);
+	}
+
+	while (level >= 0)
+	{
+		block_info *root = bank[level];
+		unsigned si = 0;
+
+		if (root == NULL)
+		{
+			level--;
+			continue;
+		}
+		bank[level] = root->bank_next;
+
+		root->visit_stamp = stamp;
+		stack[si++] = root;
+		while (si > 0)
+		{
+			block_info *y = stack[--si];
+			ir_dom_info_lst *child;
+			graph_edge *edge;
 
-			ir_node_iter_rev_init(&nit, bb);
-			while ((n = ir_node_iter_next(&nit)))
+			for (edge = graph_succ_first((graph_node *)y->bb); edge != NULL; edge = graph_succ_next(edge))
 			{
-				variable *var;
-				if (ir_node_op(n) == IR_OP_store && (var = scratch_get_var(n)))
+				ir_bb *zbb = (ir_bb *)graph_edge_head(edge);
+				block_info *z = get_block_info(zbb);
+
+				/* J-edge unless y is the immediate dominator of z */
+				if (ir_bb_dom_info(zbb)->idom->bb == y->bb || z->level > root->level || z->phi_stamp == stamp)
+				{
+					continue;
+				}
+
+				z->phi_stamp = stamp;
+				if (z->livein_stamp == stamp)
 				{
-					bset_add(kill, var->live_idx);
-					bset_remove(gen, var->live_idx);
+					ir_node *phi = ir_node_build_phi(zbb, var->type);
+					scratch_set_var(phi, var);
 				}
-				else if (ir_node_op(n) == IR_OP_load && (var = scratch_get_var(n)))
+				if (z->bank_stamp != stamp)
 				{
-					bset_add(gen, var->live_idx);
+					bank_insert(bank, z, stamp);
 				}
 			}
 
-			bset_not(kill, kill);
-			bset_intersect(liveout, kill);
-			bset_union(liveout, gen);
-			if (!bset_equal(livein, liveout))
+			for (child = ir_bb_dom_info(y->bb)->domtree_children; child != NULL; child = child->next)
 			{
-				bset_copy(livein, liveout);
-				livein_changed = 1;
+				block_info *c = get_block_info(child->info->bb);
+				if (c->visit_stamp != stamp)
+				{
+					c->visit_stamp = stamp;
+					stack[si++] = c;
+				}
 			}
 		}
 	}
 }
 
-static void do_mem2reg(ir_func *func)
+static int do_mem2reg(ir_func *func)
 {
 	ir_bb_iter bit;
 	ir_bb *bb;
 	ir_node_iter nit;
 	ir_node *n;
-	unsigned idx = 0;
+	variable *vars = NULL, **vars_tail = &vars, *var;
+	block_info **bank, **stack;
+	unsigned max_level = 0;
+	unsigned n_vars = 0;
+	int changed = 0;
 
 	/* Dominance information required */
-	ir_dom_setup_dom_info(func);
+	ir_analysis_require(func, IR_ANALYSIS(IR_ANALYSIS_DOMTREE));
 
-	graph_marker_alloc(&func->ssa_graph_ctx, &scratch_marker);
+	ir_node_map_init(&var_map, func, sizeof(variable *));
+	ir_bb_map_init(&block_map, func, sizeof(block_info));
+	scratch_arena = func->arena;
 
 	/* All alloca nodes will be found in the entry block */
 	ir_node_iter_init(&nit, func->entry);
@@ -334,53 +484,54 @@ static void do_mem2reg(ir_func *func)
 	{
 		if (ir_node_op(n) == IR_OP_alloca)
 		{
-			variable *var = calloc(1, sizeof(variable));
+			var = arena_alloc(scratch_arena, sizeof(variable));
 			scratch_set_var(n, var);
 			var->alloca = n;
-			var->live_idx = idx++;
+			var->stamp = ++n_vars;
+			*vars_tail = var;
+			vars_tail = &var->next;
 
 			link_def_use_to_var(var, n);
 		}
 	}
 
-	/* Compute liveness for pruned ssa-form */
-	compute_livein(func, idx);
-
-	/* Determine location for phi-nodes. Find definitions of variables
-	   and insert phi-nodes in the iterated dominance frontier of the
-	   defining block. */
+	/* Determine location for phi-nodes. Summarize the accesses of each
+	   block once, then for each variable compute where it is live-in and
+	   insert phi-nodes in the live part of the iterated dominance frontier
+	   of its defining blocks. */
+	summarize_blocks(func);
 
+	bank = arena_alloc(scratch_arena, func->n_ir_bbs*sizeof(block_info *));
+	stack = arena_alloc(scratch_arena, func->n_ir_bbs*sizeof(block_info *));
 	ir_bb_iter_init(&bit, func);
 	while ((bb = ir_bb_iter_next(&bit)))
 	{
-		ir_node_iter_init(&nit, bb);
-		while ((n = ir_node_iter_next(&nit)))
+		unsigned level = get_block_info(bb)->level;
+		max_level = level > max_level ? level : max_level;
+	}
+
+	for (var = vars; var != NULL; var = var->next)
+	{
+		changed |= !var->is_rejected && (var->def_bbs != NULL || var->use_bbs != NULL);
+		if (var->is_rejected == 0 && var->def_bbs != NULL)
 		{
-			if (ir_node_op(n) == IR_OP_store)
-			{
-				graph_marker marker;
-				variable *var = scratch_get_var(n);
-				if (var != NULL && var->is_rejected == 0)
-				{
-					graph_marker_alloc(&func->cfg_graph_ctx, &marker);
-					insert_phi_in_iter_df(ir_node_bb(n), var, ir_node_type(n), &marker);
-					graph_marker_free(&func->cfg_graph_ctx, &marker);
-				}
-			}
+			compute_var_livein(var, stack);
+			place_phis(var, bank, stack, max_level);
 		}
 	}
 
 	/* Walk the dominator tree and rename each variable as
 	   appropriate */
-	walk_domtree_rename(func->entry);
-	graph_marker_free(&func->ssa_graph_ctx, &scratch_marker);
+	rename_vars(func);
+	ir_node_map_destroy(&var_map);
+	ir_bb_map_destroy(&block_map);
 
-	/* Dominance information no longer needed */
-	ir_dom_destroy_dom_info(func);
+	return changed;
 }
 
 ir_pass mem2reg = {
 	"mem2reg",
-	do_mem2reg
+	do_mem2reg,
+	IR_ANALYSES_CFG /* only the ssa graph is changed */
 };
 
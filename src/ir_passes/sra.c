@@ -0,0 +1,251 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ir/ir_analysis.h"
+#include "ir/ir_bb.h"
+#include "ir/ir_node.h"
+#include "ir/ir_func.h"
+#include "ir/ir_type.h"
+#include "ir_passes/sra.h"
+#include "util/arena.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+ * Scalar replacement of aggregates. An alloca whose address only flows
+ * through add nodes with constant offsets into loads and stores is split
+ * into one alloca per accessed field or element. The new allocas are only
+ * accessed directly and are thus promoted to registers by mem2reg that is
+ * expected to run next.
+ */
+
+typedef struct access {
+	struct access *next;
+	ir_node *n; /* load or store */
+	ir_node *addr;
+	int64_t offset;
+	ir_type type;
+} access;
+
+typedef struct aggregate {
+	ir_node *alloca;
+	access *accesses;
+	unsigned n_accesses;
+	int has_offsets;
+	arena *arena;
+} aggregate;
+
+/* Evaluate an offset expression built from constants only, the frontend
+   leaves element offsets as e.g. mul(const, const). */
+static int eval_const(ir_node *n, int64_t *value)
+{
+	ir_node *args[2];
+	int64_t a, b;
+
+	if (ir_node_op(n) == IR_OP_const)
+	{
+		*value = ir_node_const_as_i64(n);
+		return 1;
+	}
+
+	switch (ir_node_op(n))
+	{
+	case IR_OP_add:
+	case IR_OP_sub:
+	case IR_OP_mul:
+	case IR_OP_shl:
+		ir_node_get_args(n, NULL, args, 2);
+		if (!eval_const(args[0], &a) || !eval_const(args[1], &b))
+		{
+			return 0;
+		}
+		break;
+	default:
+		return 0;
+	}
+
+	switch (ir_node_op(n))
+	{
+	case IR_OP_add:
+		*value = a + b;
+		break;
+	case IR_OP_sub:
+		*value = a - b;
+		break;
+	case IR_OP_mul:
+		*value = a * b;
+		break;
+	default:
+		if (b < 0 || b > 31)
+		{
+			return 0;
+		}
+		*value = a << b;
+		break;
+	}
+
+	return 1;
+}
+
+/* Record all accesses through addr, which is the alloca plus offset.
+   Returns zero if the address escapes or is offset by a non-constant. */
+static int collect_accesses(aggregate *agg, ir_node *addr, int64_t offset)
+{
+	ir_node_use_iter it;
+	ir_node *use;
+	unsigned arg_idx;
+
+	ir_node_use_iter_init(&it, addr);
+	while ((use = ir_node_use_iter_next(&it, &arg_idx)))
+	{
+		ir_op op = ir_node_op(use);
+
+		if ((op == IR_OP_store && arg_idx == 0) || op == IR_OP_load)
+		{
+			access *acc = arena_alloc(agg->arena, sizeof(access));
+			acc->n = use;
+			acc->addr = addr;
+			acc->offset = offset;
+			acc->type = ir_node_type(use);
+			acc->next = agg->accesses;
+			agg->accesses = acc;
+			agg->n_accesses++;
+		}
+		else if (op == IR_OP_add)
+		{
+			ir_node *args[2];
+			int64_t value;
+
+			ir_node_get_args(use, NULL, args, 2);
+			if (args[0] == args[1] || !eval_const(args[arg_idx == 0 ? 1 : 0], &value))
+			{
+				return 0;
+			}
+
+			agg->has_offsets = 1;
+			if (!collect_accesses(agg, use, offset + value))
+			{
+				return 0;
+			}
+		}
+		else
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+static int access_cmp(const void *a, const void *b)
+{
+	const access *acc_a = *(const access **)a;
+	const access *acc_b = *(const access **)b;
+
+	if (acc_a->offset != acc_b->offset)
+	{
+		return acc_a->offset < acc_b->offset ? -1 : 1;
+	}
+	return (int)acc_a->type - (int)acc_b->type;
+}
+
+/* Split the aggregate if every access is in bounds and accesses either
+   hit exactly the same bytes with the same type or do not overlap at
+   all. */
+static int split_aggregate(ir_func *func, aggregate *agg)
+{
+	access **accs = arena_alloc(agg->arena, agg->n_accesses*sizeof(access *));
+	unsigned size = ir_node_alloca_size(agg->alloca);
+	ir_node *slot = NULL;
+	access *acc;
+	unsigned i;
+
+	for (i = 0, acc = agg->accesses; acc != NULL; acc = acc->next)
+	{
+		accs[i++] = acc;
+	}
+	qsort(accs, agg->n_accesses, sizeof(access *), access_cmp);
+
+	for (i = 0; i < agg->n_accesses; i++)
+	{
+		int64_t end = accs[i]->offset + ir_type_bytes(accs[i]->type);
+
+		if (accs[i]->offset < 0 || end > size)
+		{
+			return 0;
+		}
+
+		if (i + 1 < agg->n_accesses &&
+		    accs[i + 1]->offset < end &&
+		    (accs[i + 1]->offset != accs[i]->offset || accs[i + 1]->type != accs[i]->type))
+		{
+			return 0;
+		}
+	}
+
+	for (i = 0; i < agg->n_accesses; i++)
+	{
+		if (i == 0 || accs[i]->offset != accs[i - 1]->offset)
+		{
+			slot = ir_node_build_alloca(func->entry, ir_type_bytes(accs[i]->type),
+			                            ir_node_alloca_align(agg->alloca));
+		}
+
+		ir_node_change_arg(accs[i]->n, accs[i]->addr, slot);
+	}
+
+	return 1;
+}
+
+static int do_sra(ir_func *func)
+{
+	ir_node_iter nit;
+	ir_node *n;
+	int changed = 0;
+
+	/* All alloca nodes will be found in the entry block */
+	ir_node_iter_init(&nit, func->entry);
+	while ((n = ir_node_iter_next(&nit)))
+	{
+		aggregate agg = {n, NULL, 0, 0, func->arena};
+
+		if (ir_node_op(n) != IR_OP_alloca)
+		{
+			continue;
+		}
+
+		if (collect_accesses(&agg, n, 0) && agg.has_offsets && agg.n_accesses > 0)
+		{
+			changed |= split_aggregate(func, &agg);
+		}
+	}
+
+	return changed;
+}
+
+ir_pass sra = {
+	"sra",
+	do_sra,
+	IR_ANALYSES_CFG /* only the ssa graph is changed */
+};
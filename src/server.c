@@ -0,0 +1,247 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "server.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static int
+open_socket(const char *path, struct sockaddr_un *addr)
+{
+	if (strlen(path) >= sizeof(addr->sun_path))
+	{
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+	strcpy(addr->sun_path, path);
+
+	return socket(AF_UNIX, SOCK_STREAM, 0);
+}
+
+static char *
+read_all(int fd, size_t *size)
+{
+	size_t room_for = 4096;
+	char *buf = malloc(room_for + 1);
+	ssize_t n;
+
+	*size = 0;
+	for (;;)
+	{
+		if (*size == room_for)
+		{
+			room_for *= 2;
+			buf = realloc(buf, room_for + 1);
+		}
+		n = read(fd, buf + *size, room_for - *size);
+		if (n < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (n <= 0)
+		{
+			break;
+		}
+		*size += n;
+	}
+	buf[*size] = '\0';
+
+	return buf;
+}
+
+static int
+write_all(int fd, const char *buf, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t n = write(fd, buf, size);
+		if (n < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (n <= 0)
+		{
+			return 0;
+		}
+		buf += n;
+		size -= n;
+	}
+	return 1;
+}
+
+static int
+serve(int fd, server_handler handler, void *user)
+{
+	char **argv;
+	char *req, *p, *cwd;
+	char *diag_text;
+	size_t size, diag_size;
+	FILE *diag;
+	char status_line[32];
+	int argc = 0;
+	int status;
+
+	req = read_all(fd, &size);
+	argv = calloc(size + 1, sizeof(char *));
+	cwd = req;
+	for (p = req + strlen(req) + 1; p < req + size; p += strlen(p) + 1)
+	{
+		argv[argc++] = p;
+	}
+
+	diag = open_memstream(&diag_text, &diag_size);
+	if (argc == 0)
+	{
+		fprintf(diag, "malformed request\n");
+		status = 1;
+	}
+	else if (chdir(cwd) != 0)
+	{
+		fprintf(diag, "%s: %s\n", cwd, strerror(errno));
+		status = 1;
+	}
+	else
+	{
+		status = handler(argc, argv, diag, user);
+	}
+	fclose(diag);
+
+	snprintf(status_line, sizeof(status_line), "%d\n", status < 0 ? 0 : status);
+	(void)(write_all(fd, status_line, strlen(status_line)) &&
+	       write_all(fd, diag_text, diag_size));
+
+	free(diag_text);
+	free(argv);
+	free(req);
+
+	return status >= 0;
+}
+
+int
+server_run(const char *path, server_handler handler, void *user)
+{
+	struct sockaddr_un addr;
+	struct stat st;
+	int lfd, fd;
+
+	if ((lfd = open_socket(path, &addr)) < 0)
+	{
+		return 0;
+	}
+
+	/* A stale socket from an earlier server is replaced, anything else
+	   at path is left alone */
+	if (lstat(path, &st) == 0)
+	{
+		if (!S_ISSOCK(st.st_mode))
+		{
+			close(lfd);
+			errno = EEXIST;
+			return 0;
+		}
+		unlink(path);
+	}
+
+	/* A client going away mid reply must not take the server with it */
+	signal(SIGPIPE, SIG_IGN);
+	if (bind(lfd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(lfd, 16) != 0)
+	{
+		close(lfd);
+		return 0;
+	}
+
+	for (;;)
+	{
+		if ((fd = accept(lfd, NULL, NULL)) < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			break;
+		}
+		if (!serve(fd, handler, user))
+		{
+			close(fd);
+			break;
+		}
+		close(fd);
+	}
+
+	close(lfd);
+	unlink(path);
+
+	return fd >= 0;
+}
+
+int
+server_forward(const char *path, int argc, char **argv)
+{
+	struct sockaddr_un addr;
+	char cwd[4096];
+	char *reply, *diag;
+	size_t size;
+	int fd, i, ok, status;
+
+	if ((fd = open_socket(path, &addr)) < 0)
+	{
+		return -1;
+	}
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || getcwd(cwd, sizeof(cwd)) == NULL)
+	{
+		close(fd);
+		return -1;
+	}
+
+	ok = write_all(fd, cwd, strlen(cwd) + 1);
+	for (i = 0; ok && i < argc; i++)
+	{
+		ok = write_all(fd, argv[i], strlen(argv[i]) + 1);
+	}
+	shutdown(fd, SHUT_WR);
+
+	reply = read_all(fd, &size);
+	close(fd);
+	if (!ok || (diag = strchr(reply, '\n')) == NULL)
+	{
+		free(reply);
+		return -1;
+	}
+
+	status = strtol(reply, NULL, 10);
+	diag++;
+	fwrite(diag, 1, size - (diag - reply), stderr);
+	free(reply);
+
+	return status;
+}
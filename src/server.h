@@ -0,0 +1,50 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdio.h>
+
+/* A compile server listening on a Unix socket. A request is the working
+   directory of the client followed by its arguments, each NUL terminated.
+   The reply is the exit status on a line of its own followed by the
+   diagnostics. Requests are served one at a time. */
+
+/* Handle one request, writing diagnostics to diag. Returns the exit
+   status for the client, or a negative value to reply with status 0 and
+   stop the server. */
+typedef int (*server_handler)(int argc, char **argv, FILE *diag, void *user);
+
+/* Serve requests until stopped by the handler, returns 0 on socket
+   errors or if path exists and is not a socket */
+int
+server_run(const char *path, server_handler handler, void *user);
+
+/* Forward argc/argv to the server at path and relay its diagnostics to
+   stderr. Returns the exit status from the server, or -1 if there is no
+   server to talk to. */
+int
+server_forward(const char *path, int argc, char **argv);
+
+#endif
@@ -28,6 +28,7 @@
 #include "ir/ir_bb.h"
 #include "ir/ir_data.h"
 #include "ir/ir_func.h"
+#include "ir/ir_map.h"
 #include "ir/ir_node.h"
 #include "ir/ir_type.h"
 #include "ir/ir_print.h"
@@ -40,7 +41,6 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
-#include <glib.h>
 
 #define BSOP(type,op,res,operand1,operand2) \
 do { \
@@ -112,14 +112,14 @@ typedef struct ssa_value {
 	uint64_t undef_mask;
 } ssa_value;
 
-static void ssa_values_for_args(GHashTable *map, ir_node *n, unsigned max_args, ir_node **args, ssa_value **vargs)
+static void ssa_values_for_args(ir_node_map *map, ir_node *n, unsigned max_args, ir_node **args, ssa_value **vargs)
 {
 	unsigned n_args, i;
 
 	ir_node_get_args(n, &n_args, args, max_args);
 	for (i = 0; i < n_args; i++)
 	{
-		vargs[i] = g_hash_table_lookup(map, args[i]);
+		vargs[i] = ir_node_map_lookup(map, args[i]);
 		assert(vargs[i]);
 	}
 }
@@ -183,11 +183,9 @@ void ir_sim_func_1(FILE *fp, memctx *mctx, unsigned indent, unsigned sp,
 	ir_bb *prev_bb = NULL;
 	ir_node_iter nit;
 	ir_node *n;
-	GHashTable *valuemap;
+	ir_node_map valuemap;
 
-	valuemap = g_hash_table_new(NULL, NULL);
-	ssa_value values_table[func->n_ir_nodes];
-	unsigned values_table_idx = 0;
+	ir_node_map_init(&valuemap, func, sizeof(ssa_value));
 	unsigned phi_stack_idx;
 	struct {
 		ir_node *n;
@@ -205,16 +203,11 @@ void ir_sim_func_1(FILE *fp, memctx *mctx, unsigned indent, unsigned sp,
 			ssa_value *vargs[16];
 			ir_node *args[16];
 
-			if ((vn = g_hash_table_lookup(valuemap, n)) == NULL)
-			{
-				vn = &values_table[values_table_idx++];
-				g_hash_table_insert(valuemap, n, vn);
-				assert(values_table_idx <= func->n_ir_nodes);
-			}
+			vn = ir_node_map_get(&valuemap, n);
 
 			if (ir_node_op(n) != IR_OP_phi)
 			{
-				ssa_values_for_args(valuemap, n, 16, args, vargs);
+				ssa_values_for_args(&valuemap, n, 16, args, vargs);
 				/* copy pending phi-values */
 				while (phi_stack_idx > 0)
 				{
@@ -255,7 +248,7 @@ void ir_sim_func_1(FILE *fp, memctx *mctx, unsigned indent, unsigned sp,
 						if (tmp_bb == prev_bb)
 						{
 							ssa_value *vtmp;
-							vtmp = g_hash_table_lookup(valuemap, tmp);
+							vtmp = ir_node_map_lookup(&valuemap, tmp);
 							assert(phi_stack_idx < sizeof(phi_stack)/sizeof(phi_stack[0]));
 							phi_stack[phi_stack_idx].n = n;
 							phi_stack[phi_stack_idx].vn = vn;
@@ -489,7 +482,7 @@ void ir_sim_func_1(FILE *fp, memctx *mctx, unsigned indent, unsigned sp,
 				ir_node *ncond = ir_bb_get_term_node(bb);
 				ssa_value *vcond;
 				int cond;
-				vcond = g_hash_table_lookup(valuemap, ncond);
+				vcond = ir_node_map_lookup(&valuemap, ncond);
 				switch (ir_node_type(ncond)) {
 				case i8:  cond = (vcond->u.u8  != 0); break;
 				case i16: cond = (vcond->u.u16 != 0); break;
@@ -510,7 +503,7 @@ void ir_sim_func_1(FILE *fp, memctx *mctx, unsigned indent, unsigned sp,
 			{
 				ir_node *tn = ir_bb_get_term_node(bb);
 				ssa_value *vn;
-				vn = g_hash_table_lookup(valuemap, tn);
+				vn = ir_node_map_lookup(&valuemap, tn);
 				UUOP(func->ret_type, , fret, vn);
 				newline(fp, indent);
 				fprintf(fp, "ret %%%d", ir_node_id(tn));
@@ -524,7 +517,7 @@ void ir_sim_func_1(FILE *fp, memctx *mctx, unsigned indent, unsigned sp,
 		}
 	}
 
-	g_hash_table_destroy(valuemap);
+	ir_node_map_destroy(&valuemap);
 }
 
 void ir_sim_func(FILE *fp, ir_tu *tu, const char *fname)
@@ -0,0 +1,165 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "util/analysis.h"
+#include <assert.h>
+#include <stddef.h>
+
+void
+analysis_mgr_init(analysis_mgr *m, const analysis_desc *descs, unsigned n_descs,
+                  const graph_ctx *g0, const graph_ctx *g1)
+{
+	unsigned a;
+
+	assert(n_descs <= ANALYSIS_MAX);
+	for (a = 0; a < n_descs; a++)
+	{
+		/* Dependencies come first so a single sweep computes them in order */
+		assert((descs[a].deps >> a) == 0);
+	}
+
+	m->descs = descs;
+	m->n_descs = n_descs;
+	m->graphs[0] = g0;
+	m->graphs[1] = g1;
+	m->valid = 0;
+}
+
+static int
+is_current(analysis_mgr *m, unsigned a)
+{
+	unsigned g;
+
+	if (!(m->valid & (1U << a)))
+	{
+		return 0;
+	}
+
+	for (g = 0; g < ANALYSIS_MAX_GRAPHS; g++)
+	{
+		if ((m->descs[a].graphs & (1U << g)) && m->version[a][g] != m->graphs[g]->version)
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+static void
+stamp(analysis_mgr *m, unsigned a)
+{
+	unsigned g;
+
+	for (g = 0; g < ANALYSIS_MAX_GRAPHS; g++)
+	{
+		if (m->graphs[g] != NULL)
+		{
+			m->version[a][g] = m->graphs[g]->version;
+		}
+	}
+}
+
+void
+analysis_require(analysis_mgr *m, void *unit, unsigned mask)
+{
+	unsigned a;
+
+	/* Dependencies have lower indices, close the mask over them top down */
+	for (a = m->n_descs; a-- > 0;)
+	{
+		if (mask & (1U << a))
+		{
+			mask |= m->descs[a].deps;
+		}
+	}
+
+	for (a = 0; a < m->n_descs; a++)
+	{
+		if (!(mask & (1U << a)) || is_current(m, a))
+		{
+			continue;
+		}
+
+		/* Anything computed from the old result is stale as well */
+		analysis_invalidate(m, unit, 1U << a);
+		m->descs[a].compute(unit);
+		m->valid |= 1U << a;
+		stamp(m, a);
+	}
+}
+
+void
+analysis_preserve(analysis_mgr *m, void *unit, unsigned mask)
+{
+	unsigned a;
+
+	analysis_invalidate(m, unit, m->valid & ~mask);
+
+	for (a = 0; a < m->n_descs; a++)
+	{
+		if (m->valid & (1U << a))
+		{
+			stamp(m, a);
+		}
+	}
+}
+
+void
+analysis_invalidate(analysis_mgr *m, void *unit, unsigned mask)
+{
+	unsigned a;
+
+	for (a = 0; a < m->n_descs; a++)
+	{
+		if (m->descs[a].deps & mask)
+		{
+			mask |= 1U << a;
+		}
+
+		if ((mask & m->valid & (1U << a)) == 0)
+		{
+			continue;
+		}
+
+		m->valid &= ~(1U << a);
+		if (m->descs[a].destroy != NULL)
+		{
+			m->descs[a].destroy(unit);
+		}
+	}
+}
+
+void
+analysis_drop_stale(analysis_mgr *m, void *unit)
+{
+	unsigned a;
+
+	for (a = 0; a < m->n_descs; a++)
+	{
+		if ((m->valid & (1U << a)) && !is_current(m, a))
+		{
+			analysis_invalidate(m, unit, 1U << a);
+		}
+	}
+}
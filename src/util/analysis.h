@@ -0,0 +1,73 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+/* Lazily computed, cached analyses on top of graphs. Each analysis records
+   the versions of the graphs it was computed from and is recomputed when
+   requested after any of them changed. A pass that knows an analysis
+   survived its changes says so with analysis_preserve(), everything it
+   does not preserve is dropped. */
+
+#include "util/graph.h"
+
+#define ANALYSIS_MAX 8
+#define ANALYSIS_MAX_GRAPHS 2
+
+typedef struct analysis_desc {
+	const char *name;
+	unsigned graphs; /* mask of the manager graphs the result depends on */
+	unsigned deps; /* mask of analyses the result is computed from */
+	void (*compute)(void *unit);
+	void (*destroy)(void *unit); /* may be NULL */
+} analysis_desc;
+
+typedef struct analysis_mgr {
+	const analysis_desc *descs;
+	unsigned n_descs;
+	const graph_ctx *graphs[ANALYSIS_MAX_GRAPHS];
+	unsigned valid;
+	unsigned version[ANALYSIS_MAX][ANALYSIS_MAX_GRAPHS];
+} analysis_mgr;
+
+void
+analysis_mgr_init(analysis_mgr *m, const analysis_desc *descs, unsigned n_descs,
+                  const graph_ctx *g0, const graph_ctx *g1);
+
+void
+analysis_require(analysis_mgr *m, void *unit, unsigned mask);
+
+void
+analysis_preserve(analysis_mgr *m, void *unit, unsigned mask);
+
+void
+analysis_invalidate(analysis_mgr *m, void *unit, unsigned mask);
+
+/* Drop results whose graphs changed since they were computed. Done before
+   a pass runs, so that its analysis_preserve() can not keep a result that
+   was already stale. */
+void
+analysis_drop_stale(analysis_mgr *m, void *unit);
+
+#endif
@@ -0,0 +1,174 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "util/arena.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_CHUNK_SIZE (64*1024)
+#define ARENA_ALIGN 8
+#define ARENA_MAX_CACHED_CHUNKS 64
+
+struct arena_chunk {
+	struct arena_chunk *next;
+	unsigned size;
+	unsigned used;
+	unsigned char data[];
+};
+
+struct arena {
+	struct arena_chunk *chunks;
+	arena_usage usage;
+};
+
+/* Standard size chunks of destroyed arenas are kept for reuse, so that a
+   long running process (see --server) stays warm between compiles */
+static struct arena_chunk *cached_chunks;
+static unsigned n_cached_chunks;
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+arena *
+arena_create(void)
+{
+	/* Chunks are allocated lazily so that an unused arena is cheap */
+	return calloc(1, sizeof(arena));
+}
+
+static struct arena_chunk *
+chunk_create(unsigned size)
+{
+	struct arena_chunk *c = NULL;
+
+	if (size == ARENA_CHUNK_SIZE)
+	{
+		pthread_mutex_lock(&cache_lock);
+		if ((c = cached_chunks) != NULL)
+		{
+			cached_chunks = c->next;
+			n_cached_chunks--;
+		}
+		pthread_mutex_unlock(&cache_lock);
+	}
+
+	if (c == NULL)
+	{
+		c = malloc(sizeof(struct arena_chunk) + size);
+	}
+	c->size = size;
+	c->used = 0;
+	return c;
+}
+
+static void
+chunk_destroy(struct arena_chunk *c)
+{
+	if (c->size == ARENA_CHUNK_SIZE)
+	{
+		pthread_mutex_lock(&cache_lock);
+		if (n_cached_chunks < ARENA_MAX_CACHED_CHUNKS)
+		{
+			c->next = cached_chunks;
+			cached_chunks = c;
+			n_cached_chunks++;
+			c = NULL;
+		}
+		pthread_mutex_unlock(&cache_lock);
+	}
+	free(c);
+}
+
+void *
+arena_alloc(arena *a, unsigned size)
+{
+	struct arena_chunk *c = a->chunks;
+	void *p;
+
+	size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+
+	if (c == NULL || c->size - c->used < size)
+	{
+		if (size > ARENA_CHUNK_SIZE/4)
+		{
+			/* Large request, give it a chunk of its own and keep
+			   bumping in the current one */
+			c = chunk_create(size);
+			a->usage.n_reserved += size;
+			if (a->chunks != NULL)
+			{
+				c->next = a->chunks->next;
+				a->chunks->next = c;
+			}
+			else
+			{
+				c->next = NULL;
+				a->chunks = c;
+			}
+		}
+		else
+		{
+			c = chunk_create(ARENA_CHUNK_SIZE);
+			a->usage.n_reserved += ARENA_CHUNK_SIZE;
+			c->next = a->chunks;
+			a->chunks = c;
+		}
+	}
+
+	assert(c->size - c->used >= size);
+	p = &c->data[c->used];
+	c->used += size;
+	memset(p, 0, size);
+	a->usage.n_allocs++;
+	a->usage.n_bytes += size;
+
+	return p;
+}
+
+char *
+arena_strdup(arena *a, const char *str)
+{
+	unsigned len = strlen(str) + 1;
+	char *p = arena_alloc(a, len);
+	memcpy(p, str, len);
+	return p;
+}
+
+void
+arena_get_usage(arena *a, arena_usage *usage)
+{
+	*usage = a->usage;
+}
+
+void
+arena_destroy(arena *a)
+{
+	struct arena_chunk *c, *next;
+
+	for (c = a->chunks; c != NULL; c = next)
+	{
+		next = c->next;
+		chunk_destroy(c);
+	}
+	free(a);
+}
@@ -0,0 +1,53 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+/* Bump allocator. Memory handed out by an arena is zero initialized and
+   is only ever returned in bulk by arena_destroy(). */
+
+typedef struct arena arena;
+
+typedef struct arena_usage {
+	unsigned long n_allocs;
+	unsigned long n_bytes; /* handed out */
+	unsigned long n_reserved; /* held in chunks */
+} arena_usage;
+
+arena *
+arena_create(void);
+
+void *
+arena_alloc(arena *a, unsigned size);
+
+char *
+arena_strdup(arena *a, const char *str);
+
+void
+arena_get_usage(arena *a, arena_usage *usage);
+
+void
+arena_destroy(arena *a);
+
+#endif
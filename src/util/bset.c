@@ -22,87 +22,273 @@
  */
 
 #include "util/bset.h"
+#include "util/arena.h"
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+/* Bits are kept in 64-bit words. Bits at positions >= size are always
+   zero so that whole word operations (count, iteration, equality) never
+   need to mask the last word.
+
+   Sets created with bset_create_sparse_set() instead start out as a
+   sorted array of members and are turned into the word representation
+   once the array would take more memory than the bitmap. Clearing such a
+   set makes it sparse again. */
+
+typedef uint64_t bset_word;
+
+#define BSET_WORD_BITS (sizeof(bset_word)*8)
+#define BSET_WORD_IDX(x) ((unsigned)(x) / BSET_WORD_BITS)
+#define BSET_BIT(x) ((bset_word)1 << ((unsigned)(x) % BSET_WORD_BITS))
+
+/* Sparse sets with fewer bits than this are made dense right away */
+#define BSET_SPARSE_MIN_SIZE 256
+#define BSET_SPARSE_MIN_ROOM 8
+
 struct bset_set {
-	unsigned *bitwords;
+	bset_word *bitwords; /* NULL until a sparse set first becomes dense */
 	unsigned n_bitwords;
 	unsigned size;
+	int *members; /* sorted, NULL for sets that are always dense */
+	unsigned n_members;
+	unsigned room_for;
+	int is_sparse;
+	struct arena *arena; /* NULL if heap allocated */
 };
 
-bset_set *
-bset_create_set(unsigned size)
+static void *
+bset_alloc(bset_set *set, unsigned size)
+{
+	return set->arena ? arena_alloc(set->arena, size) : calloc(1, size);
+}
+
+static void
+bset_free(bset_set *set, void *p)
+{
+	if (set->arena == NULL)
+	{
+		free(p);
+	}
+}
+
+static bset_set *
+bset_create(struct arena *a, unsigned size, int sparse)
 {
-	bset_set *set = calloc(1, sizeof(bset_set));
-	set->n_bitwords = size/(sizeof(set->bitwords[0])*8)+1;
-	set->bitwords= calloc(set->n_bitwords, sizeof(set->bitwords[0]));
+	bset_set *set = a ? arena_alloc(a, sizeof(bset_set)) : calloc(1, sizeof(bset_set));
+	set->arena = a;
+	set->n_bitwords = size/BSET_WORD_BITS+1;
 	set->size = size;
+	if (sparse && size >= BSET_SPARSE_MIN_SIZE)
+	{
+		set->room_for = BSET_SPARSE_MIN_ROOM;
+		set->members = bset_alloc(set, set->room_for*sizeof(set->members[0]));
+		set->is_sparse = 1;
+	}
+	else
+	{
+		set->bitwords = bset_alloc(set, set->n_bitwords*sizeof(set->bitwords[0]));
+	}
 	return set;
 }
 
-void
-bset_clear(bset_set *set)
+bset_set *
+bset_create_set(unsigned size)
+{
+	return bset_create(NULL, size, 0);
+}
+
+bset_set *
+bset_create_arena_set(struct arena *a, unsigned size)
+{
+	return bset_create(a, size, 0);
+}
+
+bset_set *
+bset_create_sparse_set(struct arena *a, unsigned size)
+{
+	return bset_create(a, size, 1);
+}
+
+/* Max number of members kept in the sorted array, past this the
+   bitmap is smaller */
+static unsigned
+sparse_limit(bset_set *set)
+{
+	return set->n_bitwords*sizeof(bset_word)/sizeof(set->members[0]);
+}
+
+/* Index of first member >= x */
+static unsigned
+sparse_lower_bound(bset_set *set, int x)
+{
+	unsigned lo = 0, hi = set->n_members;
+
+	while (lo < hi)
+	{
+		unsigned mid = lo + (hi - lo)/2;
+		if (set->members[mid] < x)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+static void
+sparse_reserve(bset_set *set, unsigned n)
+{
+	int *members;
+
+	if (n <= set->room_for)
+	{
+		return;
+	}
+
+	while (set->room_for < n)
+	{
+		set->room_for *= 2;
+	}
+
+	members = bset_alloc(set, set->room_for*sizeof(set->members[0]));
+	memcpy(members, set->members, set->n_members*sizeof(set->members[0]));
+	bset_free(set, set->members);
+	set->members = members;
+}
+
+static void
+make_dense(bset_set *set)
 {
 	unsigned i;
 
-	for (i = 0; i < set->n_bitwords; i++)
+	if (!set->is_sparse)
 	{
-		set->bitwords[i] = 0;
+		return;
 	}
+
+	if (set->bitwords == NULL)
+	{
+		set->bitwords = bset_alloc(set, set->n_bitwords*sizeof(set->bitwords[0]));
+	}
+	else
+	{
+		memset(set->bitwords, 0, set->n_bitwords*sizeof(set->bitwords[0]));
+	}
+
+	for (i = 0; i < set->n_members; i++)
+	{
+		set->bitwords[BSET_WORD_IDX(set->members[i])] |= BSET_BIT(set->members[i]);
+	}
+
+	set->n_members = 0;
+	set->is_sparse = 0;
 }
 
 void
-bset_add(bset_set *set, int x)
+bset_clear(bset_set *set)
 {
-	unsigned word_idx;
-	unsigned bit_idx;
+	if (set->members != NULL)
+	{
+		set->n_members = 0;
+		set->is_sparse = 1;
+	}
+	else
+	{
+		memset(set->bitwords, 0, set->n_bitwords*sizeof(set->bitwords[0]));
+	}
+}
 
+void
+bset_add(bset_set *set, int x)
+{
 	assert(x < set->size);
-	
-	word_idx = x / (sizeof(set->bitwords[0])*8);
-	bit_idx = x % (sizeof(set->bitwords[0])*8);
-	
-	set->bitwords[word_idx] |= (1 << bit_idx);
+
+	if (set->is_sparse)
+	{
+		unsigned idx = sparse_lower_bound(set, x);
+
+		if (idx < set->n_members && set->members[idx] == x)
+		{
+			return;
+		}
+
+		if (set->n_members < sparse_limit(set))
+		{
+			sparse_reserve(set, set->n_members + 1);
+			memmove(&set->members[idx + 1], &set->members[idx], (set->n_members - idx)*sizeof(set->members[0]));
+			set->members[idx] = x;
+			set->n_members++;
+			return;
+		}
+
+		make_dense(set);
+	}
+
+	set->bitwords[BSET_WORD_IDX(x)] |= BSET_BIT(x);
 }
 
 void
 bset_remove(bset_set *set, int x)
 {
-	unsigned word_idx;
-	unsigned bit_idx;
-
 	assert(x < set->size);
-	
-	word_idx = x / (sizeof(set->bitwords[0])*8);
-	bit_idx = x % (sizeof(set->bitwords[0])*8);
-	
-	set->bitwords[word_idx] &= ~(1 << bit_idx);
+
+	if (set->is_sparse)
+	{
+		unsigned idx = sparse_lower_bound(set, x);
+
+		if (idx < set->n_members && set->members[idx] == x)
+		{
+			set->n_members--;
+			memmove(&set->members[idx], &set->members[idx + 1], (set->n_members - idx)*sizeof(set->members[0]));
+		}
+		return;
+	}
+
+	set->bitwords[BSET_WORD_IDX(x)] &= ~BSET_BIT(x);
 }
 
 int
 bset_has(bset_set *set, int x)
 {
-	unsigned word_idx;
-	unsigned bit_idx;
-
 	assert(x < set->size);
-	
-	word_idx = x / (sizeof(set->bitwords[0])*8);
-	bit_idx = x % (sizeof(set->bitwords[0])*8);
-	
-	return set->bitwords[word_idx] & (1 << bit_idx);
+
+	if (set->is_sparse)
+	{
+		unsigned idx = sparse_lower_bound(set, x);
+		return idx < set->n_members && set->members[idx] == x;
+	}
+
+	return (set->bitwords[BSET_WORD_IDX(x)] & BSET_BIT(x)) != 0;
 }
 
 int
 bset_equal(bset_set *src0, bset_set *src1)
 {
-	unsigned i;
+	int i, j;
+
 	assert(src0->size == src1->size);
-	for (i = 0; i < src0->n_bitwords; i++)
+
+	if (!src0->is_sparse && !src1->is_sparse)
 	{
-		if (src0->bitwords[i] != src1->bitwords[i])
+		return memcmp(src0->bitwords, src1->bitwords, src0->n_bitwords*sizeof(src0->bitwords[0])) == 0;
+	}
+
+	if (bset_count(src0) != bset_count(src1))
+	{
+		return 0;
+	}
+
+	for (i = bset_next_set(src0, 0), j = bset_next_set(src1, 0);
+	     i != -1;
+	     i = bset_next_set(src0, i + 1), j = bset_next_set(src1, j + 1))
+	{
+		if (i != j)
 		{
 			return 0;
 		}
@@ -114,45 +300,277 @@ bset_equal(bset_set *src0, bset_set *src1)
 void
 bset_copy(bset_set *dst, bset_set *src)
 {
-	unsigned i;
+	int i;
+
 	assert(dst->size == src->size);
-	for (i = 0; i < dst->n_bitwords; i++)
+
+	if (dst->members != NULL)
+	{
+		unsigned cnt = bset_count(src);
+
+		if (cnt <= sparse_limit(dst))
+		{
+			/* Keep dst sparse */
+			sparse_reserve(dst, cnt);
+			if (src->is_sparse)
+			{
+				memcpy(dst->members, src->members, cnt*sizeof(dst->members[0]));
+			}
+			else
+			{
+				unsigned idx = 0;
+				for (i = bset_next_set(src, 0); i != -1; i = bset_next_set(src, i + 1))
+				{
+					dst->members[idx++] = i;
+				}
+			}
+			dst->n_members = cnt;
+			dst->is_sparse = 1;
+			return;
+		}
+
+		bset_clear(dst);
+		make_dense(dst);
+	}
+
+	if (src->is_sparse)
+	{
+		memset(dst->bitwords, 0, dst->n_bitwords*sizeof(dst->bitwords[0]));
+		for (i = bset_next_set(src, 0); i != -1; i = bset_next_set(src, i + 1))
+		{
+			dst->bitwords[BSET_WORD_IDX(i)] |= BSET_BIT(i);
+		}
+		return;
+	}
+
+	memcpy(dst->bitwords, src->bitwords, dst->n_bitwords*sizeof(dst->bitwords[0]));
+}
+
+/* Merge the sorted members of src into sparse dst */
+static void
+sparse_union(bset_set *dst, bset_set *src)
+{
+	unsigned a = dst->n_members, b = src->n_members;
+	unsigned n = a + b, k = n;
+
+	if (a + b > sparse_limit(dst))
+	{
+		unsigned i;
+		make_dense(dst);
+		for (i = 0; i < b; i++)
+		{
+			dst->bitwords[BSET_WORD_IDX(src->members[i])] |= BSET_BIT(src->members[i]);
+		}
+		return;
+	}
+
+	/* Merge from the back so that it can be done in place, duplicates
+	   leave a gap at the front that is closed afterwards */
+	sparse_reserve(dst, a + b);
+	while (b > 0)
+	{
+		if (a > 0 && dst->members[a - 1] >= src->members[b - 1])
+		{
+			if (dst->members[a - 1] == src->members[b - 1])
+			{
+				b--;
+			}
+			dst->members[--k] = dst->members[--a];
+		}
+		else
+		{
+			dst->members[--k] = src->members[--b];
+		}
+	}
+	if (k > a)
 	{
-		dst->bitwords[i] = src->bitwords[i];
+		memmove(&dst->members[a], &dst->members[k], (n - k)*sizeof(dst->members[0]));
 	}
+	dst->n_members = n - (k - a);
 }
 
+/* The bulk operations below are kept as plain loops over restrict
+   qualified word arrays so that the compiler is free to vectorize them. */
+
 void
 bset_intersect(bset_set *dst, bset_set *src)
 {
-	unsigned i;
-	assert(dst->size == src->size);
-	for (i = 0; i < dst->n_bitwords; i++)
+	bset_word *restrict d;
+	const bset_word *restrict s;
+	unsigned i, n = dst->n_bitwords;
+
+	assert(dst->size == src->size && dst != src);
+
+	if (dst->is_sparse)
+	{
+		unsigned j = 0;
+		for (i = 0; i < dst->n_members; i++)
+		{
+			if (bset_has(src, dst->members[i]))
+			{
+				dst->members[j++] = dst->members[i];
+			}
+		}
+		dst->n_members = j;
+		return;
+	}
+
+	if (src->is_sparse)
+	{
+		unsigned j = 0;
+		for (i = 0; i < n; i++)
+		{
+			bset_word m = 0;
+			for (; j < src->n_members && BSET_WORD_IDX(src->members[j]) == i; j++)
+			{
+				m |= BSET_BIT(src->members[j]);
+			}
+			dst->bitwords[i] &= m;
+		}
+		return;
+	}
+
+	d = dst->bitwords;
+	s = src->bitwords;
+	for (i = 0; i < n; i++)
 	{
-		dst->bitwords[i] &= src->bitwords[i];
+		d[i] &= s[i];
 	}
 }
 
 void
 bset_union(bset_set *dst, bset_set *src)
 {
-	unsigned i;
-	assert(dst->size == src->size);
-	for (i = 0; i < dst->n_bitwords; i++)
+	bset_word *restrict d;
+	const bset_word *restrict s;
+	unsigned i, n = dst->n_bitwords;
+
+	assert(dst->size == src->size && dst != src);
+
+	if (src->is_sparse)
+	{
+		if (dst->is_sparse)
+		{
+			sparse_union(dst, src);
+		}
+		else
+		{
+			for (i = 0; i < src->n_members; i++)
+			{
+				dst->bitwords[BSET_WORD_IDX(src->members[i])] |= BSET_BIT(src->members[i]);
+			}
+		}
+		return;
+	}
+
+	make_dense(dst);
+
+	d = dst->bitwords;
+	s = src->bitwords;
+	for (i = 0; i < n; i++)
 	{
-		dst->bitwords[i] |= src->bitwords[i];
+		d[i] |= s[i];
 	}
 }
 
+void
+bset_andnot(bset_set *dst, bset_set *src)
+{
+	bset_word *restrict d;
+	const bset_word *restrict s;
+	unsigned i, n = dst->n_bitwords;
+
+	assert(dst->size == src->size && dst != src);
+
+	if (dst->is_sparse)
+	{
+		unsigned j = 0;
+		for (i = 0; i < dst->n_members; i++)
+		{
+			if (!bset_has(src, dst->members[i]))
+			{
+				dst->members[j++] = dst->members[i];
+			}
+		}
+		dst->n_members = j;
+		return;
+	}
+
+	if (src->is_sparse)
+	{
+		for (i = 0; i < src->n_members; i++)
+		{
+			dst->bitwords[BSET_WORD_IDX(src->members[i])] &= ~BSET_BIT(src->members[i]);
+		}
+		return;
+	}
+
+	d = dst->bitwords;
+	s = src->bitwords;
+	for (i = 0; i < n; i++)
+	{
+		d[i] &= ~s[i];
+	}
+}
+
+int
+bset_union_changed(bset_set *dst, bset_set *src)
+{
+	bset_word *restrict d;
+	const bset_word *restrict s;
+	bset_word changed = 0;
+	unsigned i, n = dst->n_bitwords;
+
+	assert(dst->size == src->size && dst != src);
+
+	if (dst->is_sparse || src->is_sparse)
+	{
+		unsigned cnt = bset_count(dst);
+		bset_union(dst, src);
+		return bset_count(dst) != cnt;
+	}
+
+	d = dst->bitwords;
+	s = src->bitwords;
+	for (i = 0; i < n; i++)
+	{
+		changed |= s[i] & ~d[i];
+		d[i] |= s[i];
+	}
+
+	return changed != 0;
+}
+
 void
 bset_not(bset_set *dst, bset_set *src)
 {
 	unsigned i;
+
 	assert(dst->size == src->size);
-	for (i = 0; i < dst->n_bitwords; i++)
+
+	make_dense(dst);
+
+	if (src->is_sparse)
 	{
-		dst->bitwords[i] = ~src->bitwords[i];
+		for (i = 0; i < dst->n_bitwords; i++)
+		{
+			dst->bitwords[i] = ~(bset_word)0;
+		}
+		for (i = 0; i < src->n_members; i++)
+		{
+			dst->bitwords[BSET_WORD_IDX(src->members[i])] &= ~BSET_BIT(src->members[i]);
+		}
+	}
+	else
+	{
+		for (i = 0; i < dst->n_bitwords; i++)
+		{
+			dst->bitwords[i] = ~src->bitwords[i];
+		}
 	}
+
+	/* Keep bits beyond size cleared */
+	dst->bitwords[dst->n_bitwords - 1] &= BSET_BIT(dst->size) - 1;
 }
 
 unsigned
@@ -160,25 +578,67 @@ bset_count(bset_set *set)
 {
 	unsigned cnt = 0;
 	unsigned i;
-	for (i = 0; i < set->size; i++)
+
+	if (set->is_sparse)
 	{
-		if (bset_has(set, i))
-		{
-			cnt++;
-		}
+		return set->n_members;
+	}
+
+	for (i = 0; i < set->n_bitwords; i++)
+	{
+		cnt += __builtin_popcountll(set->bitwords[i]);
 	}
 	return cnt;
 }
-	
 
+int
+bset_next_set(bset_set *set, int from)
+{
+	unsigned i = BSET_WORD_IDX(from);
+	bset_word w;
 
+	if (from >= (int)set->size)
+	{
+		return -1;
+	}
+
+	if (set->is_sparse)
+	{
+		i = sparse_lower_bound(set, from);
+		return i < set->n_members ? set->members[i] : -1;
+	}
+
+	/* Mask away bits below from in the first word */
+	w = set->bitwords[i] & ~(BSET_BIT(from) - 1);
+
+	while (w == 0)
+	{
+		if (++i == set->n_bitwords)
+		{
+			return -1;
+		}
+		w = set->bitwords[i];
+	}
+
+	return i*BSET_WORD_BITS + __builtin_ctzll(w);
+}
 
 void
 bset_print(FILE *fp, bset_set *set)
 {
 	unsigned i;
+
+	if (set->is_sparse)
+	{
+		for (i = 0; i < set->n_members; i++)
+		{
+			fprintf(fp, "%d ", set->members[i]);
+		}
+		return;
+	}
+
 	for (i = 0; i < set->n_bitwords; i++)
 	{
-		fprintf(fp, "%08x ", set->bitwords[i]);
+		fprintf(fp, "%016llx ", (unsigned long long)set->bitwords[i]);
 	}
 }
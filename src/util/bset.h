@@ -28,12 +28,22 @@
 
 typedef struct bset_set bset_set;
 
+struct arena;
+
 void
 bset_print(FILE *fp, bset_set *set);
 
 bset_set *
 bset_create_set(unsigned size);
 
+bset_set *
+bset_create_arena_set(struct arena *a, unsigned size);
+
+/* Same API but stored as a sorted member array until dense enough to
+   switch to a bitmap, memory scales with the number of members */
+bset_set *
+bset_create_sparse_set(struct arena *a, unsigned size);
+
 void
 bset_clear(bset_set *set);
 
@@ -58,10 +68,23 @@ bset_intersect(bset_set *dst, bset_set *src);
 void
 bset_union(bset_set *dst, bset_set *src);
 
+/* dst = dst & ~src */
+void
+bset_andnot(bset_set *dst, bset_set *src);
+
+/* dst = dst | src, returns non-zero if dst gained any member */
+int
+bset_union_changed(bset_set *dst, bset_set *src);
+
 void
 bset_not(bset_set *dst, bset_set *src);
 
 unsigned
 bset_count(bset_set *set);
 
+/* Returns the smallest member >= from or -1 if there is none. Iterate with
+   for (i = bset_next_set(s, 0); i != -1; i = bset_next_set(s, i + 1)) */
+int
+bset_next_set(bset_set *set, int from);
+
 #endif
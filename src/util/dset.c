@@ -26,52 +26,122 @@
 #include <stdlib.h>
 #include <string.h>
 
-/* TODO:FIXME: Add union by rank and path compression */
+/* Union by rank with path halving. Since the root of a merged set is
+   picked by rank the name of each set is kept separately so that
+   dset_union(x, y) still names the result after y's set. */
 
 struct dset_ctx {
 	int *parent;
 	int *rank;
+	int *name; /* only valid for roots */
 	unsigned size;
+	unsigned room_for;
 };
 
+static void
+grow(dset_ctx *ctx, unsigned size)
+{
+	if (size > ctx->room_for)
+	{
+		/* Grow geometrically so that adding one element at a time is cheap */
+		ctx->room_for = size > 2*ctx->room_for ? size : 2*ctx->room_for;
+		ctx->parent = realloc(ctx->parent, ctx->room_for*sizeof(ctx->parent[0]));
+		ctx->rank = realloc(ctx->rank, ctx->room_for*sizeof(ctx->rank[0]));
+		ctx->name = realloc(ctx->name, ctx->room_for*sizeof(ctx->name[0]));
+	}
+
+	memset(&ctx->parent[ctx->size], -1, (size - ctx->size)*sizeof(ctx->parent[0]));
+	ctx->size = size;
+}
+
 dset_ctx *
 dset_create_universe(unsigned size)
 {
 	dset_ctx *d = calloc(1, sizeof(dset_ctx));
-	d->parent = calloc(size, sizeof(d->parent[0]));
-	d->rank = calloc(size, sizeof(d->rank[0]));
-	memset(d->parent, -1, size*sizeof(d->parent[0]));
-	d->size = size;
+	grow(d, size);
 	return d;
 }
 
+void
+dset_grow_universe(dset_ctx *ctx, unsigned size)
+{
+	unsigned i = ctx->size;
+
+	if (size <= ctx->size)
+	{
+		return;
+	}
+
+	grow(ctx, size);
+	for (; i < size; i++)
+	{
+		dset_makeset(ctx, i);
+	}
+}
+
+void
+dset_destroy_universe(dset_ctx *ctx)
+{
+	free(ctx->parent);
+	free(ctx->rank);
+	free(ctx->name);
+	free(ctx);
+}
+
 void
 dset_makeset(dset_ctx *ctx, int x)
 {
 	assert(x < ctx->size);
 	ctx->parent[x] = x;
+	ctx->rank[x] = 0;
+	ctx->name[x] = x;
 }
 
-int
-dset_find(dset_ctx *ctx, int x)
+static int
+dset_find_root(dset_ctx *ctx, int x)
 {
-	assert(x < ctx->size);
-	if (ctx->parent[x] == x)
-	{
-		return x;
-	}
-	else
+	int *parent = ctx->parent;
+
+	assert(x < ctx->size && parent[x] != -1);
+	while (parent[x] != x)
 	{
-		return dset_find(ctx, ctx->parent[x]);
+		/* Path halving, point x at its grandparent */
+		parent[x] = parent[parent[x]];
+		x = parent[x];
 	}
+
+	return x;
+}
+
+int
+dset_find(dset_ctx *ctx, int x)
+{
+	return ctx->name[dset_find_root(ctx, x)];
 }
 
 void
 dset_union(dset_ctx *ctx, int x, int y)
 {
-	int xroot = dset_find(ctx, x);
-	int yroot = dset_find(ctx, y);
+	int xroot = dset_find_root(ctx, x);
+	int yroot = dset_find_root(ctx, y);
+	int name = ctx->name[yroot];
 
-	ctx->parent[xroot] = yroot;
-}
+	if (xroot == yroot)
+	{
+		return;
+	}
 
+	if (ctx->rank[xroot] > ctx->rank[yroot])
+	{
+		ctx->parent[yroot] = xroot;
+		ctx->name[xroot] = name;
+	}
+	else
+	{
+		ctx->parent[xroot] = yroot;
+		if (ctx->rank[xroot] == ctx->rank[yroot])
+		{
+			ctx->rank[yroot]++;
+		}
+	}
+}
@@ -29,6 +29,14 @@ typedef struct dset_ctx dset_ctx;
 dset_ctx *
 dset_create_universe(unsigned size);
 
+/* Extend the universe to size elements, each new element is put in a
+   set of its own */
+void
+dset_grow_universe(dset_ctx *ctx, unsigned size);
+
+void
+dset_destroy_universe(dset_ctx *ctx);
+
 void
 dset_makeset(dset_ctx *ctx, int x);
 
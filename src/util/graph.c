@@ -22,116 +22,289 @@
  */
 
 #include "graph.h"
+#include "arena.h"
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
+
+static void *
+graph_alloc(graph_ctx *ctx, unsigned size)
+{
+	if (ctx->arena != NULL)
+	{
+		return arena_alloc(ctx->arena, size);
+	}
+	else
+	{
+		return calloc(1, size);
+	}
+}
+
+static void
+graph_free(graph_ctx *ctx, void *p)
+{
+	/* Arena memory is only released when the whole arena is dropped */
+	if (ctx->arena == NULL)
+	{
+		free(p);
+	}
+}
 
 graph_node *
-graph_create_node(unsigned size)
+graph_create_node(graph_ctx *ctx, unsigned size)
 {
+	graph_node *n;
+
 	assert(size >= sizeof(graph_node));
-	return calloc(1, size);
+	ctx->n_nodes++;
+	n = graph_alloc(ctx, size);
+	n->id = ctx->n_ids++;
+	return n;
+}
+
+static graph_edge **
+edge_next(graph_edge *e, int pred)
+{
+	return pred ? &e->pred_next : &e->succ_next;
+}
+
+static graph_edge **
+edge_prev(graph_edge *e, int pred)
+{
+	return pred ? &e->pred_prev : &e->succ_prev;
+}
+
+static graph_edge **
+list_first(graph_node *n, int pred)
+{
+	return pred ? &n->preds : &n->succs;
+}
+
+static unsigned char *
+list_unordered(graph_node *n, int pred)
+{
+	return pred ? &n->preds_unordered : &n->succs_unordered;
 }
 
 static void
-succ_insert_before_ref(graph_edge *edge, graph_edge *ref)
+list_prepend(graph_node *n, graph_edge *e, int pred)
 {
-	if (ref->succ_prev)
+	graph_edge **first = list_first(n, pred);
+
+	*edge_next(e, pred) = *first;
+	if (*first != NULL)
 	{
-		ref->succ_prev->succ_next = edge;
+		*edge_prev(e, pred) = *edge_prev(*first, pred);
+		*edge_prev(*first, pred) = e;
 	}
 	else
 	{
-		ref->tail->succs = edge;
-
+		*edge_prev(e, pred) = e;
 	}
-	edge->succ_prev = ref->succ_prev;
-	edge->succ_next = ref;
-	ref->succ_prev = edge;
+	*first = e;
 }
 
 static void
-pred_insert_before_ref(graph_edge *edge, graph_edge *ref)
+list_append(graph_node *n, graph_edge *e, int pred)
 {
-	if (ref->pred_prev)
+	graph_edge **first = list_first(n, pred);
+
+	*edge_next(e, pred) = NULL;
+	if (*first != NULL)
 	{
-		ref->pred_prev->pred_next = edge;
+		graph_edge *last = *edge_prev(*first, pred);
+		*edge_prev(e, pred) = last;
+		*edge_next(last, pred) = e;
+		*edge_prev(*first, pred) = e;
 	}
 	else
 	{
-		ref->head->preds = edge;
-
+		*edge_prev(e, pred) = e;
+		*first = e;
 	}
-	edge->pred_prev = ref->pred_prev;
-	edge->pred_next = ref;
-	ref->pred_prev = edge;
 }
 
-graph_edge *
-graph_edge_create(graph_ctx *ctx, graph_node *tail, graph_node *head, unsigned size, int (*cmp)(void *, void *))
+static void
+list_unlink(graph_node *n, graph_edge *e, int pred)
 {
-	graph_edge *edge, *tmp, *prev_edge;
+	graph_edge **first = list_first(n, pred);
+	graph_edge *next = *edge_next(e, pred);
+	graph_edge *prev = *edge_prev(e, pred);
 
-	assert(size >= sizeof(graph_edge));
-	edge = calloc(1, size);
+	if (e == *first)
+	{
+		*first = next;
+	}
+	else
+	{
+		assert(*edge_next(prev, pred) == e);
+		*edge_next(prev, pred) = next;
+	}
 
-	ctx->version++;
+	if (next != NULL)
+	{
+		assert(*edge_prev(next, pred) == e);
+		*edge_prev(next, pred) = prev;
+	}
+	else if (*first != NULL)
+	{
+		/* e was last */
+		assert(*edge_prev(*first, pred) == e);
+		*edge_prev(*first, pred) = prev;
+	}
 
-	edge->tail = tail;
-	edge->head = head;
+	/* Nothing left to sort */
+	if (*first == NULL || *edge_next(*first, pred) == NULL)
+	{
+		*list_unordered(n, pred) = 0;
+	}
+}
 
-	/* Insert sorted according to head.id */
-	if (tail->succs)
+static graph_node *
+edge_key(graph_edge *e, int pred)
+{
+	return pred ? e->tail : e->head;
+}
+
+static graph_edge *
+list_merge(graph_edge *a, graph_edge *b, int pred, int (*cmp)(void *, void *))
+{
+	graph_edge *first = NULL;
+	graph_edge **link = &first;
+
+	while (a != NULL && b != NULL)
 	{
-		for (tmp = tail->succs; tmp; tmp = tmp->succ_next)
+		if (cmp(edge_key(a, pred), edge_key(b, pred)) <= 0)
 		{
-			if (cmp == NULL || cmp(head, tmp->head) <= 0)
-			{
-				succ_insert_before_ref(edge, tmp);
-				break;
-			}
-			prev_edge = tmp;
+			*link = a;
+			link = edge_next(a, pred);
+			a = *link;
 		}
-		if (!tmp)
+		else
 		{
-			/* Insert last */
-			assert(prev_edge);
-			edge->succ_prev = prev_edge;
-			prev_edge->succ_next = edge;
+			*link = b;
+			link = edge_next(b, pred);
+			b = *link;
 		}
 	}
-	else
+	*link = a != NULL ? a : b;
+
+	return first;
+}
+
+/* Stable merge sort of the first n edges of a singly linked list */
+static graph_edge *
+list_sort(graph_edge *first, unsigned n, int pred, int (*cmp)(void *, void *))
+{
+	graph_edge *second;
+	unsigned i;
+
+	if (n == 1)
 	{
-		/* First and only edge */
-		tail->succs = edge;
+		*edge_next(first, pred) = NULL;
+		return first;
 	}
 
+	second = first;
+	for (i = 0; i < n / 2; i++)
+	{
+		second = *edge_next(second, pred);
+	}
+
+	first = list_sort(first, n / 2, pred, cmp);
+	second = list_sort(second, n - n / 2, pred, cmp);
+
+	return list_merge(first, second, pred, cmp);
+}
 
-	/* Insert sorted according to tail.id */
-	if (head->preds)
+/* Restore the order graph_edge_create() used to keep eagerly, where an
+   edge went in front of any edges with an equal key. Edges that arrived
+   while the list was unordered were prepended, so they come newest first
+   ahead of the ordered part and a stable sort keeps equal keys newest
+   first too. */
+static void
+list_order(graph_node *n, int pred)
+{
+	graph_edge **first = list_first(n, pred);
+	graph_edge *e, *prev;
+	unsigned n_edges = 0;
+
+	for (e = *first; e != NULL; e = *edge_next(e, pred))
 	{
-		for (tmp = head->preds; tmp; tmp = tmp->pred_next)
-		{
-			if (cmp == NULL || cmp(tail, tmp->tail) <= 0)
-			{
-				pred_insert_before_ref(edge, tmp);
-				break;
-			}
-			prev_edge = tmp;
-		}
-		if (!tmp)
-		{
-			/* Insert last */
-			assert(prev_edge);
-			edge->pred_prev = prev_edge;
-			prev_edge->pred_next = edge;
-		}
+		n_edges++;
+	}
+
+	if (n_edges <= 1)
+	{
+		return;
+	}
+
+	*first = list_sort(*first, n_edges, pred, n->cmp);
+
+	prev = NULL;
+	for (e = *first; e != NULL; e = *edge_next(e, pred))
+	{
+		*edge_prev(e, pred) = prev;
+		prev = e;
+	}
+	*edge_prev(*first, pred) = prev;
+}
+
+/* Add e to a list ordered by cmp. Appending keeps the list ordered if the
+   key is larger than the last one, anything else flags the list and goes
+   in front until it is sorted. */
+static void
+list_insert(graph_node *n, graph_edge *e, int pred, int (*cmp)(void *, void *))
+{
+	graph_edge **first = list_first(n, pred);
+	unsigned char *unordered = list_unordered(n, pred);
+
+	if (!*unordered && *first != NULL &&
+	    cmp(edge_key(e, pred), edge_key(*edge_prev(*first, pred), pred)) <= 0)
+	{
+		*unordered = 1;
+	}
+
+	if (*unordered)
+	{
+		list_prepend(n, e, pred);
 	}
 	else
 	{
-		/* First and only edge */
-		head->preds = edge;
+		list_append(n, e, pred);
 	}
+}
+
+graph_edge *
+graph_edge_create(graph_ctx *ctx, graph_node *tail, graph_node *head, unsigned size, int (*cmp)(void *, void *))
+{
+	graph_edge *edge;
+
+	assert(size >= sizeof(graph_edge));
+	edge = graph_alloc(ctx, size);
+
+	ctx->version++;
+	ctx->n_edges++;
+
+	edge->tail = tail;
+	edge->head = head;
+
+	if (cmp == NULL)
+	{
+		/* Unordered graphs insert first */
+		list_prepend(tail, edge, 0);
+		list_prepend(head, edge, 1);
+		return edge;
+	}
+
+	assert(tail->cmp == NULL || tail->cmp == cmp);
+	assert(head->cmp == NULL || head->cmp == cmp);
+	tail->cmp = cmp;
+	head->cmp = cmp;
+
+	list_insert(tail, edge, 0, cmp);
+	list_insert(head, edge, 1, cmp);
 
 	return edge;
 }
@@ -142,7 +315,8 @@ graph_node_delete(graph_ctx *ctx, graph_node *node)
 	ctx->version++;
 	graph_succs_delete(ctx, node);
 	graph_preds_delete(ctx, node);
-	free(node);
+	ctx->n_nodes--;
+	graph_free(ctx, node);
 }
 
 void
@@ -151,7 +325,8 @@ graph_succs_delete(graph_ctx *ctx, graph_node *node)
 	graph_edge *edge, *next_edge;
 
 	ctx->version++;
-	for (edge = graph_succ_first(node); edge != NULL; edge = next_edge)
+	/* No need to order the list just to delete it */
+	for (edge = node->succs; edge != NULL; edge = next_edge)
 	{
 		next_edge = graph_succ_next(edge);
 		graph_edge_delete(ctx, edge);
@@ -164,7 +339,8 @@ graph_preds_delete(graph_ctx *ctx, graph_node *node)
 	graph_edge *edge, *next_edge;
 
 	ctx->version++;
-	for (edge = graph_pred_first(node); edge != NULL; edge = next_edge)
+	/* No need to order the list just to delete it */
+	for (edge = node->preds; edge != NULL; edge = next_edge)
 	{
 		next_edge = graph_pred_next(edge);
 		graph_edge_delete(ctx, edge);
@@ -175,53 +351,20 @@ void
 graph_edge_delete(graph_ctx *ctx, graph_edge *edge)
 {
 	ctx->version++;
-	if (edge->pred_prev == NULL)
-	{
-		/* First in list */
-		assert(edge->head->preds == edge);
-		edge->head->preds = edge->pred_next;
-	}
-	else
-	{
-		/* Not first in list */
-		assert(edge->head->preds != edge);
-		assert(edge->pred_prev->pred_next = edge);
-		edge->pred_prev->pred_next = edge->pred_next;
-	}
-
-	if (edge->pred_next != NULL)
-	{
-		assert(edge->pred_next->pred_prev == edge);
-		edge->pred_next->pred_prev = edge->pred_prev;
-	}
-
-
-	if (edge->succ_prev == NULL)
-	{
-		/* First in list */
-		assert(edge->tail->succs == edge);
-		edge->tail->succs = edge->succ_next;
-	}
-	else
-	{
-		/* Not first in list */
-		assert(edge->tail->succs != edge);
-		assert(edge->succ_prev->succ_next == edge);
-		edge->succ_prev->succ_next = edge->succ_next;
-	}
-
-	if (edge->succ_next != NULL)
-	{
-		assert(edge->succ_next->succ_prev == edge);
-		edge->succ_next->succ_prev = edge->succ_prev;
-	}
-
-	free(edge);
+	list_unlink(edge->head, edge, 1);
+	list_unlink(edge->tail, edge, 0);
+	ctx->n_edges--;
+	graph_free(ctx, edge);
 }
 
 graph_edge *
 graph_succ_first(graph_node *n)
 {
+	if (n->succs_unordered)
+	{
+		list_order(n, 0);
+		n->succs_unordered = 0;
+	}
 	return n->succs;
 }
 
@@ -234,6 +377,11 @@ graph_succ_next(graph_edge *e)
 graph_edge *
 graph_pred_first(graph_node *n)
 {
+	if (n->preds_unordered)
+	{
+		list_order(n, 1);
+		n->preds_unordered = 0;
+	}
 	return n->preds;
 }
 
@@ -258,34 +406,85 @@ graph_edge_tail(graph_edge *e)
 void
 graph_marker_alloc(graph_ctx *ctx, graph_marker *marker)
 {
-	for (marker->idx = 0; marker->idx < GRAPH_NBR_MARKERS; marker->idx++)
+	graph_marker_table *table = ctx->free_tables;
+
+	if (table != NULL)
 	{
-		if (!ctx->marker_reserv[marker->idx])
-		{
-			ctx->marker_reserv[marker->idx] = 1;
-			marker->pattern = ++ctx->prev_marker;
-			return;
-		}
+		ctx->free_tables = table->next;
 	}
-	assert(0 && "No free node marker found!");
+	else
+	{
+		table = graph_alloc(ctx, sizeof(graph_marker_table));
+		table->ctx = ctx;
+	}
+
+	if (++table->epoch == 0)
+	{
+		/* Wrapped, stale entries could now match */
+		memset(table->epochs, 0, table->n_epochs*sizeof(unsigned));
+		table->epoch = 1;
+	}
+
+	marker->table = table;
+	marker->epoch = table->epoch;
 }
 
 void
 graph_marker_free(graph_ctx *ctx, graph_marker *marker)
 {
-	ctx->marker_reserv[marker->idx] = 0;
+	graph_marker_table *table = marker->table;
+
+	assert(table->ctx == ctx && table->epoch == marker->epoch);
+	table->next = ctx->free_tables;
+	ctx->free_tables = table;
+	marker->table = NULL;
+}
+
+static void
+table_grow(graph_marker_table *table, unsigned id)
+{
+	graph_ctx *ctx = table->ctx;
+	unsigned n_epochs = table->n_epochs*2;
+	unsigned *epochs;
+
+	if (n_epochs < ctx->n_ids)
+	{
+		n_epochs = ctx->n_ids;
+	}
+	if (n_epochs <= id)
+	{
+		n_epochs = id + 1;
+	}
+
+	epochs = graph_alloc(ctx, n_epochs*sizeof(unsigned));
+	if (table->epochs != NULL)
+	{
+		memcpy(epochs, table->epochs, table->n_epochs*sizeof(unsigned));
+		graph_free(ctx, table->epochs);
+	}
+	table->epochs = epochs;
+	table->n_epochs = n_epochs;
 }
 
 int
 graph_marker_set(graph_node *n, graph_marker *marker)
 {
-	int was_set = n->markers[marker->idx] == marker->pattern;
-	n->markers[marker->idx] = marker->pattern;
+	graph_marker_table *table = marker->table;
+	int was_set;
+
+	if (n->id >= table->n_epochs)
+	{
+		table_grow(table, n->id);
+	}
+	was_set = table->epochs[n->id] == marker->epoch;
+	table->epochs[n->id] = marker->epoch;
 	return was_set;
 }
 
 int
 graph_marker_is_set(graph_node *n, graph_marker *marker)
 {
-	return n->markers[marker->idx] == marker->pattern;
+	graph_marker_table *table = marker->table;
+
+	return n->id < table->n_epochs && table->epochs[n->id] == marker->epoch;
 }
@@ -24,19 +24,27 @@
 #ifndef GRAPH_H
 #define GRAPH_H
 
-#define GRAPH_NBR_MARKERS 2
-#define GRAPH_MARKER_MAX (1 << 15)
-
 typedef struct graph_ctx {
-	unsigned marker_reserv[GRAPH_NBR_MARKERS];
-	unsigned prev_marker;
 	unsigned version; /* bumped each time the graph is modifed */
+	struct arena *arena; /* if set nodes and edges are allocated here */
+	unsigned n_nodes; /* live nodes and edges */
+	unsigned n_edges;
+	unsigned n_ids; /* node ids handed out, never reused */
+	struct graph_marker_table *free_tables;
 } graph_ctx;
 
+/* Edges are added to the pred and succ lists in O(1). A list stays
+   ordered by the cmp callback as long as edges arrive in order. Otherwise
+   it is flagged, further edges go in front, and it is sorted the next time
+   it is walked from the start. The prev link of the first edge in a list
+   points at the last one. */
 typedef struct graph_node {
 	struct graph_edge *preds;
 	struct graph_edge *succs;
-	unsigned short markers[GRAPH_NBR_MARKERS];
+	int (*cmp)(void *, void *); /* to sort lists flagged as unordered */
+	unsigned id; /* dense within the graph_ctx */
+	unsigned char preds_unordered;
+	unsigned char succs_unordered;
 } graph_node;
 
 typedef struct graph_edge {
@@ -48,13 +56,26 @@ typedef struct graph_edge {
 	struct graph_edge *succ_next;
 } graph_edge;
 
+/* A marker is an epoch in a side table indexed by node id. Any number
+   of markers can be live at once, each holding a table of its own. Freed
+   tables are kept in the graph_ctx and reused with the next epoch, they
+   are only cleared when the 32 bit epoch wraps. Tables come from the
+   graph arena like nodes and edges do. */
+typedef struct graph_marker_table {
+	struct graph_marker_table *next;
+	graph_ctx *ctx;
+	unsigned *epochs;
+	unsigned n_epochs;
+	unsigned epoch;
+} graph_marker_table;
+
 typedef struct graph_marker {
-	unsigned char idx;
-	unsigned short pattern;
+	graph_marker_table *table;
+	unsigned epoch;
 } graph_marker;
 
 graph_node *
-graph_create_node(unsigned size);
+graph_create_node(graph_ctx *ctx, unsigned size);
 
 graph_edge *
 graph_edge_create(graph_ctx *ctx, graph_node *tail, graph_node *head, unsigned size, int (*cmp)(void *, void *));
@@ -0,0 +1,239 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "util/graph_dom.h"
+#include "util/graph.h"
+#include <assert.h>
+#include <stdlib.h>
+
+#define NONE ((unsigned)-1)
+
+/* Scratch state of the algorithm, everything indexed by dfs number */
+typedef struct dom_state {
+	unsigned n;
+	graph_node **vertex;
+	unsigned *parent;
+	unsigned *semi;
+	unsigned *label;
+	unsigned *ancestor;
+	unsigned *idom;
+	unsigned *stack;
+} dom_state;
+
+/* Iterative depth first search numbering the nodes in pre-order */
+static void
+dfs(graph_node *start, unsigned n_nodes, graph_marker *marker, dom_state *s, graph_dom_get_info get_info)
+{
+	graph_edge **edges = malloc(n_nodes*sizeof(graph_edge *));
+	unsigned depth = 0;
+
+	graph_marker_set(start, marker);
+	get_info(start)->dfs = 0;
+	s->vertex[0] = start;
+	s->parent[0] = NONE;
+	s->stack[depth] = 0;
+	edges[depth++] = graph_succ_first(start);
+	s->n = 1;
+
+	while (depth > 0)
+	{
+		graph_edge *edge = edges[depth-1];
+		graph_node *succ;
+
+		if (edge == NULL)
+		{
+			depth--;
+			continue;
+		}
+
+		edges[depth-1] = graph_succ_next(edge);
+		succ = graph_edge_head(edge);
+		if (!graph_marker_set(succ, marker))
+		{
+			assert(s->n < n_nodes);
+			get_info(succ)->dfs = s->n;
+			s->vertex[s->n] = succ;
+			s->parent[s->n] = s->stack[depth-1];
+			s->stack[depth] = s->n++;
+			edges[depth++] = graph_succ_first(succ);
+		}
+	}
+
+	free(edges);
+}
+
+/* Path compression over the linked forest, iterative to bound stack use */
+static unsigned
+eval(dom_state *s, unsigned v)
+{
+	unsigned sp = 0;
+	unsigned x;
+
+	if (s->ancestor[v] == NONE)
+	{
+		return v;
+	}
+
+	for (x = v; s->ancestor[s->ancestor[x]] != NONE; x = s->ancestor[x])
+	{
+		s->stack[sp++] = x;
+	}
+
+	while (sp > 0)
+	{
+		unsigned a;
+		x = s->stack[--sp];
+		a = s->ancestor[x];
+		if (s->semi[s->label[a]] < s->semi[s->label[x]])
+		{
+			s->label[x] = s->label[a];
+		}
+		s->ancestor[x] = s->ancestor[a];
+	}
+
+	return s->label[v];
+}
+
+static void
+number_domtree(dom_state *s, graph_dom_get_info get_info)
+{
+	unsigned *first_child = s->semi; /* semi and label are no longer needed */
+	unsigned *next_sibling = s->label;
+	unsigned pre = 0, post = 0, sp = 0;
+	unsigned v;
+
+	for (v = 0; v < s->n; v++)
+	{
+		first_child[v] = NONE;
+	}
+
+	for (v = s->n; v-- > 1;)
+	{
+		next_sibling[v] = first_child[s->idom[v]];
+		first_child[s->idom[v]] = v;
+	}
+
+	/* first_child doubles as the iterator over each node's children */
+	s->stack[sp++] = 0;
+	get_info(s->vertex[0])->pre = pre++;
+	while (sp > 0)
+	{
+		unsigned u = s->stack[sp-1];
+		unsigned c = first_child[u];
+
+		if (c == NONE)
+		{
+			get_info(s->vertex[u])->post = post++;
+			sp--;
+			continue;
+		}
+
+		first_child[u] = next_sibling[c];
+		get_info(s->vertex[c])->pre = pre++;
+		s->stack[sp++] = c;
+	}
+}
+
+void
+graph_dom_analyze(graph_ctx *gctx, graph_node *start, unsigned n_nodes, graph_dom_get_info get_info)
+{
+	graph_marker marker;
+	dom_state s;
+	unsigned *mem = malloc(6*n_nodes*sizeof(unsigned));
+	unsigned v, w;
+
+	s.vertex = malloc(n_nodes*sizeof(graph_node *));
+	s.parent = mem;
+	s.semi = mem + n_nodes;
+	s.label = mem + 2*n_nodes;
+	s.ancestor = mem + 3*n_nodes;
+	s.idom = mem + 4*n_nodes;
+	s.stack = mem + 5*n_nodes;
+
+	graph_marker_alloc(gctx, &marker);
+	dfs(start, n_nodes, &marker, &s, get_info);
+
+	for (v = 0; v < s.n; v++)
+	{
+		s.semi[v] = v;
+		s.label[v] = v;
+		s.ancestor[v] = NONE;
+	}
+
+	/* Semidominators, in reverse dfs order */
+	for (w = s.n; w-- > 1;)
+	{
+		graph_edge *edge;
+
+		for (edge = graph_pred_first(s.vertex[w]); edge != NULL; edge = graph_pred_next(edge))
+		{
+			graph_node *p = graph_edge_tail(edge);
+			unsigned u;
+
+			if (!graph_marker_is_set(p, &marker))
+			{
+				/* unreachable predecessor */
+				continue;
+			}
+
+			u = eval(&s, get_info(p)->dfs);
+			if (s.semi[u] < s.semi[w])
+			{
+				s.semi[w] = s.semi[u];
+			}
+		}
+
+		s.ancestor[w] = s.parent[w];
+	}
+
+	/* Immediate dominator is the nearest common ancestor of the parent and
+	   the semidominator, in increasing dfs order so idom[idom[w]] is final */
+	s.idom[0] = 0;
+	for (w = 1; w < s.n; w++)
+	{
+		unsigned d = s.parent[w];
+		while (d > s.semi[w])
+		{
+			d = s.idom[d];
+		}
+		s.idom[w] = d;
+	}
+
+	graph_marker_free(gctx, &marker);
+
+	for (w = 0; w < s.n; w++)
+	{
+		get_info(s.vertex[w])->idom = w == 0 ? NULL : s.vertex[s.idom[w]];
+	}
+
+	number_domtree(&s, get_info);
+
+	free(s.vertex);
+	free(mem);
+}
+
+int
+graph_dom_dominates(const graph_dom_info *a, const graph_dom_info *b)
+{
+	return a->pre <= b->pre && b->post <= a->post;
+}
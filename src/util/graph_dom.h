@@ -0,0 +1,48 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef GRAPH_DOM_H
+#define GRAPH_DOM_H
+
+#include "util/graph.h"
+
+typedef struct graph_dom_info {
+	graph_node *idom; /* NULL for the start node */
+	unsigned dfs; /* depth first pre-order number in the graph */
+	unsigned pre; /* pre-order number in the dominator tree */
+	unsigned post; /* post-order number in the dominator tree */
+} graph_dom_info;
+
+typedef graph_dom_info *(*graph_dom_get_info)(graph_node *);
+
+/* Compute immediate dominators of all nodes reachable from start with the
+   Semi-NCA algorithm and number the resulting dominator tree. n_nodes is an
+   upper bound on the number of reachable nodes. */
+void
+graph_dom_analyze(graph_ctx *gctx, graph_node *start, unsigned n_nodes, graph_dom_get_info get_info);
+
+/* Does a dominate b (reflexive), constant time once analyzed */
+int
+graph_dom_dominates(const graph_dom_info *a, const graph_dom_info *b);
+
+#endif
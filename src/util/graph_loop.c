@@ -188,4 +188,6 @@ graph_loop_analyze(graph_ctx *gctx,
 
 		graph_marker_free(gctx, &pmarker);
 	}
+
+	dset_destroy_universe(dset);
 }
@@ -0,0 +1,59 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "util/pool.h"
+#include "util/arena.h"
+#include <assert.h>
+#include <string.h>
+
+void
+pool_init(pool *p, struct arena *a, unsigned size)
+{
+	/* Free objects are linked through their first word */
+	assert(size >= sizeof(void *));
+	p->arena = a;
+	p->size = size;
+	p->free_list = NULL;
+}
+
+void *
+pool_alloc(pool *p)
+{
+	void *obj = p->free_list;
+
+	if (obj != NULL)
+	{
+		p->free_list = *(void **)obj;
+		memset(obj, 0, p->size);
+		return obj;
+	}
+
+	return arena_alloc(p->arena, p->size);
+}
+
+void
+pool_free(pool *p, void *obj)
+{
+	*(void **)obj = p->free_list;
+	p->free_list = obj;
+}
@@ -0,0 +1,47 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+/* Fixed size object pool on top of an arena. Freed objects are kept on a
+   free list and handed out again by pool_alloc(). */
+
+struct arena;
+
+typedef struct pool {
+	struct arena *arena;
+	unsigned size;
+	void *free_list;
+} pool;
+
+void
+pool_init(pool *p, struct arena *a, unsigned size);
+
+void *
+pool_alloc(pool *p);
+
+void
+pool_free(pool *p, void *obj);
+
+#endif
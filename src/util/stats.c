@@ -0,0 +1,343 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "util/stats.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#define STATS_MAX_DEPTH 16
+
+typedef struct stats_record {
+	const char *name; /* phase or counter */
+	char *func;
+	double wall;
+	double cpu;
+	unsigned long value; /* calls for phases */
+} stats_record;
+
+typedef struct stats_table {
+	stats_record *records;
+	unsigned n_records;
+	unsigned n_room_for;
+} stats_table;
+
+/* Shared between threads, everything but what and format is guarded by
+   lock */
+static struct {
+	unsigned what;
+	stats_format format;
+	pthread_mutex_t lock;
+	FILE *trace;
+	unsigned n_trace_events;
+	double origin; /* trace timestamps are relative to this */
+	unsigned n_threads_seen;
+	stats_table phases;
+	stats_table counters;
+} stats = {0, STATS_FORMAT_TABLE, PTHREAD_MUTEX_INITIALIZER};
+
+typedef struct stats_frame {
+	const char *phase;
+	const char *func;
+	double wall;
+	double cpu;
+} stats_frame;
+
+/* Phases nest per thread */
+static __thread struct {
+	stats_frame stack[STATS_MAX_DEPTH];
+	unsigned depth;
+	unsigned tid; /* trace thread id, 0 until first used */
+} thread_stats;
+
+static double
+now(clockid_t clock)
+{
+	struct timespec ts;
+	clock_gettime(clock, &ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+/* Linear lookup, the number of distinct phases times functions is small
+   compared to the work being measured. */
+static stats_record *
+lookup(stats_table *t, const char *name, const char *func)
+{
+	stats_record *r;
+	unsigned i;
+
+	for (i = 0; i < t->n_records; i++)
+	{
+		r = &t->records[i];
+		if (!strcmp(r->name, name) &&
+		    (r->func == func || (r->func != NULL && func != NULL && !strcmp(r->func, func))))
+		{
+			return r;
+		}
+	}
+
+	if (t->n_records == t->n_room_for)
+	{
+		t->n_room_for = t->n_room_for ? t->n_room_for*2 : 64;
+		t->records = realloc(t->records, t->n_room_for*sizeof(stats_record));
+	}
+
+	r = &t->records[t->n_records++];
+	memset(r, 0, sizeof(*r));
+	r->name = name;
+	r->func = func != NULL ? strdup(func) : NULL;
+	return r;
+}
+
+void
+stats_enable(unsigned what, stats_format format)
+{
+	stats.what |= what;
+	if (format == STATS_FORMAT_JSON)
+	{
+		stats.format = format;
+	}
+}
+
+unsigned
+stats_enabled(void)
+{
+	return stats.what;
+}
+
+void
+stats_phase_begin(const char *phase, const char *func)
+{
+	stats_frame *frame;
+
+	if (!(stats.what & (STATS_TIME | STATS_TRACE)))
+	{
+		return;
+	}
+
+	assert(thread_stats.depth < STATS_MAX_DEPTH);
+	frame = &thread_stats.stack[thread_stats.depth++];
+	frame->phase = phase;
+	frame->func = func;
+	frame->wall = now(CLOCK_MONOTONIC);
+	frame->cpu = now(CLOCK_THREAD_CPUTIME_ID);
+}
+
+void
+stats_phase_end(void)
+{
+	stats_frame *frame;
+	double wall, cpu;
+	stats_record *r;
+
+	if (!(stats.what & (STATS_TIME | STATS_TRACE)))
+	{
+		return;
+	}
+
+	wall = now(CLOCK_MONOTONIC);
+	cpu = now(CLOCK_THREAD_CPUTIME_ID);
+
+	assert(thread_stats.depth > 0);
+	frame = &thread_stats.stack[--thread_stats.depth];
+
+	pthread_mutex_lock(&stats.lock);
+	if (stats.trace != NULL)
+	{
+		if (thread_stats.tid == 0)
+		{
+			thread_stats.tid = ++stats.n_threads_seen;
+		}
+
+		/* Complete events, timestamps in microseconds */
+		fprintf(stats.trace, "%s\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", "
+		        "\"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %u",
+		        stats.n_trace_events++ ? "," : "",
+		        frame->phase,
+		        frame->func != NULL ? "function" : "phase",
+		        (frame->wall - stats.origin)*1e6,
+		        (wall - frame->wall)*1e6,
+		        thread_stats.tid);
+		if (frame->func != NULL)
+		{
+			fprintf(stats.trace, ", \"args\": {\"function\": \"%s\"}", frame->func);
+		}
+		fprintf(stats.trace, "}");
+	}
+
+	if (stats.what & STATS_TIME)
+	{
+		r = lookup(&stats.phases, frame->phase, frame->func);
+		r->wall += wall - frame->wall;
+		r->cpu += cpu - frame->cpu;
+		r->value++;
+	}
+	pthread_mutex_unlock(&stats.lock);
+}
+
+void
+stats_count(const char *counter, const char *func, unsigned long value)
+{
+	if (!(stats.what & STATS_MEM))
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&stats.lock);
+	lookup(&stats.counters, counter, func)->value += value;
+	pthread_mutex_unlock(&stats.lock);
+}
+
+static void
+report_table(FILE *out, long peak_rss_kb)
+{
+	unsigned i;
+
+	if (stats.what & STATS_TIME)
+	{
+		fprintf(out, "%-24s %-24s %12s %12s %8s\n", "phase", "function", "wall (ms)", "cpu (ms)", "calls");
+		for (i = 0; i < stats.phases.n_records; i++)
+		{
+			stats_record *r = &stats.phases.records[i];
+			fprintf(out, "%-24s %-24s %12.3f %12.3f %8lu\n", r->name, r->func ? r->func : "-",
+			        r->wall*1e3, r->cpu*1e3, r->value);
+		}
+	}
+
+	if (stats.what & STATS_MEM)
+	{
+		if (stats.what & STATS_TIME)
+		{
+			fprintf(out, "\n");
+		}
+		fprintf(out, "%-24s %-24s %12s\n", "counter", "function", "value");
+		for (i = 0; i < stats.counters.n_records; i++)
+		{
+			stats_record *r = &stats.counters.records[i];
+			fprintf(out, "%-24s %-24s %12lu\n", r->name, r->func ? r->func : "-", r->value);
+		}
+		fprintf(out, "%-24s %-24s %12ld\n", "peak_rss_kb", "-", peak_rss_kb);
+	}
+}
+
+static void
+report_json_func(FILE *out, const char *func)
+{
+	if (func != NULL)
+	{
+		fprintf(out, "\"%s\"", func);
+	}
+	else
+	{
+		fprintf(out, "null");
+	}
+}
+
+static void
+report_json(FILE *out, long peak_rss_kb)
+{
+	unsigned i;
+
+	fprintf(out, "{\n");
+	if (stats.what & STATS_TIME)
+	{
+		fprintf(out, "  \"phases\": [");
+		for (i = 0; i < stats.phases.n_records; i++)
+		{
+			stats_record *r = &stats.phases.records[i];
+			fprintf(out, "%s\n    {\"phase\": \"%s\", \"function\": ", i ? "," : "", r->name);
+			report_json_func(out, r->func);
+			fprintf(out, ", \"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"calls\": %lu}",
+			        r->wall*1e3, r->cpu*1e3, r->value);
+		}
+		fprintf(out, "\n  ]%s\n", (stats.what & STATS_MEM) ? "," : "");
+	}
+
+	if (stats.what & STATS_MEM)
+	{
+		fprintf(out, "  \"counters\": [");
+		for (i = 0; i < stats.counters.n_records; i++)
+		{
+			stats_record *r = &stats.counters.records[i];
+			fprintf(out, "%s\n    {\"counter\": \"%s\", \"function\": ", i ? "," : "", r->name);
+			report_json_func(out, r->func);
+			fprintf(out, ", \"value\": %lu}", r->value);
+		}
+		fprintf(out, "\n  ],\n  \"peak_rss_kb\": %ld\n", peak_rss_kb);
+	}
+	fprintf(out, "}\n");
+}
+
+void
+stats_report(FILE *out)
+{
+	struct rusage usage;
+
+	if (!(stats.what & (STATS_TIME | STATS_MEM)))
+	{
+		return;
+	}
+
+	getrusage(RUSAGE_SELF, &usage);
+	if (stats.format == STATS_FORMAT_JSON)
+	{
+		report_json(out, usage.ru_maxrss);
+	}
+	else
+	{
+		report_table(out, usage.ru_maxrss);
+	}
+}
+
+int
+stats_trace_open(const char *path)
+{
+	assert(stats.trace == NULL);
+	if ((stats.trace = fopen(path, "w")) == NULL)
+	{
+		return 0;
+	}
+
+	stats.what |= STATS_TRACE;
+	stats.origin = now(CLOCK_MONOTONIC);
+	fprintf(stats.trace, "{\"traceEvents\": [");
+	return 1;
+}
+
+void
+stats_trace_close(void)
+{
+	if (stats.trace == NULL)
+	{
+		return;
+	}
+
+	assert(thread_stats.depth == 0);
+	fprintf(stats.trace, "\n]}\n");
+	fclose(stats.trace);
+	stats.trace = NULL;
+	stats.what &= ~STATS_TRACE;
+}
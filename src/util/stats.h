@@ -0,0 +1,71 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+
+/* Compile time and memory statistics. Phases are timed between
+   stats_phase_begin() and stats_phase_end(), optionally per function,
+   and named counters are summed per function. Phases can also be
+   written as Chrome trace events (chrome://tracing or Perfetto) as they
+   complete. Everything is a no-op until enabled with stats_enable() or
+   stats_trace_open(). */
+
+typedef enum stats_format {
+	STATS_FORMAT_TABLE,
+	STATS_FORMAT_JSON
+} stats_format;
+
+#define STATS_TIME 1
+#define STATS_MEM 2
+#define STATS_TRACE 4
+
+void
+stats_enable(unsigned what, stats_format format);
+
+unsigned
+stats_enabled(void);
+
+/* func may be NULL for phases that are not per function. Phases nest. */
+void
+stats_phase_begin(const char *phase, const char *func);
+
+void
+stats_phase_end(void);
+
+void
+stats_count(const char *counter, const char *func, unsigned long value);
+
+void
+stats_report(FILE *out);
+
+/* Returns zero if path could not be opened */
+int
+stats_trace_open(const char *path);
+
+void
+stats_trace_close(void);
+
+#endif
@@ -0,0 +1,168 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "util/thread_pool.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+/* Owner takes from the head, thieves take from the tail. Both ends are
+   guarded by the same lock, contention is low since stealing only
+   happens once a thread has run out of work. */
+typedef struct deque {
+	pthread_mutex_t lock;
+	unsigned *idxs;
+	unsigned head;
+	unsigned tail;
+} deque;
+
+typedef struct pool {
+	void **items;
+	thread_pool_fn fn;
+	void *user;
+	deque *deques;
+	unsigned n_threads;
+} pool;
+
+typedef struct worker {
+	pool *p;
+	unsigned idx;
+} worker;
+
+static int
+take(deque *d, int steal, unsigned *idx)
+{
+	int found = 0;
+
+	pthread_mutex_lock(&d->lock);
+	if (d->head < d->tail)
+	{
+		*idx = steal ? d->idxs[--d->tail] : d->idxs[d->head++];
+		found = 1;
+	}
+	pthread_mutex_unlock(&d->lock);
+
+	return found;
+}
+
+static void *
+worker_main(void *arg)
+{
+	worker *w = arg;
+	pool *p = w->p;
+	unsigned idx;
+
+	for (;;)
+	{
+		unsigned i;
+
+		if (take(&p->deques[w->idx], 0, &idx))
+		{
+			p->fn(p->items[idx], w->idx, p->user);
+			continue;
+		}
+
+		/* Nothing new is ever queued, so once every deque has been
+		   found empty we are done */
+		for (i = 1; i < p->n_threads; i++)
+		{
+			if (take(&p->deques[(w->idx + i) % p->n_threads], 1, &idx))
+			{
+				break;
+			}
+		}
+		if (i == p->n_threads)
+		{
+			break;
+		}
+		p->fn(p->items[idx], w->idx, p->user);
+	}
+
+	return NULL;
+}
+
+void
+thread_pool_run(unsigned n_threads, void **items, unsigned n_items,
+                thread_pool_fn fn, void *user)
+{
+	pthread_t *threads;
+	worker *workers;
+	unsigned *idxs;
+	pool p;
+	unsigned i, t;
+
+	n_threads = n_threads < 1 ? 1 : n_threads;
+	n_threads = n_threads > n_items && n_items > 0 ? n_items : n_threads;
+
+	p.items = items;
+	p.fn = fn;
+	p.user = user;
+	p.n_threads = n_threads;
+	p.deques = calloc(n_threads, sizeof(deque));
+	threads = calloc(n_threads, sizeof(pthread_t));
+	workers = calloc(n_threads, sizeof(worker));
+	idxs = calloc(n_items + 1, sizeof(unsigned));
+
+	/* Contiguous slices keep neighbouring items on the same thread */
+	for (t = 0, i = 0; t < n_threads; t++)
+	{
+		deque *d = &p.deques[t];
+		unsigned n = n_items/n_threads + (t < n_items % n_threads);
+
+		pthread_mutex_init(&d->lock, NULL);
+		d->idxs = &idxs[i];
+		d->head = 0;
+		d->tail = n;
+		for (; n > 0; n--, i++)
+		{
+			idxs[i] = i;
+		}
+	}
+	assert(i == n_items);
+
+	for (t = 0; t < n_threads; t++)
+	{
+		workers[t].p = &p;
+		workers[t].idx = t;
+		if (t > 0)
+		{
+			pthread_create(&threads[t], NULL, worker_main, &workers[t]);
+		}
+	}
+
+	worker_main(&workers[0]);
+
+	for (t = 1; t < n_threads; t++)
+	{
+		pthread_join(threads[t], NULL);
+	}
+
+	for (t = 0; t < n_threads; t++)
+	{
+		pthread_mutex_destroy(&p.deques[t].lock);
+	}
+	free(idxs);
+	free(workers);
+	free(threads);
+	free(p.deques);
+}
@@ -0,0 +1,38 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+/* Run fn on each of n_items items using n_threads threads, the calling
+   thread included. Items are dealt out to per thread deques up front and
+   a thread that runs dry steals from the others, so that a few expensive
+   items do not serialize the rest. Returns when all items are done. */
+
+typedef void (*thread_pool_fn)(void *item, unsigned thread_idx, void *user);
+
+void
+thread_pool_run(unsigned n_threads, void **items, unsigned n_items,
+                thread_pool_fn fn, void *user);
+
+#endif
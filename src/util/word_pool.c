@@ -0,0 +1,140 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "util/word_pool.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+void
+word_pool_init(word_pool *pool)
+{
+	unsigned i;
+
+	pool->words_room = 256;
+	pool->words = malloc(pool->words_room * sizeof(*pool->words));
+	pool->n_words = 1;
+	for (i = 0; i < WORD_POOL_CLASSES; i++)
+	{
+		pool->free_words[i] = 0;
+	}
+}
+
+void
+word_pool_destroy(word_pool *pool)
+{
+	free(pool->words);
+	pool->words = NULL;
+}
+
+unsigned
+word_pool_room(unsigned n)
+{
+	unsigned room = 4;
+
+	while (room < n)
+	{
+		room *= 2;
+	}
+
+	return room;
+}
+
+static unsigned
+size_class(unsigned n_words)
+{
+	unsigned class = 0;
+
+	while ((4u << class) < n_words)
+	{
+		class++;
+	}
+
+	assert(class < WORD_POOL_CLASSES);
+	return class;
+}
+
+/* Hand out n_words at the end of the pool */
+static void
+reserve(word_pool *pool, unsigned n_words)
+{
+	if (pool->n_words + n_words > pool->words_room)
+	{
+		while (pool->n_words + n_words > pool->words_room)
+		{
+			pool->words_room *= 2;
+		}
+		pool->words = realloc(pool->words, pool->words_room * sizeof(*pool->words));
+	}
+	pool->n_words += n_words;
+}
+
+unsigned
+word_pool_alloc(word_pool *pool, unsigned n_words)
+{
+	unsigned class = size_class(n_words);
+	unsigned words = pool->free_words[class];
+
+	if (words != 0)
+	{
+		pool->free_words[class] = pool->words[words];
+		return words;
+	}
+
+	words = pool->n_words;
+	reserve(pool, 4u << class);
+	return words;
+}
+
+void
+word_pool_free(word_pool *pool, unsigned words, unsigned n_words)
+{
+	unsigned class = size_class(n_words);
+
+	pool->words[words] = pool->free_words[class];
+	pool->free_words[class] = words;
+}
+
+unsigned
+word_pool_realloc(word_pool *pool, unsigned words, unsigned n_words, unsigned new_n_words)
+{
+	unsigned room = 4u << size_class(n_words);
+	unsigned new_room = 4u << size_class(new_n_words);
+	unsigned new_words;
+
+	if (new_room <= room)
+	{
+		return words;
+	}
+
+	if (words + room == pool->n_words)
+	{
+		reserve(pool, new_room - room);
+		return words;
+	}
+
+	new_words = word_pool_alloc(pool, new_n_words);
+	memcpy(pool->words + new_words, pool->words + words, room * sizeof(*pool->words));
+	word_pool_free(pool, words, n_words);
+	return new_words;
+}
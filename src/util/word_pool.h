@@ -0,0 +1,69 @@
+/*
+ * MyCC - A lightweight C compiler and experimentation platform
+ *
+ * Copyright (C) 2018 Markus Lavin (https://www.zzzconsulting.se/)
+ *
+ * All rights reserved.
+ *
+ * This file is part of MyCC.
+ *
+ * MyCC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MyCC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MyCC. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef WORD_POOL_H
+#define WORD_POOL_H
+
+/* Arrays of 32-bit words that are addressed by index rather than by
+   pointer, so that they can be referred to from 32-bit fields. All arrays
+   live in one buffer that is grown with realloc(), which means a pointer
+   into the pool is only valid until the next word_pool_alloc(). Word 0 is
+   never handed out and can stand for no array.
+
+   Arrays are sized as powers of two of at least four words. Freed arrays
+   are kept on per size class lists linked through their first word and
+   handed out again. */
+
+#define WORD_POOL_CLASSES 28
+
+typedef struct word_pool {
+	unsigned *words;
+	unsigned n_words; /* handed out, word 0 included */
+	unsigned words_room;
+	unsigned free_words[WORD_POOL_CLASSES];
+} word_pool;
+
+void
+word_pool_init(word_pool *pool);
+
+void
+word_pool_destroy(word_pool *pool);
+
+/* Size an array needs to be allocated with to hold n words */
+unsigned
+word_pool_room(unsigned n);
+
+unsigned
+word_pool_alloc(word_pool *pool, unsigned n_words);
+
+/* n_words is the size the array was allocated with */
+void
+word_pool_free(word_pool *pool, unsigned words, unsigned n_words);
+
+/* Move an array of n_words to one of new_n_words and return it. The last
+   array handed out grows in place, which keeps a single long list from
+   leaving a trail of freed arrays behind. */
+unsigned
+word_pool_realloc(word_pool *pool, unsigned words, unsigned n_words, unsigned new_n_words);
+
+#endif
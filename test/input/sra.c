@@ -0,0 +1,60 @@
+int dot3(int x, int y)
+{
+	int a[3];
+	int b[3];
+	int s;
+	int i;
+
+	a[0] = x; a[1] = x + 1; a[2] = x + 2;
+	b[0] = y; b[1] = y*2; b[2] = y*3;
+
+	s = 0;
+	for (i = 0; i < 3; i++)
+	{
+		s = s + a[i]*b[i];
+	}
+
+	return s;
+}
+
+int fib3(int n)
+{
+	int f[3];
+	int i;
+
+	f[0] = 0;
+	f[1] = 1;
+	for (i = 0; i < n; i++)
+	{
+		f[2] = f[0] + f[1];
+		f[0] = f[1];
+		f[1] = f[2];
+	}
+
+	return f[0];
+}
+
+int bytes(int x)
+{
+	char c[4];
+	short h[2];
+
+	c[0] = x;
+	c[3] = x + 3;
+	h[1] = c[0] + c[3];
+	if (x > 2)
+	{
+		h[0] = 7;
+	}
+	else
+	{
+		h[0] = c[3];
+	}
+
+	return h[0]*100 + h[1];
+}
+
+int run_test(void)
+{
+	return dot3(1, 4) + fib3(10)*1000 + bytes(1)*10000;
+}
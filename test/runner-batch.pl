@@ -0,0 +1,70 @@
+#!/usr/bin/perl -w
+
+$total = 0;
+$passed = 0;
+$max_regs = 0;
+
+if (@ARGV) {
+	@inputs = @ARGV;
+} else {
+	@inputs = glob("input/*.c");
+}
+
+# Compile all inputs in one process, with the inputs listed in a response
+# file that is followed by more arguments, and compare against compiling
+# each input on its own. The trailing arguments are repeated so that they
+# outnumber the words of the response file, which once overran the
+# expanded argument vector.
+sub compare_all {
+	foreach $input (@inputs) {
+		if (0 != system("diff $input.s $input.single > /dev/null")) {
+			print "failed [$input]\n";
+			return 0;
+		}
+	}
+	print "success\n";
+	return 1;
+}
+
+foreach $max_regs (4..8) {
+	print "\nTest is batch (--cg-max-regs=$max_regs)\n";
+	$total = $total + 1;
+
+	print "  Compiling inputs one by one...";
+	$failed = 0;
+	foreach $input (@inputs) {
+		if (0 != system("../build/driver $input --cg-max-regs=$max_regs > /dev/null 2> /dev/null") or
+		    0 != system("mv $input.s $input.single")) {
+			$failed = 1;
+			last;
+		}
+	}
+	if ($failed) {
+		print "failed\n";
+		next;
+	}
+	print "success\n";
+
+	open(F, "> batch.rsp");
+	print F join("\n", "--cg-max-regs=$max_regs", @inputs) . "\n";
+	close(F);
+
+	$trailing = join(" ", ("-j 3") x 32);
+	print "  Compiling \@batch.rsp -j 3...";
+	unlink(map { "$_.s" } @inputs);
+	if (0 == system("../build/driver \@batch.rsp $trailing > /dev/null 2> /dev/null")) {
+		print "success\n";
+	} else {
+		print "failed\n";
+		next;
+	}
+
+	print "  Comparing assembly...";
+	if (!compare_all()) {
+		next;
+	}
+
+	$passed = $passed + 1;
+}
+
+print "\n---\nPassed ($passed/$total)\n";